@@ -93,7 +93,6 @@ static void rb_clear_buffers(ROCKBLOCK_t *rb) {
     rb->tx.last_ptr = rb->tx.buff;
     rb->rx.cur_ptr = rb->rx.buff;
     rb->rx.last_ptr = rb->rx.buff;
-    rb->tx.tx_ptr = rb->tx.buff;
 }
 
 
@@ -116,9 +115,8 @@ static bool rb_use_uart(ROCKBLOCK_t *rb) {
     uint16_t totalLen = rb->tx.last_ptr - rb->tx.buff + 1; // length
     rb->rx.finished = false;
 
-    uartSendDataInt(&USCI_A1_cnf, (unsigned char*)rb->tx.buff, totalLen);
-
-    if(xSemaphoreTake(rb->tx.txSemaphore, 20000 / portTICK_RATE_MS) == pdFALSE) {
+    // send the whole command with one DMA transfer and sleep until it is done
+    if(uartSendDataTask(&USCI_A1_cnf, (const unsigned char*)rb->tx.buff, totalLen, 20000 / portTICK_RATE_MS) != UART_SUCCESS) {
         xSemaphoreGive(rb->busy_semaphore);
         return false;
     }
@@ -180,9 +178,10 @@ void task_rockblock(void) {
     uint8_t i = 0;
 
     int32_t pressure, humidity, hTemp, pTemp;
-    int32_t altitude;
-    gnss_time_t time;
-    gnss_coordinate_pair_t location;
+    gnss_fix_t fix;
+    gnss_utc_t now;
+    bool fix_valid;
+    bool time_valid;
     bool success[7];
 
     for(i = 0; i < 7; i++)
@@ -205,11 +204,23 @@ void task_rockblock(void) {
         success[i++] = sens_get_humid(&humidity);
         success[i++] = sens_get_htemp(&hTemp);
         success[i++] = sens_get_ptemp(&pTemp);
-        success[i++] = gnss_get_altitude(&GNSS, &altitude);
-        success[i++] = gnss_get_time(&GNSS, &time);
-        success[i++] = gnss_get_location(&GNSS, &location);
+        // one snapshot so altitude, time and location come from the same fix, moved to now if the last fix is late,
+        // or the last known position if it is too old to predict
+        fix = (gnss_fix_t){.quality = no_fix};
+        fix_valid = gnss_predict(&GNSS, xTaskGetTickCount(), &fix) || gnss_get_last_fix(&GNSS, &fix);
+        // the PPS disciplined clock keeps running without a fix, the fix time is only used until it is set
+        time_valid = time_now_utc(&now);
+        if(time_valid) {
+            gnss_utc_to_time(&now, &fix.time);
+        }
+        else {
+            time_valid = fix_valid && (fix.quality != no_fix);
+        }
+        success[i++] = fix_valid;
+        success[i++] = time_valid;
+        success[i++] = fix_valid;
 
-        rb_create_telemetry_packet(msg, &len, pressure, humidity, pTemp, hTemp, altitude, &time, &location, success);
+        rb_create_telemetry_packet(msg, &len, pressure, humidity, pTemp, hTemp, fix.altitude_mm / 1000, &fix.time, &fix.location, success);
 
         msgSent = false;
         msgReceived = 0;
@@ -258,7 +269,6 @@ void rb_init(ROCKBLOCK_t *rb) {
     rb->tx.last_ptr = rb->tx.buff;
 
     rb->rx.rxSemaphore = xSemaphoreCreateCounting(1, 0);
-    rb->tx.txSemaphore = xSemaphoreCreateCounting(1, 0);
     rb->busy_semaphore = xSemaphoreCreateMutex();
 
     // UART initialization
@@ -277,8 +287,9 @@ void rb_init(ROCKBLOCK_t *rb) {
 
     // not using ring buffer, so these are null. All TX/RX choices are processed by callback function in this file
     initUSCIUart(&a1_cnf, NULL, NULL);
-    initUartRxCallback(&USCI_A1_cnf, &rb_rx_callback, rb);
-    initUartTxCallback(&USCI_A1_cnf, &rb_tx_callback, rb);
+    // responses are only checked at the end of each line (or every RB_RX_SPAN_LEN bytes)
+    initUartRxSpanCallback(&USCI_A1_cnf, &rb_rx_callback, rb, "\r)", RB_RX_SPAN_LEN);
+    initUartTxDma(&USCI_A1_cnf, DMA_CHANNEL_0);
 
     // ring, network-available, and sleep pin initialization
     P8DIR &= ~(BIT0 | BIT1); // set ring and network-available pins to inputs. ON OUR MSP430
@@ -314,11 +325,13 @@ bool rb_check_netav(void){
         return false; // no signal at the time.
 }
 
-void rb_rx_callback(void *param, uint8_t datum) {
+void rb_rx_callback(void *param, const uint8_t *data, uint16_t len) {
     static uint8_t numReturns = 0;
     ROCKBLOCK_t *rb = (ROCKBLOCK_t *) param;
+    uint16_t i;
 
-    if(rb->rx.finished == false) {
+    for(i = 0; (i < len) && (rb->rx.finished == false); i++) {
+        uint8_t datum = data[i];
         *(rb->rx.cur_ptr) = datum; // take the data, we assume we have room here.
 
         if( (datum == (uint8_t) '\r') || (datum == (uint8_t) ')')) { // all message responses end with '\r', but there might be multiple '\r' per message.
@@ -336,20 +349,6 @@ void rb_rx_callback(void *param, uint8_t datum) {
     }
 }
 
-bool rb_tx_callback(void *param, uint8_t *txAddress) {
-    ROCKBLOCK_t *rb = (ROCKBLOCK_t *) param;
-
-    if(rb->tx.tx_ptr > rb->tx.last_ptr) { // sent last byte.
-        xSemaphoreGiveFromISR(rb->tx.txSemaphore, NULL);
-        return false;
-    }
-
-    *txAddress= *(rb->tx.tx_ptr);
-
-    rb->tx.tx_ptr++;
-    return true;
-}
-
 void rb_send_message(ROCKBLOCK_t *rb, uint8_t *msg, uint16_t len, bool *msgSent, int8_t *msgReceived, int8_t *msgsQueued) {
 
     rb_clear_buffers(rb);
@@ -19,6 +19,7 @@
 
 #include "ring_buff.h"
 #include "uart.h"
+#include "uart_stream.h"
 #include "FreeRTOS.h"
 #include "semphr.h"
 #include "gnss.h"
@@ -35,6 +36,7 @@
 // add 30 bytes for overhead from message echos.
 #define RB_TX_SIZE 340+30
 #define RB_RX_SIZE 270+30
+#define RB_RX_SPAN_LEN 16                       // longest run of RX bytes handed to rb_rx_callback at once
 #define RB_SOF '\0'
 #define RB_EOF '\0'
 
@@ -90,8 +92,6 @@ typedef struct {
     volatile uint8_t buff[RB_TX_SIZE];      // Simple TX buffer for our data. Do not modify directly.
     volatile uint8_t * volatile cur_ptr;    // pointer to next spot in the rb_tx_buff, where newest values will be taken from when sending.
     volatile uint8_t * volatile last_ptr;   // pointer to the final valid value in rb_tx_buff.
-    volatile uint8_t * volatile tx_ptr;     // pointer to the value being transmitted by callback.
-    SemaphoreHandle_t txSemaphore;          // lets us know when TX is done, so the task can go to sleep while transmitting.
 } rb_tx_buffer_t;
 
 /** @struct ROCKBLOCK_t
@@ -223,26 +223,15 @@ bool rb_retrieve_message(ROCKBLOCK_t *rb);
 
 /*!
  * \brief This is the function that will be used by the UART driver when we receive RX messages.
- * Pass this into the driver via the initUartRxCallback function. Recommend to not edit this function.
+ * Pass this into the driver via the initUartRxSpanCallback function. Recommend to not edit this function.
  * 
- * @param datum: is the byte that was just grabbed from the driver.
+ * @param data: is the run of bytes that was just grabbed from the driver.
+ * @param len: is the number of bytes in the run.
  * @param *param: MUST hold the ROCKBLOCK struct.
  *
  * \return none.
  */
-void rb_rx_callback(void *param, uint8_t datum);
-
-
-/*!
- * \brief This is the function that will be used by the UART driver when we send TX messages.
- * Pass this into the driver via the initUartTxCallback function. Recommend to not edit this function.
- *
- * @param txAddress: is where we put the byte we want the UART driver to send over the port.
- * @param *param: MUST hold the ROCKBLOCK struct.
- *
- * \return bool. Returns true while TX is ongoing. Returns false if TX is finished.
- */
-bool rb_tx_callback(void *param, uint8_t *txAddress);
+void rb_rx_callback(void *param, const uint8_t *data, uint16_t len);
 
 
 /*!
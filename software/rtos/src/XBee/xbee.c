@@ -11,7 +11,6 @@ XBEE_t XBee;
 
 void xb_init(XBEE_t *xb) {
 
-    ring_buff_init(&xb->rx_buff, xb->rx_mem, XBEE_RX_BUFF_SIZE);
     ring_buff_init(&xb->tx_buff, xb->tx_mem, XBEE_TX_BUFF_SIZE);
 
     // initialize semaphore
@@ -32,9 +31,10 @@ void xb_init(XBEE_t *xb) {
     };
     xb->uart = &USCI_A2_cnf;
 
-    initUSCIUart(&a2_cnf, &xb->tx_buff, &xb->rx_buff);
+    initUSCIUart(&a2_cnf, &xb->tx_buff, NULL);
 
-    initUartRxCallback(xb->uart, NULL, xb);
+    // received bytes go to the stream, which wakes the reader once XBEE_RX_TRIGGER bytes are in
+    uartStreamInit(&xb->stream, xb->uart, xb->rx_mem, XBEE_RX_BUFF_SIZE, XBEE_RX_TRIGGER);
     initUartTxCallback(xb->uart, NULL, xb);
 }
 
@@ -49,7 +49,11 @@ bool xb_tx_callback(void *param, uint8_t * txAddress) {
 }
 
 bool xb_transmit(XBEE_t *xb, uint8_t *buff, uint16_t len) {
-    return uartSendDataInt(xb->uart, buff, len) == UART_SUCCESS;
+    return uartStreamSend(&xb->stream, buff, len, XBEE_TX_TIMEOUT) == len;
+}
+
+uint16_t xb_receive(XBEE_t *xb, uint8_t *buff, uint16_t len, TickType_t timeout) {
+    return uartStreamReceive(&xb->stream, buff, len, timeout);
 }
 
 
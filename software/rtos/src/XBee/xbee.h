@@ -15,17 +15,20 @@
 
 #include "ring_buff.h"
 #include "uart.h"
+#include "uart_stream.h"
 #include "FreeRTOS.h"
 #include "semphr.h"
 
 #define XBEE_TX_BUFF_SIZE 32
 #define XBEE_RX_BUFF_SIZE 32
+#define XBEE_RX_TRIGGER 8       // bytes received before a waiting task is woken
+#define XBEE_TX_TIMEOUT 100     // ticks to wait for room in the TX buffer
 
 typedef struct {
     uint8_t rx_mem[XBEE_RX_BUFF_SIZE];
     uint8_t tx_mem[XBEE_TX_BUFF_SIZE];
-    ring_buff_t rx_buff;
     ring_buff_t tx_buff;
+    UARTStream stream;
     UARTConfig *uart;
 } XBEE_t;
 
@@ -34,6 +37,9 @@ void xb_init(XBEE_t *xb);
 
 bool xb_transmit(XBEE_t *xb, uint8_t *buff, uint16_t len);
 
+// blocks until XBEE_RX_TRIGGER bytes (or len, if smaller) arrive or the timeout expires. returns the number of bytes read.
+uint16_t xb_receive(XBEE_t *xb, uint8_t *buff, uint16_t len, TickType_t timeout);
+
 void xb_rx_callback(void *param, uint8_t datum);
 
 bool xb_tx_callback(void *param, uint8_t * txAddress);
@@ -88,17 +88,20 @@ void task_aprs() {
         vTaskDelayUntil(&xLastWakeTime, xFrequency);
 
         // Fetch GPS and sensor data
-        gnss_time_t time = {0};
-        gnss_coordinate_pair_t loc = {0};
-        loc.latitude.dir = 'N';
-        loc.longitude.dir = 'E';
-        int32_t alt = -1;
-
-        gnss_get_time(&GNSS, &time);
-        if(!gnss_get_location(&GNSS, &loc)){
+        gnss_fix_t fix;
+        gnss_utc_t now;
+        int32_t alt;
+
+        // one snapshot so time, location and altitude come from the same fix, moved to now if the last fix is late,
+        // or the last known position if it is too old to predict
+        if(!gnss_predict(&GNSS, xTaskGetTickCount(), &fix) && !gnss_get_last_fix(&GNSS, &fix)){
             continue;
         }
-        gnss_get_altitude(&GNSS, &alt);
+        // stamp the beacon with the PPS disciplined clock when it is set, it keeps running without a fix
+        if(time_now_utc(&now)) {
+            gnss_utc_to_time(&now, &fix.time);
+        }
+        alt = fix.altitude_mm / 1000;
 
         // Disable everything with interrupts so that our sine is clean
         gnss_disable_interrupts(&GNSS);
@@ -106,7 +109,7 @@ void task_aprs() {
 //        while(!sens_disable_interrupts());
 
         vTaskSuspendAll();
-        aprs_beacon(&time, &loc, &alt);
+        aprs_beacon(&fix.time, &fix.location, &alt);
         xTaskResumeAll();
 
         gnss_enable_interrupts(&GNSS);
@@ -198,7 +201,7 @@ void configDRA818V(const uint16_t pd_port, const uint16_t pd_pin,
     // Turn on radio
     GPIO_setAsOutputPin(pd_port, pd_pin);
     GPIO_setOutputHighOnPin(pd_port, pd_pin);
-    __delay_cycles(2 * configCPU_CLOCK_HZ);
+    vTaskDelay(2000 / portTICK_RATE_MS);
 
     // UART initialization
     UARTConfig a3_cnf = {
@@ -214,15 +217,14 @@ void configDRA818V(const uint16_t pd_port, const uint16_t pd_pin,
                     .stopbits = 1
     };
 
-    uint8_t buf[50];
-    ring_buff_t txbuf;
-    ring_buff_init(&txbuf, buf, 50);
-    initUSCIUart(&a3_cnf, &txbuf, NULL);
+    // the command is sent straight from cmd, no ring buffer needed
+    initUSCIUart(&a3_cnf, NULL, NULL);
 
     char cmd[50];
     sprintf(cmd, "AT+DMOSETGROUP=0,%s,%s,0000,4,0000\r\n", freq_str, freq_str);
 
-    uartSendDataBlocking(&USCI_A3_cnf, (uint8_t*)cmd, strlen(cmd));
+    // sleep while the command is sent (about 50ms at 9600 baud)
+    uartSendDataTask(&USCI_A3_cnf, (uint8_t*)cmd, strlen(cmd), 200 / portTICK_RATE_MS);
 
     disableUSCIUartInterrupts(&USCI_A3_cnf);
 }
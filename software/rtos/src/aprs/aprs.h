@@ -20,6 +20,7 @@ extern "C" {
 #include "afsk.h"
 #include "ax25.h"
 #include "uart.h"
+#include "uart_stream.h"
 #include "sensors.h"
 #include "rockblock.h"
 #include "gnss.h"
@@ -0,0 +1,264 @@
+
+#include "estimate.h"
+/*-------------------------------------------------------------------------------- /
+/ ATACS GNSS position and velocity estimator
+/ -------------------------------------------------------------------------------- /
+/ Part of the ATACS (Aerial Termination And Communication System) project
+/       https://github.com/michigan-balloon-recovery/ATACS
+/       released under the GPLv2 license (see ATACS/LICENSE in git repository)
+/ Creation Date: November 2019
+/ Contributors: Paul Young
+/ --------------------------------------------------------------------------------*/
+
+
+
+
+
+// ---------------------------------------------------------- //
+// -------------------- global variables -------------------- //
+// ---------------------------------------------------------- //
+
+// standard atmosphere pressure in 0.1 mbar every GNSS_EST_BARO_STEP from 0 to 36 km
+static const uint16_t gnss_est_baro_table[GNSS_EST_BARO_ENTRIES] = {
+    10132, 8987, 7950, 7011, 6164, 5402, 4718, 4106, 3560, 3074,
+    2644, 2263, 1933, 1651, 1410, 1204, 1029, 879, 750, 641,
+    547, 468, 400, 342, 293, 251, 215, 185, 159, 136,
+    117, 101, 87, 75, 65, 56, 48
+};
+
+
+
+
+
+// ------------------------------------------------------------ //
+// -------------------- private prototypes -------------------- //
+// ------------------------------------------------------------ //
+
+/*!
+ * \brief moves the estimate to a tick count with its velocity
+ *
+ * @param state is the estimate
+ * @param tick is the tick count to move to
+ * \return time moved in ms
+ */
+static int32_t gnss_est_predict(gnss_estimate_t *state, TickType_t tick);
+
+/*!
+ * \brief corrects one axis of the estimate with a measurement
+ *
+ * @param position is the predicted position of the axis
+ * @param rate is the rate of change of the axis per second
+ * @param residual is the measurement minus the predicted position
+ * @param dt is the time since the last correction in ms
+ * @param alpha is the position gain in Q8
+ * @param beta is the velocity gain in Q8
+ * \return None
+ */
+static void gnss_est_correct(int32_t *position, int32_t *rate, int32_t residual, int32_t dt, int16_t alpha, int16_t beta);
+
+/*!
+ * \brief checks that a residual is reachable in the time since the last correction
+ *
+ * @param residual is the measurement minus the predicted position
+ * @param dt is the time since the last correction in ms
+ * @param max_rate is the fastest plausible rate of change per second
+ * \return true if the residual is plausible
+ */
+static bool gnss_est_plausible(int64_t residual, int32_t dt, int32_t max_rate);
+
+
+
+
+
+// ---------------------------------------------------- //
+// -------------------- public API -------------------- //
+// ---------------------------------------------------- //
+
+void gnss_est_init(gnss_estimator_t *est) {
+    est->state.valid = false;
+    est->fix_msec = -1;
+    est->baro_bias_mm = 0;
+    est->baro_bias_valid = false;
+    est->baro_tick = 0;
+}
+
+void gnss_est_update_fix(gnss_estimator_t *est, const gnss_fix_t *fix, TickType_t tick, int32_t pressure) {
+    gnss_estimate_t *state = &est->state;
+    int32_t msec = gnss_time_to_msec(&fix->time);
+    int32_t latitude = gnss_coordinate_signed(&fix->location.latitude);
+    int32_t longitude = gnss_coordinate_signed(&fix->location.longitude);
+    int32_t baro_bias;
+    int32_t dt;
+    int32_t d_lat;
+    int32_t d_lon;
+    int64_t d_alt;
+    int32_t cos_lat;
+
+    // the epoch was already used with another sentence
+    if(state->valid && (msec == est->fix_msec)) {
+        return;
+    }
+    est->fix_msec = msec;
+
+    // GNSS altitude is the reference for barometric altitude
+    if(pressure > 0) {
+        baro_bias = fix->altitude_mm - gnss_est_baro_altitude(pressure);
+        if(est->baro_bias_valid) {
+            est->baro_bias_mm += (baro_bias - est->baro_bias_mm) / GNSS_EST_BIAS_FILTER;
+        }
+        else {
+            est->baro_bias_mm = baro_bias;
+            est->baro_bias_valid = true;
+        }
+    }
+
+    if(state->valid) {
+        dt = gnss_est_predict(state, tick);
+        if(dt <= 0) {
+            return;
+        }
+        d_lat = latitude - state->latitude;
+        d_lon = gnss_wrap_longitude(longitude - state->longitude);
+        d_alt = (int64_t)fix->altitude_mm - state->altitude_mm;
+
+        // a millisecond of longitude shrinks with cos(latitude), so the same speed is a faster longitude rate
+        cos_lat = gnss_cos_q15(latitude);
+        if(cos_lat < GNSS_EST_MIN_COS_Q15) {
+            cos_lat = GNSS_EST_MIN_COS_Q15;
+        }
+
+        // a fix further from the prediction than GNSS_VELOCITY_MAX allows is a jump, so the estimate restarts from it
+        if( gnss_est_plausible(d_lat, dt, GNSS_EST_MAX_RATE) && gnss_est_plausible(d_lon, dt, ((int32_t)GNSS_EST_MAX_RATE << 15) / cos_lat)
+            && gnss_est_plausible(d_alt, dt, GNSS_VELOCITY_MAX) ) {
+            gnss_est_correct(&state->latitude, &state->lat_rate, d_lat, dt, GNSS_EST_ALPHA, GNSS_EST_BETA);
+            gnss_est_correct(&state->longitude, &state->lon_rate, d_lon, dt, GNSS_EST_ALPHA, GNSS_EST_BETA);
+            gnss_est_correct(&state->altitude_mm, &state->ascent_mmps, d_alt, dt, GNSS_EST_ALPHA, GNSS_EST_BETA);
+            state->longitude = gnss_wrap_longitude(state->longitude);
+            state->fix_tick = tick;
+            return;
+        }
+    }
+
+    // start at the fix, at rest
+    state->latitude = latitude;
+    state->longitude = longitude;
+    state->altitude_mm = fix->altitude_mm;
+    state->lat_rate = 0;
+    state->lon_rate = 0;
+    state->ascent_mmps = 0;
+    state->tick = tick;
+    state->fix_tick = tick;
+    state->valid = true;
+}
+
+bool gnss_est_update_baro(gnss_estimator_t *est, TickType_t tick, int32_t pressure) {
+    gnss_estimate_t *state = &est->state;
+    int32_t dt;
+
+    if(!gnss_est_baro_due(est, tick) || (pressure <= 0)) {
+        return false;
+    }
+    est->baro_tick = tick;
+
+    dt = gnss_est_predict(state, tick);
+    if(dt <= 0) {
+        return false;
+    }
+    gnss_est_correct(&state->altitude_mm, &state->ascent_mmps, gnss_est_baro_altitude(pressure) + est->baro_bias_mm - state->altitude_mm,
+                     dt, GNSS_EST_BARO_ALPHA, GNSS_EST_BARO_BETA);
+    return true;
+}
+
+bool gnss_est_baro_due(const gnss_estimator_t *est, TickType_t tick) {
+    // GNSS altitude is used while fixes are arriving
+    return est->state.valid && est->baro_bias_valid
+        && ((TickType_t)(tick - est->state.fix_tick) * portTICK_PERIOD_MS >= GNSS_EST_BARO_HOLDOFF)
+        && ((TickType_t)(tick - est->baro_tick) * portTICK_PERIOD_MS >= GNSS_EST_BARO_PERIOD);
+}
+
+bool gnss_est_expire(gnss_estimator_t *est, TickType_t tick) {
+    if(!est->state.valid || ((TickType_t)(tick - est->state.fix_tick) * portTICK_PERIOD_MS < GNSS_EST_MAX_GAP)) {
+        return false;
+    }
+    est->state.valid = false;
+    return true;
+}
+
+void gnss_est_extrapolate(const gnss_estimate_t *estimate, TickType_t tick, gnss_fix_t *fix) {
+    int32_t dt = (int16_t)(tick - estimate->tick) * (int32_t)portTICK_PERIOD_MS;
+    int32_t latitude = estimate->latitude + (int64_t)estimate->lat_rate * dt / 1000;
+    int32_t longitude = gnss_wrap_longitude(estimate->longitude + (int64_t)estimate->lon_rate * dt / 1000);
+    int32_t msec;
+
+    if(latitude > 90 * GNSS_MSEC_ARC_PER_DEG) {
+        latitude = 90 * GNSS_MSEC_ARC_PER_DEG;
+    }
+    else if(latitude < -90 * GNSS_MSEC_ARC_PER_DEG) {
+        latitude = -90 * GNSS_MSEC_ARC_PER_DEG;
+    }
+
+    fix->location.latitude.dir = (latitude < 0) ? 'S' : 'N';
+    fix->location.latitude.decMilliSec = (latitude < 0) ? -latitude : latitude;
+    fix->location.longitude.dir = (longitude < 0) ? 'W' : 'E';
+    fix->location.longitude.decMilliSec = (longitude < 0) ? -longitude : longitude;
+    fix->altitude_mm = estimate->altitude_mm + (int64_t)estimate->ascent_mmps * dt / 1000;
+
+    // the time of the fix is moved by the time since it was decoded
+    msec = gnss_time_to_msec(&fix->time) + (int16_t)(tick - estimate->fix_tick) * (int32_t)portTICK_PERIOD_MS;
+    if(msec < 0) {
+        msec += GNSS_MSEC_PER_DAY;
+    }
+    else if(msec >= GNSS_MSEC_PER_DAY) {
+        msec -= GNSS_MSEC_PER_DAY;
+    }
+    fix->time.hour = msec / 3600000;
+    fix->time.min = (msec / 60000) % 60;
+    fix->time.msec = msec % 60000;
+}
+
+int32_t gnss_est_baro_altitude(int32_t pressure) {
+    int32_t p = pressure * 10;
+    uint8_t idx;
+
+    if(p >= gnss_est_baro_table[0]) {
+        return 0;
+    }
+
+    // find the step the pressure is in and interpolate linearly, extrapolating past the end of the table
+    for(idx = 1; idx < GNSS_EST_BARO_ENTRIES - 1; idx++) {
+        if(p > gnss_est_baro_table[idx]) {
+            break;
+        }
+    }
+    return (idx - 1) * GNSS_EST_BARO_STEP
+        + (int64_t)(gnss_est_baro_table[idx - 1] - p) * GNSS_EST_BARO_STEP / (gnss_est_baro_table[idx - 1] - gnss_est_baro_table[idx]);
+}
+
+
+
+
+
+// ----------------------------------------------------- //
+// -------------------- private API -------------------- //
+// ----------------------------------------------------- //
+
+static int32_t gnss_est_predict(gnss_estimate_t *state, TickType_t tick) {
+    int32_t dt = (TickType_t)(tick - state->tick) * (int32_t)portTICK_PERIOD_MS;
+
+    state->latitude += (int64_t)state->lat_rate * dt / 1000;
+    state->longitude = gnss_wrap_longitude(state->longitude + (int64_t)state->lon_rate * dt / 1000);
+    state->altitude_mm += (int64_t)state->ascent_mmps * dt / 1000;
+    state->tick = tick;
+    return dt;
+}
+
+static void gnss_est_correct(int32_t *position, int32_t *rate, int32_t residual, int32_t dt, int16_t alpha, int16_t beta) {
+    *position += (int64_t)residual * alpha / (1 << GNSS_EST_Q);
+    *rate += (int64_t)residual * beta * 1000 / ((int64_t)dt << GNSS_EST_Q);
+}
+
+static bool gnss_est_plausible(int64_t residual, int32_t dt, int32_t max_rate) {
+    int64_t rate = residual * 1000 / dt;
+
+    return (rate <= max_rate) && (rate >= -max_rate);
+}
@@ -0,0 +1,151 @@
+#ifndef ESTIMATE_H
+#define ESTIMATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+
+
+// -------------------------------------------------------------- //
+// -------------------- include dependencies -------------------- //
+// -------------------------------------------------------------- //
+
+// standard libraries
+#include <stdint.h>
+#include <stdbool.h>
+// application drivers
+#include "gnss.h"
+
+
+
+
+
+// ------------------------------------------------------- //
+// -------------------- public macros -------------------- //
+// ------------------------------------------------------- //
+
+/* alpha-beta gains in Q8:
+ *      - GNSS fixes are corrected with GNSS_EST_ALPHA and GNSS_EST_BETA (critically damped, beta = alpha^2 / (2 - alpha))
+ *      - barometric altitude is noisier (1 mbar steps), so it is corrected with smaller gains
+ */
+#define GNSS_EST_Q                  8
+#define GNSS_EST_ALPHA              179
+#define GNSS_EST_BETA               97
+#define GNSS_EST_BARO_ALPHA         64
+#define GNSS_EST_BARO_BETA          9
+
+/* timing (ms):
+ *      - the estimate is restarted from the next fix if no fix arrives for GNSS_EST_MAX_GAP
+ *      - barometric altitude is only used once no fix arrived for GNSS_EST_BARO_HOLDOFF, at most every GNSS_EST_BARO_PERIOD
+ */
+#define GNSS_EST_MAX_GAP            10000
+#define GNSS_EST_BARO_HOLDOFF       (2 * GNSS_NAV_PERIOD)
+#define GNSS_EST_BARO_PERIOD        1000
+
+/* plausibility limits:
+ *      - GNSS_EST_MAX_RATE is the fastest plausible latitude rate in milliseconds of arc per second
+ *      - the longitude limit is GNSS_EST_MAX_RATE / cos(latitude), with the cosine floored at GNSS_EST_MIN_COS_Q15 (about 86 degrees)
+ */
+#define GNSS_EST_MAX_RATE           (GNSS_VELOCITY_MAX * 1000 / GNSS_UM_PER_MSEC_ARC)
+#define GNSS_EST_MIN_COS_Q15        2048
+
+// the barometric altitude offset follows GNSS altitude with a time constant of GNSS_EST_BIAS_FILTER fixes
+#define GNSS_EST_BIAS_FILTER        8
+
+// standard atmosphere table, one entry per GNSS_EST_BARO_STEP mm of altitude
+#define GNSS_EST_BARO_STEP          1000000L
+#define GNSS_EST_BARO_ENTRIES       37
+
+
+
+
+
+// ----------------------------------------------------------- //
+// -------------------- public prototypes -------------------- //
+// ----------------------------------------------------------- //
+
+/*!
+ * \brief initializes the estimator
+ *
+ * @param est is the estimator
+ * \return None
+ *
+ */
+void gnss_est_init(gnss_estimator_t *est);
+
+/*!
+ * \brief corrects the estimate with a new fix
+ *
+ * Every axis is predicted to the tick of the fix and corrected with the alpha-beta gains.
+ * Fixes of the epoch already used (decoded from another sentence) are skipped.
+ *
+ * @param est is the estimator
+ * @param fix is the new fix
+ * @param tick is the tick count when the fix was decoded
+ * @param pressure is the pressure in mbar when the fix was decoded, 0 if not available
+ * \return None
+ *
+ */
+void gnss_est_update_fix(gnss_estimator_t *est, const gnss_fix_t *fix, TickType_t tick, int32_t pressure);
+
+/*!
+ * \brief corrects the vertical estimate with barometric altitude while no fixes arrive
+ *
+ * @param est is the estimator
+ * @param tick is the tick count of the pressure reading
+ * @param pressure is the pressure in mbar
+ * \return true if the estimate was changed
+ *
+ */
+bool gnss_est_update_baro(gnss_estimator_t *est, TickType_t tick, int32_t pressure);
+
+/*!
+ * \brief checks whether barometric altitude is wanted
+ *
+ * @param est is the estimator
+ * @param tick is the current tick count
+ * \return true if gnss_est_update_baro() would use a pressure reading taken now
+ *
+ */
+bool gnss_est_baro_due(const gnss_estimator_t *est, TickType_t tick);
+
+/*!
+ * \brief invalidates the estimate if no fix arrived for GNSS_EST_MAX_GAP ms
+ *
+ * Must be called more often than the tick count wraps around.
+ *
+ * @param est is the estimator
+ * @param tick is the current tick count
+ * \return true if the estimate was invalidated
+ *
+ */
+bool gnss_est_expire(gnss_estimator_t *est, TickType_t tick);
+
+/*!
+ * \brief extrapolates the location, altitude and time of a fix with an estimate
+ *
+ * @param estimate is the published estimate
+ * @param tick is the tick count to extrapolate to
+ * @param fix is the last fix, updated to tick
+ * \return None
+ *
+ */
+void gnss_est_extrapolate(const gnss_estimate_t *estimate, TickType_t tick, gnss_fix_t *fix);
+
+/*!
+ * \brief converts pressure to altitude with the standard atmosphere
+ *
+ * @param pressure is the pressure in mbar
+ * \return altitude in mm
+ *
+ */
+int32_t gnss_est_baro_altitude(int32_t pressure);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ESTIMATE_H */
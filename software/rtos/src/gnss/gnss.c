@@ -20,6 +20,51 @@ gnss_t GNSS = {.is_valid = false, .last_fix = 0};
 
 extern UARTConfig * prtInfList[5];
 
+// Free-running Timer_B0 count in SMCLK cycles (started by the UART driver), used to time the decoders
+#if defined(__MSP430_HAS_T0B7__)
+#define GNSS_STATS_TIMER() (TB0R)
+#else
+#define GNSS_STATS_TIMER() (0)
+#endif
+
+// UART1 at GNSS_BAUD_RATE, 8N1, UBX and NMEA in
+static const uint8_t gnss_cfg_prt[] = {
+    0x01, 0x00,                 // port ID, reserved
+    UBX_U16(0),                 // no TX ready pin
+    UBX_U32(0x000008D0),        // 8 data bits, no parity, 1 stop bit
+    UBX_U32(GNSS_BAUD_RATE),
+    UBX_U16(0x0003),            // UBX and NMEA input
+#ifdef GNSS_UBX
+    UBX_U16(0x0001),            // UBX output
+#else
+    UBX_U16(0x0003),            // NMEA output, and UBX for the acknowledgments of the configuration messages
+#endif
+    UBX_U16(0),                 // flags
+    UBX_U16(0)                  // reserved
+};
+
+// one navigation solution every GNSS_NAV_PERIOD ms, aligned to GPS time
+static const uint8_t gnss_cfg_rate[] = {
+    UBX_U16(GNSS_NAV_PERIOD),
+    UBX_U16(1),
+    UBX_U16(1)
+};
+
+// output rate (per navigation solution) of each message on the current port
+static const uint8_t gnss_cfg_msg[][3] = {
+#ifdef GNSS_UBX
+    {0x01, 0x07, 1},            // NAV-PVT
+    {0xF0, 0x00, 0},            // GGA
+    {0xF0, 0x04, 0},            // RMC
+#else
+    {0xF0, 0x00, 1},            // GGA
+#endif
+    {0xF0, 0x01, 0},            // GLL
+    {0xF0, 0x03, 0},            // GSV
+    {0xF0, 0x05, 0},            // VTG, RMC has the same speed and course
+    {0xF0, 0x41, 0}             // TXT
+};
+
 
 
 
@@ -28,19 +73,155 @@ extern UARTConfig * prtInfList[5];
 // -------------------- private prototypes -------------------- //
 // ------------------------------------------------------------ //
 
+#ifndef GNSS_RX_DMA
 /*!
  * \brief UART RX callback function
  *
  * Callback function to be called within the UART RX Interrupt Service Routine (ISR).
  * Identifies start or end of sentence and adds data to the ring buffer if part of a sentence.
- * Must be registered with the UART driver with initUartRxCallback().
+ * Must be registered with the UART driver with initUartRxSpanCallback().
  *
  * @param param is the passed in parameter from the UART driver. should be set as the GNSS object.
- * @param datum is the byte read over UART passed in by the UART driver.
+ * @param data is the run of bytes read over UART passed in by the UART driver.
+ * @param len is the number of bytes in the run.
  * \return None
  *
  */
-static void gnss_rx_callback(void *param, uint8_t datum);
+static void gnss_rx_callback(void *param, const uint8_t *data, uint16_t len);
+#else
+/*!
+ * \brief UART RX poll callback function
+ *
+ * Callback function to be called by uartDmaRxPoll() from the GNSS task when receiving with DMA.
+ * Identifies start or end of sentence and adds data to the ring buffer if part of a sentence.
+ *
+ * @param param is the passed in parameter from the UART driver. should be set as the GNSS object.
+ * @param data is the run of bytes read over UART passed in by the UART driver.
+ * @param len is the number of bytes in the run.
+ * \return None
+ *
+ */
+static void gnss_rx_poll_callback(void *param, const uint8_t *data, uint16_t len);
+#endif /* GNSS_RX_DMA */
+
+/*!
+ * \brief UART RX callback function used while configuring the receiver
+ *
+ * Only searches the received bytes for the acknowledgment of the configuration message being sent.
+ *
+ * @param param is the passed in parameter from the UART driver. should be set as the GNSS object.
+ * @param data is the run of bytes read over UART passed in by the UART driver.
+ * @param len is the number of bytes in the run.
+ * \return None
+ *
+ */
+static void gnss_rx_cfg_callback(void *param, const uint8_t *data, uint16_t len);
+
+/*!
+ * \brief initializes the GNSS UART at a baud rate
+ *
+ * Any RX callback has to be registered again afterwards.
+ *
+ * @param gnss_obj is the GNSS object
+ * @param baud_rate is the baud rate to run the UART at
+ * \return None
+ */
+static void gnss_uart_init(gnss_t *gnss_obj, uint32_t baud_rate);
+
+/*!
+ * \brief configures the receiver with UBX configuration messages
+ *
+ * Raises the baud rate to GNSS_BAUD_RATE, sets the navigation rate and turns off the messages that aren't decoded.
+ * Every message is checked for an acknowledgment and retried.
+ * If the receiver doesn't answer at the new baud rate, the UART is left at GNSS_BAUD_DEFAULT only if the receiver answers there.
+ *
+ * @param gnss_obj is the GNSS object
+ * \return None
+ */
+static void gnss_configure(gnss_t *gnss_obj);
+
+/*!
+ * \brief moves the UART to a baud rate while configuring the receiver
+ *
+ * @param gnss_obj is the GNSS object
+ * @param baud_rate is the new baud rate
+ * \return None
+ */
+static void gnss_configure_baud(gnss_t *gnss_obj, uint32_t baud_rate);
+
+/*!
+ * \brief sends the rate settings to check that the receiver understands the current baud rate
+ *
+ * @param gnss_obj is the GNSS object
+ * \return true if the settings were acknowledged or rejected, either of which shows they were understood
+ */
+static bool gnss_configure_rate(gnss_t *gnss_obj);
+
+/*!
+ * \brief copies the published fix, velocity and estimate
+ *
+ * The copy is retried if a new fix is published while it is being made.
+ *
+ * @param gnss_obj is the GNSS object
+ * @param fix is where to copy the fix to, NULL to skip it
+ * @param velocity is where to copy the velocity to, NULL to skip it
+ * @param estimate is where to copy the estimate to, NULL to skip it
+ * \return true if a consistent copy was made
+ */
+static bool gnss_read_published(gnss_t *gnss_obj, gnss_fix_t *fix, gnss_velocity_t *velocity, gnss_estimate_t *estimate);
+
+/*!
+ * \brief publishes the estimate after it was changed without a new fix
+ *
+ * @param gnss_obj is the GNSS object
+ * \return None
+ */
+static void gnss_publish_estimate(gnss_t *gnss_obj);
+
+/*!
+ * \brief keeps the estimate going while no fixes arrive
+ *
+ * Corrects the altitude with the pressure sensor once fixes are missing and invalidates the estimate after GNSS_EST_MAX_GAP ms.
+ *
+ * @param gnss_obj is the GNSS object
+ * \return None
+ */
+static void gnss_estimate_poll(gnss_t *gnss_obj);
+
+/*!
+ * \brief adds a fix to the history
+ *
+ * A fix of the same epoch as the newest entry (decoded from another sentence) replaces it.
+ *
+ * @param history is the fix history
+ * @param fix is the new fix
+ * \return None
+ */
+static void gnss_history_append(gnss_history_t *history, const gnss_fix_t *fix);
+
+/*!
+ * \brief computes the velocity averaged over the history
+ *
+ * Only the oldest and newest entries are used, so the cost doesn't depend on the window length.
+ *
+ * @param history is the fix history
+ * @param velocity is where to store the velocity
+ * \return None
+ */
+static void gnss_history_velocity(const gnss_history_t *history, gnss_velocity_t *velocity);
+
+/*!
+ * \brief counts the result of decoding one sentence or frame
+ *
+ * @param gnss_obj is the GNSS object
+ * @param result is the NMEA or UBX fault code returned by the decoder
+ * @param cycles is the time spent decoding in SMCLK cycles
+ * \return None
+ */
+static void gnss_decode_record(gnss_t *gnss_obj, int8_t result, uint16_t cycles);
+
+// ----- utility functions ----- //
+static uint32_t gnss_isqrt(uint64_t value);
 
 /*!
  * \brief initializes the GNSS object
@@ -59,34 +240,94 @@ static void gnss_init(gnss_t *gnss_obj);
 // -------------------------------------------------------------- //
 
 void task_gnss(void) {
+    uint16_t start;
+    int8_t result;
+#ifdef GNSS_RX_DMA
+    bool rx_active = false;
+#endif
+
     gnss_init(&GNSS);
     while (1) {
-        // wait for completed message to be received
-        xSemaphoreTake(GNSS.uart_semaphore, portMAX_DELAY);
-        gnss_nmea_decode(&GNSS);
+#ifdef GNSS_RX_DMA
+        // collect everything received by DMA since the last poll. the receiver sends one burst per
+        // navigation solution, so the line is only polled quickly until a poll finds it idle again
+        vTaskDelay((rx_active ? GNSS_RX_POLL_PERIOD : GNSS_RX_IDLE_PERIOD) / portTICK_RATE_MS);
+        rx_active = (uartDmaRxPoll(&USCI_A0_cnf) > 0);
+#else
+        // wait for completed sentences to be received. the notification value counts them
+        // the wait times out so the estimate is kept going while nothing is received
+        ulTaskNotifyTake(pdTRUE, GNSS_NAV_PERIOD / portTICK_RATE_MS);
+#endif
+        // decode every sentence received since the last wake-up
+        while(ring_buff_packet_count(&GNSS.gnss_rx_buff) > 0) {
+            start = GNSS_STATS_TIMER();
+#ifdef GNSS_UBX
+            result = gnss_ubx_decode(&GNSS);
+#else
+            result = gnss_nmea_decode(&GNSS);
+#endif
+            gnss_decode_record(&GNSS, result, GNSS_STATS_TIMER() - start);
+        }
+        gnss_estimate_poll(&GNSS);
     }
 }
 
 static void gnss_init(gnss_t *gnss_obj) {
     gnss_obj->decoding_message = false;
+#ifdef GNSS_UBX
+    gnss_obj->ubx_framer.state = UBX_STATE_SYNC_1;
+#endif
     gnss_obj->uart_module = USCI_A0;
+    gnss_obj->ubx_ack.result = UBX_NO_FAULT;
 
     // initialize ring buffers
     ring_buff_init(&gnss_obj->gnss_rx_buff, gnss_obj->gnss_rx_mem, GNSS_RX_BUFF_SIZE);
+    ring_buff_init_descriptors(&gnss_obj->gnss_rx_buff, gnss_obj->gnss_rx_desc, GNSS_RX_MAX_PACKETS);
+    // the newest sentence is worth more than a stale one
+    ring_buff_set_policy(&gnss_obj->gnss_rx_buff, RING_BUFF_DROP_OLDEST);
     ring_buff_init(&gnss_obj->gnss_tx_buff, gnss_obj->gnss_tx_mem, GNSS_TX_BUFF_SIZE);
 
-    // initialize semaphores
-    gnss_obj->uart_semaphore = xSemaphoreCreateCounting(255,0);
-    gnss_obj->data_mutex = xSemaphoreCreateMutex();
+    // no fix has been published
+    gnss_obj->fix_seq = 0;
+    gnss_obj->fix_known = false;
+    gnss_obj->history.head = 0;
+    gnss_obj->history.count = 0;
+    gnss_est_init(&gnss_obj->estimator);
+    gnss_obj->estimate.valid = false;
+    gnss_obj->stats = (gnss_decode_stats_t){0};
+
+    // the UTC clock is set by the PPS edges matched with the fixes
+    gnss_pps_init(&gnss_obj->pps);
+
+    // the RX callback notifies the task running gnss_init() (task_gnss)
+    gnss_obj->task = xTaskGetCurrentTaskHandle();
+
+    // initialize UART and cut the receiver's output down to what is decoded
+    gnss_uart_init(gnss_obj, GNSS_BAUD_DEFAULT);
+    gnss_configure(gnss_obj);
+
+#ifdef GNSS_RX_DMA
+    initUartRxSpanCallback(&USCI_A0_cnf, &gnss_rx_poll_callback, gnss_obj, NULL, 0);
+#elif defined(GNSS_UBX)
+    // binary frames have no terminator, so every byte is handed over to finish a frame as soon as its checksum arrives
+    initUartRxSpanCallback(&USCI_A0_cnf, &gnss_rx_callback, gnss_obj, NULL, 1);
+#else
+    // only run the callback once per sentence (or per full staging buffer)
+    initUartRxSpanCallback(&USCI_A0_cnf, &gnss_rx_callback, gnss_obj, "\n", UART_RX_STAGE_SIZE);
+#endif
 
-    // initialize UART
+    GPIO_setAsOutputPin(GPIO_PORT_P8, GPIO_PIN4);
+    gnss_obj->is_valid = true;
+}
+
+static void gnss_uart_init(gnss_t *gnss_obj, uint32_t baud_rate) {
     UARTConfig a0_cnf = {
                     .moduleName = USCI_A0,
                     .portNum = PORT_3,
                     .RxPinNum = PIN5,
                     .TxPinNum = PIN4,
                     .clkRate = configCPU_CLOCK_HZ,
-                    .baudRate = 9600L,
+                    .baudRate = baud_rate,
                     .clkSrc = UART_CLK_SRC_SMCLK,
                     .databits = 8,
                     .parity = UART_PARITY_NONE,
@@ -94,10 +335,62 @@ static void gnss_init(gnss_t *gnss_obj) {
                     };
     initUSCIUart(&a0_cnf, &gnss_obj->gnss_tx_buff, &gnss_obj->gnss_rx_buff);
 
-    initUartRxCallback(&USCI_A0_cnf, &gnss_rx_callback, gnss_obj);
+#ifdef GNSS_RX_DMA
+    initUartDmaRx(&USCI_A0_cnf, GNSS_RX_DMA_CHANNEL, gnss_obj->gnss_rx_dma_mem, GNSS_RX_DMA_SIZE);
+#endif
+}
 
-    GPIO_setAsOutputPin(GPIO_PORT_P8, GPIO_PIN4);
-    gnss_obj->is_valid = true;
+static void gnss_configure(gnss_t *gnss_obj) {
+    uint8_t attempt;
+    uint8_t i;
+
+    /* the receiver switches baud rate as soon as it takes the port settings, so their acknowledgment can't be relied on.
+     * they are sent at both baud rates, so they are taken whichever one the receiver is at (e.g. after only the MCU was reset),
+     * and the new baud rate is checked with the rate settings instead, which must be acknowledged at the new baud rate. */
+    for(attempt = 0; attempt < UBX_CFG_RETRIES; attempt++) {
+        gnss_configure_baud(gnss_obj, GNSS_BAUD_DEFAULT);
+        gnss_ubx_send(gnss_obj, UBX_CFG_PRT, gnss_cfg_prt, sizeof(gnss_cfg_prt));
+        vTaskDelay(GNSS_BAUD_SWITCH_DELAY / portTICK_RATE_MS);
+
+        gnss_configure_baud(gnss_obj, GNSS_BAUD_RATE);
+        gnss_ubx_send(gnss_obj, UBX_CFG_PRT, gnss_cfg_prt, sizeof(gnss_cfg_prt));
+        vTaskDelay(GNSS_BAUD_SWITCH_DELAY / portTICK_RATE_MS);
+
+        if(gnss_configure_rate(gnss_obj)) {
+            break;
+        }
+    }
+
+    /* never heard at the new baud rate. a receiver that took the port settings at either baud rate is at the new one,
+     * so the UART only goes back to the default baud rate if the receiver answers there. */
+    if(attempt == UBX_CFG_RETRIES) {
+        gnss_configure_baud(gnss_obj, GNSS_BAUD_DEFAULT);
+        if(!gnss_configure_rate(gnss_obj)) {
+            gnss_configure_baud(gnss_obj, GNSS_BAUD_RATE);
+        }
+    }
+
+    // messages that aren't acknowledged are left at the receiver's default rate
+    for(i = 0; i < sizeof(gnss_cfg_msg) / sizeof(gnss_cfg_msg[0]); i++) {
+        gnss_ubx_send_cfg(gnss_obj, UBX_CFG_MSG, gnss_cfg_msg[i], sizeof(gnss_cfg_msg[i]));
+    }
+}
+
+
+
+
+
+static void gnss_configure_baud(gnss_t *gnss_obj, uint32_t baud_rate) {
+    gnss_uart_init(gnss_obj, baud_rate);
+    // hand every byte over so an acknowledgment is seen as soon as it arrives
+    initUartRxSpanCallback(&USCI_A0_cnf, &gnss_rx_cfg_callback, gnss_obj, NULL, 1);
+}
+
+static bool gnss_configure_rate(gnss_t *gnss_obj) {
+    int8_t result = gnss_ubx_send_cfg(gnss_obj, UBX_CFG_RATE, gnss_cfg_rate, sizeof(gnss_cfg_rate));
+
+    // a rejected message still shows that the receiver understood it at this baud rate
+    return (result == UBX_NO_FAULT) || (result == UBX_CFG_NAK);
 }
 
 
@@ -108,58 +401,174 @@ static void gnss_init(gnss_t *gnss_obj) {
 // -------------------- public API -------------------- //
 // ---------------------------------------------------- //
 
-bool gnss_get_time(gnss_t *gnss_obj, gnss_time_t *time) {
-    bool data_valid = false;
-    if(!gnss_obj->is_valid || xSemaphoreTake(gnss_obj->data_mutex, 100) == pdFALSE) {
+bool gnss_get_fix(gnss_t *gnss_obj, gnss_fix_t *fix) {
+    return gnss_read_published(gnss_obj, fix, NULL, NULL) && (fix->quality != no_fix);
+}
+
+bool gnss_get_last_fix(gnss_t *gnss_obj, gnss_fix_t *fix) {
+    bool known = gnss_obj->fix_known;
+
+    // fix_known never goes back to false, so any copy made after reading it holds a position
+    portMEMORY_BARRIER();
+    return known && gnss_read_published(gnss_obj, fix, NULL, NULL);
+}
+
+bool gnss_get_velocity(gnss_t *gnss_obj, gnss_velocity_t *velocity) {
+    return gnss_read_published(gnss_obj, NULL, velocity, NULL) && velocity->valid;
+}
+
+bool gnss_get_ascent_rate(gnss_t *gnss_obj, int32_t *ascent_mmps) {
+    gnss_velocity_t velocity;
+
+    if(!gnss_get_velocity(gnss_obj, &velocity)) {
         return false;
     }
-    // check if the previous fix is valid
-    if(gnss_obj->last_fix.quality == no_fix) {
-        data_valid = false;
+    *ascent_mmps = velocity.ascent_mmps;
+    return true;
+}
+
+void gnss_get_stats(gnss_t *gnss_obj, gnss_decode_stats_t *stats) {
+    taskENTER_CRITICAL();
+    *stats = gnss_obj->stats;
+    taskEXIT_CRITICAL();
+
+    stats->decode_avg = (stats->decode_count > 0) ? (uint16_t)(stats->decode_total / stats->decode_count) : 0;
+}
+
+bool gnss_predict(gnss_t *gnss_obj, TickType_t tick, gnss_fix_t *fix) {
+    gnss_estimate_t estimate;
+    int16_t max_age = GNSS_PREDICT_MAX_AGE / portTICK_RATE_MS;
+    int16_t age;
+
+    // the estimate keeps running from the last known fix after the receiver loses it
+    if(!gnss_read_published(gnss_obj, fix, NULL, &estimate) || !estimate.valid) {
+        return false;
     }
-    else {
-        *time = gnss_obj->last_fix.time;
-        data_valid = true;
+
+    // don't extrapolate far from the last fix
+    age = (int16_t)(tick - estimate.fix_tick);
+    if( (age > max_age) || (age < -max_age) ) {
+        return false;
     }
 
-    xSemaphoreGive(gnss_obj->data_mutex);
-    return data_valid;
+    gnss_est_extrapolate(&estimate, tick, fix);
+    return true;
+}
+
+bool gnss_get_time(gnss_t *gnss_obj, gnss_time_t *time) {
+    gnss_fix_t fix;
+
+    if(!gnss_get_fix(gnss_obj, &fix)) {
+        return false;
+    }
+    *time = fix.time;
+    return true;
 }
 
 bool gnss_get_location(gnss_t *gnss_obj, gnss_coordinate_pair_t *location) {
-    bool data_valid = false;
-    if(!gnss_obj->is_valid || xSemaphoreTake(gnss_obj->data_mutex, 100) == pdFALSE) {
+    gnss_fix_t fix;
+
+    if(!gnss_get_fix(gnss_obj, &fix)) {
         return false;
     }
-    // check if the previous fix is valid
-    if(gnss_obj->last_fix.quality == no_fix) {
-        data_valid = false;
+    *location = fix.location;
+    return true;
+}
+
+bool gnss_get_altitude(gnss_t *gnss_obj, int32_t *altitude) {
+    gnss_fix_t fix;
+
+    if(!gnss_get_fix(gnss_obj, &fix)) {
+        return false;
+    }
+    *altitude = fix.altitude_mm / 1000;
+    return true;
+}
+
+void gnss_publish_fix(gnss_t *gnss_obj, const gnss_fix_t *fix) {
+    gnss_velocity_t velocity;
+    gnss_utc_t timestamp;
+    int32_t pressure;
+    bool new_epoch;
+
+    // only this task writes the published fix, so it can be read here without the sequence count
+    new_epoch = (fix->quality != no_fix) && ( (gnss_obj->last_fix.quality == no_fix) ||
+                (gnss_time_to_msec(&fix->time) != gnss_time_to_msec((const gnss_time_t *)&gnss_obj->last_fix.time)) );
+
+    if(new_epoch) {
+        // line the clock up with the PPS edge of the fix before timestamping it
+        gnss_pps_fix(&gnss_obj->pps, &fix->time);
+        gnss_pps_now(&gnss_obj->pps, &timestamp);
+
+        // the history and estimator are only used by this task, so they are updated before publishing
+        gnss_history_append(&gnss_obj->history, fix);
+        gnss_history_velocity(&gnss_obj->history, &velocity);
+        if(!sens_get_pres(&pressure)) {
+            pressure = 0;
+        }
+        gnss_obj->epoch_tick = xTaskGetTickCount();
+        gnss_est_update_fix(&gnss_obj->estimator, fix, gnss_obj->epoch_tick, pressure);
     }
     else {
-        *location = gnss_obj->last_fix.location;
-        data_valid = true;
+        // more fields of the published epoch, which keeps the time it was decoded at
+        timestamp = gnss_obj->last_fix.timestamp;
     }
 
-    xSemaphoreGive(gnss_obj->data_mutex);
-    return data_valid;
+    // the sequence count is odd while the fix is being written
+    gnss_obj->fix_seq++;
+    portMEMORY_BARRIER();
+    if(fix->quality != no_fix) {
+        gnss_obj->last_fix = *fix;
+        gnss_obj->last_fix.timestamp = timestamp;
+        gnss_obj->fix_known = true;
+    }
+    else {
+        // a lost fix keeps the last known position for gnss_get_last_fix(), and the history, clock
+        // and estimator at the last good epoch
+        gnss_obj->last_fix.quality = no_fix;
+    }
+    if(new_epoch) {
+        gnss_obj->velocity = velocity;
+        gnss_obj->estimate = gnss_obj->estimator.state;
+    }
+    portMEMORY_BARRIER();
+    gnss_obj->fix_seq++;
 }
 
-bool gnss_get_altitude(gnss_t *gnss_obj, int32_t *altitude) {
-    bool data_valid = false;
-    if(!gnss_obj->is_valid || xSemaphoreTake(gnss_obj->data_mutex, 100) == pdFALSE) {
-        return false;
+int32_t gnss_time_to_msec(const gnss_time_t *time) {
+    return (int32_t)time->hour * 3600000 + (int32_t)time->min * 60000 + time->msec;
+}
+
+int32_t gnss_coordinate_signed(const gnss_coordinate_t *coord) {
+    return ( (coord->dir == 'S') || (coord->dir == 'W') ) ? -(int32_t)coord->decMilliSec : (int32_t)coord->decMilliSec;
+}
+
+int32_t gnss_wrap_longitude(int32_t longitude) {
+    if(longitude > 180 * GNSS_MSEC_ARC_PER_DEG) {
+        return longitude - 360 * GNSS_MSEC_ARC_PER_DEG;
     }
-    // check if the previous fix is valid
-    if(gnss_obj->last_fix.quality == no_fix) {
-        data_valid = false;
+    if(longitude < -180 * GNSS_MSEC_ARC_PER_DEG) {
+        return longitude + 360 * GNSS_MSEC_ARC_PER_DEG;
     }
-    else {
-        *altitude = gnss_obj->last_fix.altitude;
-        data_valid = true;
+    return longitude;
+}
+
+int32_t gnss_cos_q15(int32_t decMilliSec) {
+    // cos() in Q15 every 10 degrees from 0 to 90 degrees
+    static const int16_t cos_table[10] = {32767, 32270, 30792, 28378, 25101, 21063, 16384, 11207, 5690, 0};
+    int32_t step = 10 * GNSS_MSEC_ARC_PER_DEG;
+    uint8_t idx;
+
+    if(decMilliSec < 0) {
+        decMilliSec = -decMilliSec;
+    }
+    if(decMilliSec >= 90 * GNSS_MSEC_ARC_PER_DEG) {
+        return 0;
     }
 
-    xSemaphoreGive(gnss_obj->data_mutex);
-    return data_valid;
+    // linear interpolation, the fraction of the step in 0.1%
+    idx = decMilliSec / step;
+    return cos_table[idx] + (int32_t)(cos_table[idx + 1] - cos_table[idx]) * ((decMilliSec % step) / (step / 1000)) / 1000;
 }
 
 //int32_t gnss_coord_to_decMilliSec(gnss_coordinate_t *coordinate) {
@@ -167,8 +576,11 @@ bool gnss_get_altitude(gnss_t *gnss_obj, int32_t *altitude) {
 //}
 
 void gnss_disable_interrupts(gnss_t *gnss_obj) {
+#ifndef GNSS_RX_DMA
+    // receiving with DMA doesn't interrupt the CPU, so there is nothing to disable
     while(gnss_obj->decoding_message == true);
     *prtInfList[gnss_obj->uart_module]->usciRegs->IE_REG &= ~UCRXIE;
+#endif
 }
 
 void gnss_enable_interrupts(gnss_t *gnss_obj) {
@@ -183,13 +595,219 @@ void gnss_enable_interrupts(gnss_t *gnss_obj) {
 // -------------------- private API -------------------- //
 // ----------------------------------------------------- //
 
-static void gnss_rx_callback(void *param, uint8_t datum) {
+#ifndef GNSS_RX_DMA
+static void gnss_rx_callback(void *param, const uint8_t *data, uint16_t len) {
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     gnss_t *gnss_obj = (gnss_t *)param;
+    uint8_t finished;
+
+#ifdef GNSS_UBX
+    finished = gnss_ubx_queue_span(gnss_obj, data, len);
+#else
+    finished = gnss_nmea_queue_span(gnss_obj, data, len);
+#endif
+
+    // release parsing task once per finished sentence, not on every span
+    while(finished > 0) {
+        vTaskNotifyGiveFromISR(gnss_obj->task, &xHigherPriorityTaskWoken);
+        finished--;
+    }
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+#endif /* GNSS_RX_DMA */
 
-    gnss_nmea_queue(gnss_obj, datum);
+static void gnss_rx_cfg_callback(void *param, const uint8_t *data, uint16_t len) {
+    gnss_t *gnss_obj = (gnss_t *)param;
 
-    // release parsing task
-    xSemaphoreGiveFromISR(gnss_obj->uart_semaphore, &xHigherPriorityTaskWoken);
-    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    gnss_ubx_ack_scan(gnss_obj, data, len);
+}
+
+#ifdef GNSS_RX_DMA
+static void gnss_rx_poll_callback(void *param, const uint8_t *data, uint16_t len) {
+    gnss_t *gnss_obj = (gnss_t *)param;
+
+#ifdef GNSS_UBX
+    gnss_ubx_queue_span(gnss_obj, data, len);
+#else
+    gnss_nmea_queue_span(gnss_obj, data, len);
+#endif
+}
+#endif /* GNSS_RX_DMA */
+
+static bool gnss_read_published(gnss_t *gnss_obj, gnss_fix_t *fix, gnss_velocity_t *velocity, gnss_estimate_t *estimate) {
+    uint16_t seq;
+    uint8_t attempt;
+
+    if(!gnss_obj->is_valid) {
+        return false;
+    }
+
+    for(attempt = 0; attempt < GNSS_FIX_READ_ATTEMPTS; attempt++) {
+        seq = gnss_obj->fix_seq;
+        portMEMORY_BARRIER();
+        if(fix != NULL) {
+            *fix = gnss_obj->last_fix;
+        }
+        if(velocity != NULL) {
+            *velocity = gnss_obj->velocity;
+        }
+        if(estimate != NULL) {
+            *estimate = gnss_obj->estimate;
+        }
+        portMEMORY_BARRIER();
+
+        // the copy is consistent if no write was in progress or started while copying
+        if( !(seq & 1) && (seq == gnss_obj->fix_seq) ) {
+            return true;
+        }
+
+        // let a preempted GNSS task finish publishing
+        taskYIELD();
+    }
+    return false;
+}
+
+static void gnss_publish_estimate(gnss_t *gnss_obj) {
+    gnss_obj->fix_seq++;
+    portMEMORY_BARRIER();
+    gnss_obj->estimate = gnss_obj->estimator.state;
+    portMEMORY_BARRIER();
+    gnss_obj->fix_seq++;
+}
+
+static void gnss_estimate_poll(gnss_t *gnss_obj) {
+    TickType_t tick = xTaskGetTickCount();
+    int32_t pressure;
+
+    if(gnss_est_expire(&gnss_obj->estimator, tick)) {
+        gnss_publish_estimate(gnss_obj);
+    }
+    else if(gnss_est_baro_due(&gnss_obj->estimator, tick) && sens_get_pres(&pressure)
+            && gnss_est_update_baro(&gnss_obj->estimator, tick, pressure)) {
+        gnss_publish_estimate(gnss_obj);
+    }
+}
+
+static void gnss_decode_record(gnss_t *gnss_obj, int8_t result, uint16_t cycles) {
+    volatile gnss_decode_stats_t *stats = &gnss_obj->stats;
+
+    // the 32 bit counters are read by other tasks
+    taskENTER_CRITICAL();
+    if(result == 0) {
+        stats->decoded++;
+    }
+    else if( (result < 0) && (result > -GNSS_DECODE_FAULTS) ) {
+        stats->rejected[-result]++;
+    }
+    if(cycles > stats->decode_max) {
+        stats->decode_max = cycles;
+    }
+    stats->decode_total += cycles;
+    stats->decode_count++;
+    taskEXIT_CRITICAL();
+}
+
+static void gnss_history_append(gnss_history_t *history, const gnss_fix_t *fix) {
+    gnss_history_entry_t *entry = &history->entries[history->head];
+    int32_t msec = gnss_time_to_msec(&fix->time);
+    int32_t gap = 0;
+
+    if(history->count > 0) {
+        gap = msec - entry->msec;
+        if(gap < 0) {
+            gap += GNSS_MSEC_PER_DAY;
+        }
+
+        // restart after a gap (or a time going backwards) so the window doesn't span unrelated fixes
+        if(gap > GNSS_HISTORY_MAX_GAP) {
+            history->count = 0;
+        }
+    }
+
+    // a new epoch takes the next entry, overwriting the oldest once the history is full
+    if( (history->count == 0) || (gap != 0) ) {
+        history->head = (history->head + 1) & (GNSS_HISTORY_LEN - 1);
+        entry = &history->entries[history->head];
+        if(history->count < GNSS_HISTORY_LEN) {
+            history->count++;
+        }
+    }
+
+    entry->tick = xTaskGetTickCount();
+    entry->msec = msec;
+    entry->latitude = gnss_coordinate_signed(&fix->location.latitude);
+    entry->longitude = gnss_coordinate_signed(&fix->location.longitude);
+    entry->altitude_mm = fix->altitude_mm;
+}
+
+static void gnss_history_velocity(const gnss_history_t *history, gnss_velocity_t *velocity) {
+    const gnss_history_entry_t *newest = &history->entries[history->head];
+    const gnss_history_entry_t *oldest = &history->entries[(history->head + 1 - history->count) & (GNSS_HISTORY_LEN - 1)];
+    int32_t d_lat;
+    int32_t d_lon;
+    int32_t dt;
+    int64_t north;
+    int64_t east;
+    int64_t ascent;
+
+    velocity->north_mmps = 0;
+    velocity->east_mmps = 0;
+    velocity->ground_mmps = 0;
+    velocity->ascent_mmps = 0;
+    velocity->window_ms = 0;
+    velocity->valid = false;
+
+    if(history->count < 2) {
+        return;
+    }
+
+    dt = newest->msec - oldest->msec;
+    if(dt < 0) {
+        dt += GNSS_MSEC_PER_DAY;
+    }
+    if(dt == 0) {
+        return;
+    }
+
+    // shortest way across the antimeridian
+    d_lat = newest->latitude - oldest->latitude;
+    d_lon = gnss_wrap_longitude(newest->longitude - oldest->longitude);
+
+    // a millisecond of arc of latitude is GNSS_UM_PER_MSEC_ARC um, longitude is shorter by cos(latitude)
+    north = (int64_t)d_lat * GNSS_UM_PER_MSEC_ARC / dt;
+    east = (int64_t)d_lon * GNSS_UM_PER_MSEC_ARC * gnss_cos_q15(newest->latitude) / ((int64_t)dt << 15);
+    ascent = ((int64_t)newest->altitude_mm - oldest->altitude_mm) * 1000 / dt;
+
+    // a glitch in the window would give a meaningless average
+    if( (north > GNSS_VELOCITY_MAX) || (north < -GNSS_VELOCITY_MAX) || (east > GNSS_VELOCITY_MAX) || (east < -GNSS_VELOCITY_MAX)
+        || (ascent > GNSS_VELOCITY_MAX) || (ascent < -GNSS_VELOCITY_MAX) ) {
+        return;
+    }
+
+    velocity->north_mmps = north;
+    velocity->east_mmps = east;
+    velocity->ground_mmps = gnss_isqrt(north * north + east * east);
+    velocity->ascent_mmps = ascent;
+    velocity->window_ms = dt;
+    velocity->valid = true;
+}
+
+static uint32_t gnss_isqrt(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while(bit > value) {
+        bit >>= 2;
+    }
+    while(bit != 0) {
+        if(value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
 }
@@ -22,9 +22,11 @@ extern "C" {
 // FreeRTOS
 #include "FreeRTOS.h"
 #include "semphr.h"
+#include "task.h"
 // application drivers
 #include "ring_buff.h"
 #include "uart.h"
+#include "sensors.h"
 
 
 
@@ -41,22 +43,80 @@ extern "C" {
  *      - GNSS_UBX for proprietary UBX communications
  *          * Only compatible with UBLOX modules
  *          * higher performance binary protocol
- *          * not yet implemented TODO: implement UBX
+ *          * the receiver must be set to output UBX NAV-PVT messages
  */
 #define GNSS_NMEA
 
+/* receive mode:
+ *      - by default every byte is queued from the UART RX interrupt
+ *          * the GNSS task is notified once per finished sentence, so it only wakes up when there is something to decode
+ *      - GNSS_RX_DMA to receive with DMA into a circular buffer that the GNSS task polls
+ *          * no interrupt per byte, so higher baud rates and nav rates are affordable
+ *          * the task polls every GNSS_RX_IDLE_PERIOD ms while the line is idle and every GNSS_RX_POLL_PERIOD ms
+ *            while a burst of sentences is arriving, so a burst is decoded once a poll finds the line idle again
+ *          * the circular buffer must hold everything received in GNSS_RX_IDLE_PERIOD + GNSS_RX_POLL_PERIOD ms
+ */
+//#define GNSS_RX_DMA
+
+/* receiver configuration:
+ *      - the receiver starts at GNSS_BAUD_DEFAULT and is switched to GNSS_BAUD_RATE by gnss_init()
+ *      - GNSS_NAV_PERIOD is the time between navigation solutions in ms
+ */
+#define GNSS_BAUD_DEFAULT               9600L
+#define GNSS_BAUD_RATE                  38400L
+#define GNSS_NAV_PERIOD                 1000
+#define GNSS_BAUD_SWITCH_DELAY          20
+
+// sentences without a time of their own (GSA, VTG) only update a fix published less than this many ms before them
+#define GNSS_EPOCH_WINDOW               (GNSS_NAV_PERIOD / 2)
+
+// times gnss_get_fix() tries to copy the fix before giving up because it keeps being rewritten
+#define GNSS_FIX_READ_ATTEMPTS          4
+
+/* fix history:
+ *      - GNSS_HISTORY_LEN fixes are kept (must be a power of 2), velocities are averaged over all of them
+ *      - the history restarts if no fix is published for GNSS_HISTORY_MAX_GAP ms
+ */
+#define GNSS_HISTORY_LEN                8
+#define GNSS_HISTORY_MAX_GAP            5000
+
+// unit conversions for the velocity
+#define GNSS_MSEC_PER_DAY               86400000L
+#define GNSS_MSEC_ARC_PER_DEG           3600000L
+#define GNSS_UM_PER_MSEC_ARC            30867L      // micrometers along a meridian per millisecond of arc
+
+// fixes implying a faster velocity (mm/s) are treated as glitches
+#define GNSS_VELOCITY_MAX               1000000L
+
+// gnss_predict() doesn't extrapolate more than GNSS_PREDICT_MAX_AGE ms from the last fix (ticks wrap after 65 s)
+#define GNSS_PREDICT_MAX_AGE            10000
+
+// fault codes counted by gnss_get_stats(), must cover NMEA_FAULTS and UBX_FAULTS
+#define GNSS_DECODE_FAULTS              8
+
+#ifdef GNSS_RX_DMA
+
+#define GNSS_RX_DMA_CHANNEL             DMA_CHANNEL_1
+#define GNSS_RX_DMA_SIZE                512
+#define GNSS_RX_POLL_PERIOD             50
+#define GNSS_RX_IDLE_PERIOD             200
+
+#endif /* GNSS_RX_DMA */
+
 #ifdef GNSS_UBX
 
-#define GNSS_RX_BUFF_SIZE                1000
-#define GNSS_TX_BUFF_SIZE                1000
+#define GNSS_RX_BUFF_SIZE                1024
+#define GNSS_TX_BUFF_SIZE                1024
+#define GNSS_RX_MAX_PACKETS              16
 
 #endif /* GNSS_UBX */
 
 #ifdef GNSS_NMEA
 
-#define GNSS_TX_BUFF_SIZE               100
+#define GNSS_TX_BUFF_SIZE               128
 #define GNSS_RX_BUFF_SIZE               512
 #define GNSS_RX_MAX_PAYLOAD             100
+#define GNSS_RX_MAX_PACKETS             16
 
 #endif /* GNSS_NMEA */
 
@@ -105,6 +165,15 @@ typedef struct {
     uint16_t msec;
 } gnss_time_t;
 
+/** @struct gnss_utc_t
+ *  @brief UTC time of day with sub-millisecond resolution
+ *
+ */
+typedef struct {
+    int32_t msec;               /**< ms since midnight, -1 if the clock isn't set */
+    uint16_t usec;              /**< us within the ms */
+} gnss_utc_t;
+
 /** @struct gnss_fix_t
  *  @brief GNSS fix data
  *
@@ -114,9 +183,142 @@ typedef struct {
     gnss_coordinate_pair_t location;
     gnss_quality_t quality;
     uint8_t num_satellites;
-    int32_t altitude;
+    int32_t altitude_mm;
+    int32_t speed_mmps;         /**< ground speed in mm/s */
+    int32_t course_mdeg;        /**< course over ground in 0.001 degrees from true north */
+    uint16_t pdop;              /**< position dilution of precision * 100 */
+    uint16_t hdop;              /**< horizontal dilution of precision * 100 */
+    uint16_t vdop;              /**< vertical dilution of precision * 100 */
+    uint8_t fix_mode;           /**< 1 = no fix, 2 = 2D fix, 3 = 3D fix */
+    gnss_utc_t timestamp;       /**< UTC time the fix was decoded at (from the PPS disciplined clock) */
 } gnss_fix_t;
 
+/** @struct gnss_history_entry_t
+ *  @brief compact copy of a fix kept in the fix history
+ *
+ */
+typedef struct {
+    TickType_t tick;            /**< tick count when the fix was published */
+    int32_t msec;               /**< UTC time of the fix in ms since midnight */
+    int32_t latitude;           /**< milliseconds of arc, negative south */
+    int32_t longitude;          /**< milliseconds of arc, negative west */
+    int32_t altitude_mm;
+} gnss_history_entry_t;
+
+/** @struct gnss_history_t
+ *  @brief ring of the last GNSS_HISTORY_LEN fixes, one per navigation epoch
+ *
+ */
+typedef struct {
+    gnss_history_entry_t entries[GNSS_HISTORY_LEN];
+    uint8_t head;               /**< index of the newest entry */
+    uint8_t count;              /**< number of entries in use */
+} gnss_history_t;
+
+/** @struct gnss_velocity_t
+ *  @brief velocity averaged over the fix history
+ *
+ */
+typedef struct {
+    int32_t north_mmps;         /**< northward velocity in mm/s */
+    int32_t east_mmps;          /**< eastward velocity in mm/s */
+    int32_t ground_mmps;        /**< horizontal speed in mm/s */
+    int32_t ascent_mmps;        /**< vertical velocity in mm/s, positive up */
+    int32_t window_ms;          /**< time between the oldest and newest fix of the average */
+    bool valid;                 /**< at least two fixes are in the history */
+} gnss_velocity_t;
+
+/** @struct gnss_estimate_t
+ *  @brief position and velocity estimated by the alpha-beta filter
+ *
+ */
+typedef struct {
+    TickType_t tick;            /**< tick count the estimate is for */
+    TickType_t fix_tick;        /**< tick count of the last fix used */
+    int32_t latitude;           /**< milliseconds of arc, negative south */
+    int32_t longitude;          /**< milliseconds of arc, negative west */
+    int32_t altitude_mm;
+    int32_t lat_rate;           /**< milliseconds of arc per second */
+    int32_t lon_rate;           /**< milliseconds of arc per second */
+    int32_t ascent_mmps;
+    bool valid;
+} gnss_estimate_t;
+
+/** @struct gnss_estimator_t
+ *  @brief alpha-beta filter state
+ *
+ */
+typedef struct {
+    gnss_estimate_t state;
+    int32_t fix_msec;           /**< UTC time of the last fix used in ms since midnight */
+    int32_t baro_bias_mm;       /**< GNSS altitude minus barometric altitude */
+    TickType_t baro_tick;       /**< tick count of the last pressure reading used */
+    bool baro_bias_valid;
+} gnss_estimator_t;
+
+/** @struct gnss_clock_t
+ *  @brief UTC clock disciplined by the receiver's PPS
+ *
+ */
+typedef struct {
+    uint32_t ref_counts;        /**< timer count at the last PPS edge matched with a fix */
+    int32_t ref_msec;           /**< UTC time of that edge in ms since midnight */
+    uint32_t counts_per_sec;    /**< timer counts per UTC second in Q8, measured between PPS edges */
+    bool valid;
+} gnss_clock_t;
+
+/** @struct gnss_pps_t
+ *  @brief PPS capture and UTC clock
+ *
+ */
+typedef struct {
+    volatile uint32_t ticks;        /**< tick interrupts since startup, counted by gnss_pps_tick() */
+    volatile uint32_t capture;      /**< timer count at the last PPS edge */
+    volatile bool captured;         /**< a PPS edge was captured since the last fix of a whole second */
+    volatile gnss_clock_t clock;    /**< written by the GNSS task, read with time_now_utc() */
+    volatile uint16_t clock_seq;    /**< odd while clock is being written */
+    bool rate_valid;                /**< counts_per_sec was measured */
+} gnss_pps_t;
+
+/** @struct gnss_decode_stats_t
+ *  @brief decoder counters, decode times are in SMCLK cycles measured with Timer_B0
+ *
+ */
+typedef struct {
+    uint32_t decoded;               /**< sentences or frames decoded without a fault */
+    uint16_t rejected[GNSS_DECODE_FAULTS];  /**< sentences or frames dropped, indexed by the negated NMEA or UBX fault code */
+    uint16_t decode_max;            /**< longest decode */
+    uint32_t decode_total;          /**< sum of the decode times */
+    uint32_t decode_count;          /**< number of decodes timed */
+    uint16_t decode_avg;            /**< average decode time, only filled in by gnss_get_stats() */
+} gnss_decode_stats_t;
+
+/** @struct gnss_ubx_framer_t
+ *  @brief state of the UBX frame receiver
+ *
+ */
+typedef struct {
+    uint8_t state;              /**< position within the frame, see "Frame States" in ubx.h */
+    uint8_t ck_a;               /**< running Fletcher checksum */
+    uint8_t ck_b;
+    uint16_t len;               /**< payload length from the frame header */
+    uint16_t count;             /**< payload bytes received */
+} gnss_ubx_framer_t;
+
+/** @struct gnss_ubx_ack_t
+ *  @brief state of the search for the acknowledgment of a UBX configuration message
+ *
+ */
+typedef struct {
+    uint8_t idx;                /**< number of bytes of the acknowledgment frame matched */
+    uint8_t ck_a;               /**< running Fletcher checksum */
+    uint8_t ck_b;
+    bool nak;                   /**< the frame being matched is an ACK-NAK */
+    uint8_t cls;                /**< class of the message waiting for an acknowledgment */
+    uint8_t id;                 /**< ID of the message waiting for an acknowledgment */
+    volatile int8_t result;     /**< UBX_CFG_PENDING while waiting, then a "UBX Faults" code */
+} gnss_ubx_ack_t;
+
 /** @struct gnss_t
  *  @brief config object for the entire GNSS module
  *
@@ -124,12 +326,26 @@ typedef struct {
 typedef struct {
     uint8_t gnss_rx_mem[GNSS_RX_BUFF_SIZE];
     uint8_t gnss_tx_mem[GNSS_TX_BUFF_SIZE];
+    uint16_t gnss_rx_desc[GNSS_RX_MAX_PACKETS];
+#ifdef GNSS_RX_DMA
+    uint8_t gnss_rx_dma_mem[GNSS_RX_DMA_SIZE];
+#endif
     ring_buff_t gnss_rx_buff;
     ring_buff_t gnss_tx_buff;
     UART_MODULE_NAMES uart_module;
-    gnss_fix_t last_fix;
-    SemaphoreHandle_t uart_semaphore;
-    SemaphoreHandle_t data_mutex;
+    volatile gnss_fix_t last_fix;   /**< written with gnss_publish_fix(), read with gnss_get_fix() */
+    volatile gnss_velocity_t velocity;  /**< written with last_fix */
+    volatile uint16_t fix_seq;      /**< odd while last_fix is being written */
+    volatile gnss_estimate_t estimate;  /**< written with last_fix */
+    TickType_t epoch_tick;          /**< tick count the last new epoch was published at, only used by the GNSS task */
+    volatile bool fix_known;        /**< set with the first fix, last_fix holds a position from then on */
+    gnss_history_t history;         /**< only used by the GNSS task */
+    gnss_estimator_t estimator;     /**< only used by the GNSS task */
+    gnss_pps_t pps;
+    volatile gnss_decode_stats_t stats; /**< written by the GNSS task, read with gnss_get_stats() */
+    gnss_ubx_framer_t ubx_framer;
+    gnss_ubx_ack_t ubx_ack;
+    TaskHandle_t task;
     bool decoding_message;
     bool is_valid;
 } gnss_t;
@@ -138,9 +354,10 @@ typedef struct {
 #include "nmea.h"
 #endif
 
-#ifdef GNSS_UBX
+// the receiver is configured with UBX messages with either protocol
 #include "ubx.h"
-#endif
+#include "estimate.h"
+#include "pps.h"
 
 
 
@@ -157,6 +374,32 @@ typedef struct {
  */
 void task_gnss(void);
 
+/*!
+ * \brief get the last GNSS fix
+ *
+ * Copies the whole fix at once, so all of its fields come from the same fix.
+ * Doesn't block: the copy is retried if the GNSS task publishes a new fix while it is being made.
+ *
+ * @param gnss_obj is the GNSS object to retrieve the fix from.
+ * @param fix is a pointer to the memory address to store the fix in.
+ * \return true if a valid fix was copied
+ *
+ */
+bool gnss_get_fix(gnss_t *gnss_obj, gnss_fix_t *fix);
+
+/*!
+ * \brief get the last known GNSS fix
+ *
+ * Like gnss_get_fix(), but also returns the last fix after the receiver lost it (with no_fix quality),
+ * so its position, altitude and time are those of the last good fix.
+ *
+ * @param gnss_obj is the GNSS object to retrieve the fix from.
+ * @param fix is a pointer to the memory address to store the fix in.
+ * \return true if a fix was ever published and was copied
+ *
+ */
+bool gnss_get_last_fix(gnss_t *gnss_obj, gnss_fix_t *fix);
+
 /*!
  * \brief get time of the last GNSS fix
  *
@@ -181,12 +424,114 @@ bool gnss_get_location(gnss_t *gnss_obj, gnss_coordinate_pair_t *location);
  * \brief get altitude of the last GNSS fix
  *
  * @param gnss_obj is the GNSS object to retrieve the fix from.
- * @param altitude is a pointer to the memory address to store the altitude in.
+ * @param altitude is a pointer to the memory address to store the altitude in (m above mean sea level, truncated).
  * \return None
  *
  */
 bool gnss_get_altitude(gnss_t *gnss_obj, int32_t *altitude);
 
+/*!
+ * \brief get velocity averaged over the last GNSS fixes
+ *
+ * The average over the window is the displacement between the oldest and newest fix of the history divided by the time between them.
+ * It is updated with each new fix, so this costs the same as gnss_get_fix().
+ *
+ * @param gnss_obj is the GNSS object to retrieve the velocity from.
+ * @param velocity is a pointer to the memory address to store the velocity in.
+ * \return true if at least two fixes were available
+ *
+ */
+bool gnss_get_velocity(gnss_t *gnss_obj, gnss_velocity_t *velocity);
+
+/*!
+ * \brief get ascent rate averaged over the last GNSS fixes
+ *
+ * @param gnss_obj is the GNSS object to retrieve the ascent rate from.
+ * @param ascent_mmps is a pointer to the memory address to store the ascent rate in (mm/s, positive up).
+ * \return true if at least two fixes were available
+ *
+ */
+bool gnss_get_ascent_rate(gnss_t *gnss_obj, int32_t *ascent_mmps);
+
+/*!
+ * \brief get the decoder counters
+ *
+ * Malformed or out of range sentences and frames are dropped by the decoders and counted here by fault code.
+ *
+ * @param gnss_obj is the GNSS object to retrieve the counters from.
+ * @param stats is updated with a copy of the counters and the average decode time
+ * \return None
+ *
+ */
+void gnss_get_stats(gnss_t *gnss_obj, gnss_decode_stats_t *stats);
+
+/*!
+ * \brief get the GNSS fix extrapolated to a tick count
+ *
+ * The location, altitude and time of the last fix are moved to tick with the position and velocity estimated from the last fixes
+ * (and barometric altitude while fixes are missing), also after the receiver lost the fix (the quality is then no_fix).
+ * Fails if the last fix is more than GNSS_PREDICT_MAX_AGE ms from tick; gnss_get_last_fix() still returns it.
+ *
+ * @param gnss_obj is the GNSS object to retrieve the fix from.
+ * @param tick is the tick count to extrapolate to (ex. xTaskGetTickCount()).
+ * @param fix is a pointer to the memory address to store the fix in.
+ * \return true if a recent fix was available
+ *
+ */
+bool gnss_predict(gnss_t *gnss_obj, TickType_t tick, gnss_fix_t *fix);
+
+/*!
+ * \brief converts the time of a fix to ms since midnight
+ *
+ * @param time is the time to convert
+ * \return ms since midnight
+ *
+ */
+int32_t gnss_time_to_msec(const gnss_time_t *time);
+
+/*!
+ * \brief converts a coordinate to signed milliseconds of arc (negative south and west)
+ *
+ * @param coord is the coordinate to convert
+ * \return milliseconds of arc
+ *
+ */
+int32_t gnss_coordinate_signed(const gnss_coordinate_t *coord);
+
+/*!
+ * \brief wraps a longitude (or a difference of longitudes) to +/-180 degrees
+ *
+ * @param longitude is the longitude in milliseconds of arc
+ * \return longitude in milliseconds of arc
+ *
+ */
+int32_t gnss_wrap_longitude(int32_t longitude);
+
+/*!
+ * \brief cosine of a latitude, interpolated from a table every 10 degrees
+ *
+ * @param decMilliSec is the latitude in milliseconds of arc
+ * \return cosine in Q15, 0 at and past the poles
+ *
+ */
+int32_t gnss_cos_q15(int32_t decMilliSec);
+
+/*!
+ * \brief publish a new GNSS fix
+ *
+ * Only called by the GNSS task, with the decoded fix.
+ * A fix of a new epoch is also added to the history, clock and estimator and updates the velocity.
+ * A fix of the epoch already published (same time) only replaces its fields, and a fix with no_fix quality
+ * only clears the quality of the published fix so gnss_get_fix() stops returning it.
+ * Readers never wait for it: a sequence count tells gnss_get_fix() whether its copy was overwritten.
+ *
+ * @param gnss_obj is the GNSS object to publish the fix to.
+ * @param fix is the new fix.
+ * \return None
+ *
+ */
+void gnss_publish_fix(gnss_t *gnss_obj, const gnss_fix_t *fix);
+
 /*!
  * \brief disable GNSS interrupts
  *
@@ -14,53 +14,146 @@
 
 
 
+// ---------------------------------------------------------- //
+// -------------------- global variables -------------------- //
+// ---------------------------------------------------------- //
+
+// ----- sentence schemas ----- //
+#define FIX_OFFSET(member)          ( (uint8_t)offsetof(gnss_fix_t, member) )
+
+// global positioning system fix data
+static const gnss_nmea_schema_field_t gnss_nmea_gga_fields[] = {
+    {0, NMEA_FIELD_TIME,        FIX_OFFSET(time)},
+    {1, NMEA_FIELD_LATITUDE,    FIX_OFFSET(location.latitude)},
+    {2, NMEA_FIELD_NORTH_SOUTH, FIX_OFFSET(location.latitude)},
+    {3, NMEA_FIELD_LONGITUDE,   FIX_OFFSET(location.longitude)},
+    {4, NMEA_FIELD_EAST_WEST,   FIX_OFFSET(location.longitude)},
+    {5, NMEA_FIELD_QUALITY,     FIX_OFFSET(quality)},
+    {6, NMEA_FIELD_UINT8,       FIX_OFFSET(num_satellites)},
+    {7, NMEA_FIELD_CENTI,       FIX_OFFSET(hdop)},
+    {8, NMEA_FIELD_MILLI,       FIX_OFFSET(altitude_mm)}
+};
+
+// GNSS fix data
+static const gnss_nmea_schema_field_t gnss_nmea_gns_fields[] = {
+    {0, NMEA_FIELD_TIME,        FIX_OFFSET(time)},
+    {1, NMEA_FIELD_LATITUDE,    FIX_OFFSET(location.latitude)},
+    {2, NMEA_FIELD_NORTH_SOUTH, FIX_OFFSET(location.latitude)},
+    {3, NMEA_FIELD_LONGITUDE,   FIX_OFFSET(location.longitude)},
+    {4, NMEA_FIELD_EAST_WEST,   FIX_OFFSET(location.longitude)},
+    {5, NMEA_FIELD_MODE,        FIX_OFFSET(quality)},
+    {6, NMEA_FIELD_UINT8,       FIX_OFFSET(num_satellites)},
+    {7, NMEA_FIELD_CENTI,       FIX_OFFSET(hdop)},
+    {8, NMEA_FIELD_MILLI,       FIX_OFFSET(altitude_mm)}
+};
+
+// recommended minimum data
+static const gnss_nmea_schema_field_t gnss_nmea_rmc_fields[] = {
+    {0, NMEA_FIELD_TIME,        FIX_OFFSET(time)},
+    {1, NMEA_FIELD_STATUS,      FIX_OFFSET(quality)},
+    {2, NMEA_FIELD_LATITUDE,    FIX_OFFSET(location.latitude)},
+    {3, NMEA_FIELD_NORTH_SOUTH, FIX_OFFSET(location.latitude)},
+    {4, NMEA_FIELD_LONGITUDE,   FIX_OFFSET(location.longitude)},
+    {5, NMEA_FIELD_EAST_WEST,   FIX_OFFSET(location.longitude)},
+    {6, NMEA_FIELD_KNOTS,       FIX_OFFSET(speed_mmps)},
+    {7, NMEA_FIELD_MILLI,       FIX_OFFSET(course_mdeg)},
+    {11, NMEA_FIELD_MODE,       FIX_OFFSET(quality)}
+};
+
+// course over ground and ground speed
+static const gnss_nmea_schema_field_t gnss_nmea_vtg_fields[] = {
+    {0, NMEA_FIELD_MILLI,       FIX_OFFSET(course_mdeg)},
+    {4, NMEA_FIELD_KNOTS,       FIX_OFFSET(speed_mmps)}
+};
+
+// GNSS DOP and active satellites
+static const gnss_nmea_schema_field_t gnss_nmea_gsa_fields[] = {
+    {1, NMEA_FIELD_UINT8,       FIX_OFFSET(fix_mode)},
+    {14, NMEA_FIELD_CENTI,      FIX_OFFSET(pdop)},
+    {15, NMEA_FIELD_CENTI,      FIX_OFFSET(hdop)},
+    {16, NMEA_FIELD_CENTI,      FIX_OFFSET(vdop)}
+};
+
+#define SCHEMA(id, fields, position) {id, fields, sizeof(fields) / sizeof(fields[0]), position}
+
+static const gnss_nmea_schema_t gnss_nmea_gga_schema = SCHEMA(SENTENCE_GGA, gnss_nmea_gga_fields, true);
+static const gnss_nmea_schema_t gnss_nmea_gns_schema = SCHEMA(SENTENCE_GNS, gnss_nmea_gns_fields, true);
+static const gnss_nmea_schema_t gnss_nmea_rmc_schema = SCHEMA(SENTENCE_RMC, gnss_nmea_rmc_fields, true);
+static const gnss_nmea_schema_t gnss_nmea_vtg_schema = SCHEMA(SENTENCE_VTG, gnss_nmea_vtg_fields, false);
+static const gnss_nmea_schema_t gnss_nmea_gsa_schema = SCHEMA(SENTENCE_GSA, gnss_nmea_gsa_fields, false);
+
+// schemas indexed by the hash of their sentence ID
+static const gnss_nmea_schema_t * const gnss_nmea_schemas[GNSS_NMEA_SCHEMA_BUCKETS] = {
+    [GNSS_NMEA_HASH(SENTENCE_GGA)] = &gnss_nmea_gga_schema,
+    [GNSS_NMEA_HASH(SENTENCE_GNS)] = &gnss_nmea_gns_schema,
+    [GNSS_NMEA_HASH(SENTENCE_RMC)] = &gnss_nmea_rmc_schema,
+    [GNSS_NMEA_HASH(SENTENCE_VTG)] = &gnss_nmea_vtg_schema,
+    [GNSS_NMEA_HASH(SENTENCE_GSA)] = &gnss_nmea_gsa_schema
+};
+
+
+
+
+
 // ------------------------------------------------------------ //
 // -------------------- private prototypes -------------------- //
 // ------------------------------------------------------------ //
 
 /*!
- * \brief Decode a standard NMEA sentence
+ * \brief Identify the talker and sentence once the address has been received
+ *
+ * @param parser is the parser state
+ * \return None
+ */
+static void gnss_nmea_parse_address(gnss_nmea_parser_t *parser);
+
+/*!
+ * \brief Decode a field once its delimiter has been received
  *
- * @param gnss_obj is the GNSS object
- * @param sentence_id is the identifier code for the sentence type using the SENTENCE() macro
- * @param payload is a byte array containing the sentence payload
- * \return NMEA fault code
+ * @param parser is the parser state, with the converted field in parser->field
+ * \return None
  */
-static int8_t gnss_nmea_decode_standard_msg(gnss_t *gnss_obj, uint32_t sentence_id, uint8_t *payload);
+static void gnss_nmea_parse_field(gnss_nmea_parser_t *parser);
 
 /*!
- * \brief Decode a PUBX (Ublox proprietary) NMEA sentence
+ * \brief Decode a field of a standard NMEA sentence using the schema of the sentence
  *
- * @param gnss_obj is the GNSS object
- * @param sentence_id is proprietary PUBX sentence ID
- * @param payload is a byte array containing the sentence payload
- * \return NMEA fault code
+ * @param parser is the parser state
+ * \return None
+ */
+static void gnss_nmea_parse_schema_field(gnss_nmea_parser_t *parser);
+
+/*!
+ * \brief Start a new sentence, keeping the fix decoded so far
  *
+ * @param parser is the parser state
+ * \return None
  */
-static int8_t gnss_nmea_decode_PUBX(gnss_t *gnss_obj, uint8_t sentence_id, uint8_t *payload);
+static void gnss_nmea_parse_start(gnss_nmea_parser_t *parser);
 
 /*!
- * \brief Decode a field in a NMEA sentence
+ * \brief Decode a field of a PUBX (Ublox proprietary) NMEA sentence
+ *
+ * @param parser is the parser state
+ * \return None
  *
- * @param payload is a byte array containing the sentence payload
- * @param field is a pass by reference to the pointer indicating the start of the field
- * @format_data is a function pointer to the function that decodes the field
- * @param data is a void pointer to the data passed into the field decoder function
- * \return true if more fields remain in the sentence
  */
-static bool gnss_nmea_decode_field(uint8_t *payload, uint8_t **field, bool (*format_data)(uint8_t*, uint8_t*, void*), void *data);
+static void gnss_nmea_parse_PUBX_field(gnss_nmea_parser_t *parser);
 
 // ----- field formatting decoders ----- //
-static bool gnss_nmea_field_latitude(uint8_t *start, uint8_t *end, void *data);
-static bool gnss_nmea_field_longitude(uint8_t *start, uint8_t *end, void *data);
-static bool gnss_nmea_field_direction(uint8_t *start, uint8_t *end, void *data);
-static bool gnss_nmea_field_time(uint8_t *start, uint8_t *end, void *data);
-static bool gnss_nmea_field_char(uint8_t *start, uint8_t *end, void *data);
-static bool gnss_nmea_field_int32(uint8_t *start, uint8_t *end, void *data);
-static bool gnss_nmea_field_int8(uint8_t *start, uint8_t *end, void *data);
+static bool gnss_nmea_field_coordinate(gnss_nmea_field_t *field, uint8_t deg_digits, gnss_coordinate_t *coord);
+static bool gnss_nmea_field_direction(gnss_nmea_field_t *field, const char *hemispheres, gnss_coordinate_t *coord);
+static bool gnss_nmea_field_time(gnss_nmea_field_t *field, gnss_time_t *time);
+static bool gnss_nmea_field_fixed(gnss_nmea_field_t *field, uint8_t decimals, int32_t *output);
+static bool gnss_nmea_field_int8(gnss_nmea_field_t *field, uint8_t *output);
+static bool gnss_nmea_field_mode(gnss_nmea_field_t *field, gnss_quality_t *quality);
+static bool gnss_nmea_field_knots(gnss_nmea_field_t *field, int32_t *output);
 
 // ----- utility functions ----- //
-static inline long gnss_nmea_atoi(uint8_t *temp, uint8_t *ascii, uint8_t length);
+static inline void gnss_nmea_field_add(gnss_nmea_field_t *field, uint8_t datum);
+static inline void gnss_nmea_field_clear(gnss_nmea_field_t *field);
+static inline int8_t gnss_nmea_hex(uint8_t datum);
+static inline int32_t gnss_nmea_scale(int32_t fraction, uint8_t digits, uint8_t target);
 
 
 
@@ -83,199 +176,408 @@ bool gnss_nmea_queue(gnss_t *gnss_obj, uint8_t datum) {
     // check if end of a packet
     else if(gnss_obj->decoding_message && (datum == '\n') ) {
         gnss_obj->decoding_message = false;
-        ring_buff_write_finish_packet(buff);
-        end_of_packet = true;
-        // give semaphore
+        // keep the terminator so the decoder can find the end of the sentence
+        if(ring_buff_write(buff, datum)) {
+            ring_buff_write_finish_packet(buff);
+            end_of_packet = true;
+        }
+        else {
+            ring_buff_write_clear_packet(buff);
+            end_of_packet = false;
+        }
     }
     // contents of message
     else if(gnss_obj->decoding_message){
         ring_buff_write(buff, datum);
         end_of_packet = false;
     }
+    else {
+        end_of_packet = false;
+    }
 
     return end_of_packet;
 }
 
+uint8_t gnss_nmea_queue_span(gnss_t *gnss_obj, const uint8_t *data, uint16_t len) {
+    ring_buff_t *buff = &gnss_obj->gnss_rx_buff;
+    const uint8_t *end = data + len;
+    const uint8_t *run = data;
+    const uint8_t *ptr;
+    uint8_t finished = 0;
+
+    for(ptr = data; ptr < end; ptr++) {
+        // check if start of a packet
+        if(*ptr == '$') {
+            gnss_obj->decoding_message = true;
+            ring_buff_write_clear_packet(buff);
+            run = ptr + 1;
+        }
+        // check if end of a packet, keeping the terminator
+        else if(gnss_obj->decoding_message && (*ptr == '\n') ) {
+            gnss_obj->decoding_message = false;
+            ring_buff_write_block(buff, run, ptr + 1 - run);
+            if(ring_buff_write_finish_packet(buff) > 0) {
+                finished++;
+            }
+        }
+    }
+
+    // contents of a message that continues in the next span
+    if(gnss_obj->decoding_message && (run < end)) {
+        ring_buff_write_block(buff, run, end - run);
+    }
+
+    return finished;
+}
+
+void gnss_nmea_parse_init(gnss_nmea_parser_t *parser) {
+    gnss_nmea_parse_start(parser);
+    parser->state = NMEA_STATE_IDLE;
+    parser->fix = (gnss_fix_t){.quality = no_fix};
+}
+
+int8_t gnss_nmea_parse(gnss_nmea_parser_t *parser, uint8_t datum) {
+    int8_t digit;
+    int8_t result;
+
+    // a new sentence can start at any point, dropping any partial sentence
+    if(datum == '$') {
+        gnss_nmea_parse_start(parser);
+        return NMEA_SENTENCE_PENDING;
+    }
+
+    // end of a sentence, only accepted with a matching checksum
+    if(datum == '\n') {
+        if(parser->state == NMEA_STATE_IDLE) {
+            return NMEA_SENTENCE_PENDING;
+        }
+        if( (parser->state == NMEA_STATE_END) && (parser->checksum_digits == 2) && (parser->received_checksum == parser->checksum) ) {
+            result = parser->fault;
+        }
+        else {
+            result = NMEA_CHECKSUM_MISMATCH;
+        }
+        parser->state = NMEA_STATE_IDLE;
+        return result;
+    }
+
+    switch(parser->state) {
+    // outside of a sentence
+    case NMEA_STATE_IDLE:
+        break;
+    // talker and sentence IDs
+    case NMEA_STATE_ADDRESS:
+        if(datum == '*') {
+            if(parser->address_len == 5) {
+                gnss_nmea_parse_address(parser);
+            }
+            parser->state = NMEA_STATE_CHECKSUM;
+            break;
+        }
+        parser->checksum ^= datum;
+        if(parser->address_len < 5) {
+            parser->address[parser->address_len++] = datum;
+            // PUBX addresses include the delimiter before the first field
+            if( (parser->address_len == 5) && (parser->address[4] == ',') ) {
+                gnss_nmea_parse_address(parser);
+                parser->state = NMEA_STATE_FIELD;
+            }
+        }
+        else if(datum == ',') {
+            gnss_nmea_parse_address(parser);
+            parser->state = NMEA_STATE_FIELD;
+        }
+        else if(parser->fault == NMEA_NO_FAULT) {
+            parser->fault = NMEA_UNKNOWN_SENTENCE;
+        }
+        break;
+    // data fields
+    case NMEA_STATE_FIELD:
+        if(datum == '*') {
+            gnss_nmea_parse_field(parser);
+            parser->state = NMEA_STATE_CHECKSUM;
+            break;
+        }
+        parser->checksum ^= datum;
+        if(datum == ',') {
+            gnss_nmea_parse_field(parser);
+            gnss_nmea_field_clear(&parser->field);
+            parser->field_idx++;
+        }
+        else {
+            gnss_nmea_field_add(&parser->field, datum);
+        }
+        break;
+    // two hex digits after '*'
+    case NMEA_STATE_CHECKSUM:
+        digit = gnss_nmea_hex(datum);
+        if(digit < 0) {
+            parser->checksum_digits = 0;
+            parser->state = NMEA_STATE_END;
+            break;
+        }
+        parser->received_checksum = (parser->received_checksum << 4) | digit;
+        if(++parser->checksum_digits == 2) {
+            parser->state = NMEA_STATE_END;
+        }
+        break;
+    // only "\r\n" may follow the checksum
+    case NMEA_STATE_END:
+        if(datum != '\r') {
+            parser->checksum_digits = 0;
+        }
+        break;
+    }
+
+    return NMEA_SENTENCE_PENDING;
+}
+
 int8_t gnss_nmea_decode(gnss_t *gnss_obj) {
-    uint8_t address[5];
-    uint8_t payload[GNSS_RX_MAX_PAYLOAD];
-    uint16_t payload_size = 0;
+    gnss_nmea_parser_t parser;
+    ring_buff_span_t span[2];
     ring_buff_t *buff = &gnss_obj->gnss_rx_buff;
+    uint16_t length;
+    uint16_t i;
+    uint8_t seg;
+    int8_t result = NMEA_SENTENCE_PENDING;
+
+    // locate the oldest finished sentence in place
+    length = ring_buff_peek_packet(buff, span);
+    if(length == 0) {
+        return NMEA_EMPTY_BUFFER;
+    }
 
-    // read in address
-    uint16_t talker;
-    uint32_t sentence;
-    uint8_t i = 0;
-    for(i = 0; i < 5; i++) {
-        if(!ring_buff_read(buff, address + i)) {
-            return NMEA_EMPTY_BUFFER;
+    // merge the sentence into the last fix. the '$' that starts it isn't stored in the ring buffer
+    gnss_nmea_parse_init(&parser);
+    parser.fix = gnss_obj->last_fix;
+    gnss_nmea_parse(&parser, '$');
+    for(seg = 0; seg < 2; seg++) {
+        for(i = 0; (i < span[seg].len) && (result == NMEA_SENTENCE_PENDING); i++) {
+            result = gnss_nmea_parse(&parser, span[seg].data[i]);
         }
     }
-    talker = TALKER(address[0], address[1]);
-    sentence = SENTENCE(address[2], address[3], address[4]);
 
-    // read in payload
-    i = 0;
-    do {
-        if(!ring_buff_read(buff, payload + i)) {
-            return NMEA_EMPTY_BUFFER;
+    // mark the whole sentence as read, including the checksum and terminator
+    ring_buff_consume_packet(buff, length);
+
+    // stored sentences always end in '\n', so a pending sentence was cut short
+    if(result == NMEA_SENTENCE_PENDING) {
+        result = NMEA_CHECKSUM_MISMATCH;
+    }
+
+    if( (result == NMEA_NO_FAULT) && (parser.schema != NULL) ) {
+        if(parser.schema->position) {
+            // empty fields keep the values of the last fix, so a fix needs its own time, position and quality
+            if( (parser.decoded & NMEA_DECODED_FIX) != NMEA_DECODED_FIX ) {
+                parser.fix.quality = no_fix;
+            }
+            gnss_publish_fix(gnss_obj, &parser.fix);
+        }
+        else if( (gnss_obj->last_fix.quality != no_fix) &&
+                 ((TickType_t)(xTaskGetTickCount() - gnss_obj->epoch_tick) < GNSS_EPOCH_WINDOW / portTICK_RATE_MS) &&
+                 (memcmp(&parser.fix, (const void *)&gnss_obj->last_fix, sizeof(gnss_fix_t)) != 0) ) {
+            gnss_publish_fix(gnss_obj, &parser.fix);
+        }
+
+        if(gnss_obj->last_fix.quality != no_fix) {
+            GPIO_setOutputHighOnPin(GPIO_PORT_P8, GPIO_PIN4);
+        } else {
+            GPIO_setOutputLowOnPin(GPIO_PORT_P8, GPIO_PIN4);
         }
-        i++;
+    }
+    return result;
+}
+
 
-        // enure payload isn't too long
-        if(i > GNSS_RX_MAX_PAYLOAD) return NMEA_PAYLOAD_OVERFLOW;
-    } while(payload[i-1] != '*');
 
-    // read in checksum
-    char checksum_ascii[3] = {'0','0','\0'};
-    uint8_t checksum;
-    ring_buff_read(buff, (uint8_t*)checksum_ascii);
-    ring_buff_read(buff, (uint8_t*)(checksum_ascii + 1));
-    checksum = strtol(checksum_ascii, NULL, 16);
 
-    // mark packet as read
-    ring_buff_read_finish_packet(buff);
 
-    uint8_t temp[3];
-    switch (talker) {
+// ----------------------------------------------------- //
+// -------------------- private API -------------------- //
+// ----------------------------------------------------- //
+
+static void gnss_nmea_parse_address(gnss_nmea_parser_t *parser) {
+    const gnss_nmea_schema_t *schema;
+
+    parser->talker = TALKER(parser->address[0], parser->address[1]);
+    parser->sentence = SENTENCE(parser->address[2], parser->address[3], parser->address[4]);
+
+    if(parser->fault != NMEA_NO_FAULT) {
+        return;
+    }
+
+    switch (parser->talker) {
     // GPS message
     case TALKER_GPS:
-        return gnss_nmea_decode_standard_msg(gnss_obj, sentence, payload);
     // GLONASS message
     case TALKER_GLONASS:
-        return gnss_nmea_decode_standard_msg(gnss_obj, sentence, payload);
     // Galileo message
     case TALKER_GALILEO:
-        return gnss_nmea_decode_standard_msg(gnss_obj, sentence, payload);
     // BeiDou message
     case TALKER_BEIDOU:
-        return gnss_nmea_decode_standard_msg(gnss_obj, sentence, payload);
     // multiple GNSS combination message
     case TALKER_GNSS:
-        return gnss_nmea_decode_standard_msg(gnss_obj, sentence, payload);
+        switch (parser->sentence) {
+        case SENTENCE_DTM:
+        case SENTENCE_GBQ:
+        case SENTENCE_GBS:
+        case SENTENCE_GGA:
+        case SENTENCE_GLL:
+        case SENTENCE_GLQ:
+        case SENTENCE_GNQ:
+        case SENTENCE_GNS:
+        case SENTENCE_GPQ:
+        case SENTENCE_GRS:
+        case SENTENCE_GSA:
+        case SENTENCE_GST:
+        case SENTENCE_GSV:
+        case SENTENCE_RMC:
+        case SENTENCE_TXT:
+        case SENTENCE_VLW:
+        case SENTENCE_VTG:
+        case SENTENCE_ZDA:
+            schema = gnss_nmea_schemas[GNSS_NMEA_HASH(parser->sentence)];
+            if( (schema != NULL) && (schema->sentence == parser->sentence) ) {
+                parser->schema = schema;
+            }
+            break;
+        // unknown sentence format
+        default:
+            parser->fault = NMEA_UNKNOWN_SENTENCE;
+            break;
+        }
+        break;
     // proprietary PUBX message
     case TALKER_UBX:
-        switch (sentence) {
         // all PUBX messages have the same sentence format field
-        case SENTENCE_UBX:
-            return gnss_nmea_decode_PUBX(gnss_obj, gnss_nmea_atoi(temp, payload, 2), payload);
-        // invalid proprietary sentence format
-        default:
-            return NMEA_UNKNOWN_PROPRIETARY;
+        if(parser->sentence != SENTENCE_UBX) {
+            parser->fault = NMEA_UNKNOWN_PROPRIETARY;
         }
+        break;
     // unknown talker
     default:
-        return NMEA_UNKNOWN_TALKER;
+        parser->fault = NMEA_UNKNOWN_TALKER;
+        break;
     }
 }
 
+static void gnss_nmea_parse_field(gnss_nmea_parser_t *parser) {
+    // nothing more to decode from a sentence that is already rejected
+    if(parser->fault != NMEA_NO_FAULT) {
+        return;
+    }
 
+    if(parser->talker == TALKER_UBX) {
+        gnss_nmea_parse_PUBX_field(parser);
+    }
+    else if(parser->schema != NULL) {
+        gnss_nmea_parse_schema_field(parser);
+    }
+}
 
+static void gnss_nmea_parse_schema_field(gnss_nmea_parser_t *parser) {
+    const gnss_nmea_schema_t *schema = parser->schema;
+    const gnss_nmea_schema_field_t *entry;
+    gnss_nmea_field_t *field = &parser->field;
+    uint8_t *data;
+    uint8_t value;
+    bool valid = true;
+
+    // schema entries are in field order, so only the next one can match
+    if( (parser->schema_pos >= schema->num_fields) || (schema->fields[parser->schema_pos].field_idx != parser->field_idx) ) {
+        return;
+    }
+    entry = &schema->fields[parser->schema_pos++];
+    data = (uint8_t *)&parser->fix + entry->offset;
 
-
-// ----------------------------------------------------- //
-// -------------------- private API -------------------- //
-// ----------------------------------------------------- //
-
-static int8_t gnss_nmea_decode_standard_msg(gnss_t *gnss_obj, uint32_t sentence_id, uint8_t *payload) {
-    uint8_t *ptr = payload;
-    gnss_fix_t current_fix = {.quality = no_fix};
-    switch (sentence_id) {
-        // datum reference
-        case SENTENCE_DTM:
-
+    switch (entry->type) {
+        case NMEA_FIELD_TIME:
+            valid = gnss_nmea_field_time(field, (gnss_time_t *)data);
+            parser->decoded |= valid ? NMEA_DECODED_TIME : 0;
             break;
-        // poll a standard message (if current talker ID is GB)
-        case SENTENCE_GBQ:
-
+        case NMEA_FIELD_LATITUDE:
+            valid = gnss_nmea_field_coordinate(field, 2, (gnss_coordinate_t *)data);
+            parser->decoded |= valid ? NMEA_DECODED_LATITUDE : 0;
             break;
-        // GNSS satellite fault detection
-        case SENTENCE_GBS:
-
+        case NMEA_FIELD_LONGITUDE:
+            valid = gnss_nmea_field_coordinate(field, 3, (gnss_coordinate_t *)data);
+            parser->decoded |= valid ? NMEA_DECODED_LONGITUDE : 0;
             break;
-        // global positioning system fix data
-        case SENTENCE_GGA:
-            gnss_nmea_decode_field(payload, &ptr, &gnss_nmea_field_time, &(current_fix.time));
-            gnss_nmea_decode_field(payload, &ptr, &gnss_nmea_field_latitude, &(current_fix.location.latitude));
-            gnss_nmea_decode_field(payload, &ptr, &gnss_nmea_field_direction, &(current_fix.location.latitude));
-            gnss_nmea_decode_field(payload, &ptr, &gnss_nmea_field_longitude, &(current_fix.location.longitude));
-            gnss_nmea_decode_field(payload, &ptr, &gnss_nmea_field_direction, &(current_fix.location.longitude));
-            gnss_nmea_decode_field(payload, &ptr, &gnss_nmea_field_int8, &(current_fix.quality));
-            gnss_nmea_decode_field(payload, &ptr, &gnss_nmea_field_int8, &(current_fix.num_satellites));
-            gnss_nmea_decode_field(payload, &ptr, NULL, NULL);
-            gnss_nmea_decode_field(payload, &ptr, &gnss_nmea_field_int32, &(current_fix.altitude));
-            if( (current_fix.quality != no_fix) && (current_fix.quality != 0xFFFF)) {
-                gnss_obj->last_fix = current_fix;
-                GPIO_setOutputHighOnPin(GPIO_PORT_P8, GPIO_PIN4);
-            } else {
-                GPIO_setOutputLowOnPin(GPIO_PORT_P8, GPIO_PIN4);
-            }
+        // the coordinate before the hemisphere is marked invalid until the hemisphere is decoded
+        case NMEA_FIELD_NORTH_SOUTH:
+            valid = gnss_nmea_field_direction(field, "NS", (gnss_coordinate_t *)data);
+            parser->decoded &= valid ? 0xFF : ~NMEA_DECODED_LATITUDE;
             break;
-        // lattitude and longitude, with time of position fix and status
-        case SENTENCE_GLL:
-
+        case NMEA_FIELD_EAST_WEST:
+            valid = gnss_nmea_field_direction(field, "EW", (gnss_coordinate_t *)data);
+            parser->decoded &= valid ? 0xFF : ~NMEA_DECODED_LONGITUDE;
             break;
-        // poll a standard message (if current talker ID is GL)
-        case SENTENCE_GLQ:
-
+        case NMEA_FIELD_QUALITY:
+            // an empty quality field means no fix
+            *(gnss_quality_t *)data = gnss_nmea_field_int8(field, &value) ? (gnss_quality_t)value : no_fix;
+            parser->decoded |= NMEA_DECODED_QUALITY;
             break;
-        // poll a standard message (if current talker ID is GN)
-        case SENTENCE_GNQ:
-
+        case NMEA_FIELD_MODE:
+            parser->decoded |= gnss_nmea_field_mode(field, (gnss_quality_t *)data) ? NMEA_DECODED_QUALITY : 0;
             break;
-        // GNSS fix data
-        case SENTENCE_GNS:
-
+        case NMEA_FIELD_STATUS:
+            if( (field->len != 1) || (field->chr != 'A') ) {
+                *(gnss_quality_t *)data = no_fix;
+            }
             break;
-        // poll a standard message (if current talker ID is GP)
-        case SENTENCE_GPQ:
-
+        case NMEA_FIELD_UINT8:
+            valid = gnss_nmea_field_int8(field, data);
             break;
-        // GNSS range residuals
-        case SENTENCE_GRS:
-
+        case NMEA_FIELD_CENTI: {
+            int32_t centi;
+            valid = gnss_nmea_field_fixed(field, 2, &centi) && (centi >= 0) && (centi <= 0xFFFF);
+            if(valid) {
+                *(uint16_t *)data = centi;
+            }
             break;
-        // GNSS DOP and active satellites
-        case SENTENCE_GSA:
-
+        }
+        case NMEA_FIELD_MILLI:
+            valid = gnss_nmea_field_fixed(field, 3, (int32_t *)data);
             break;
-        // GNSS pseduo range error statistics
-        case SENTENCE_GST:
-
+        case NMEA_FIELD_KNOTS:
+            valid = gnss_nmea_field_knots(field, (int32_t *)data);
             break;
-        // GNSS satellites in view
-        case SENTENCE_GSV:
-
+        default:
             break;
-        // recommended minimum data
-        case SENTENCE_RMC:
+    }
 
-            break;
-        // text transmission
-        case SENTENCE_TXT:
-            __no_operation();
-            break;
-        // dual ground/water distance
-        case SENTENCE_VLW:
+    // empty fields are left out when there is no fix, but a malformed field rejects the sentence
+    if( !valid && (field->len != 0) && (parser->fault == NMEA_NO_FAULT) ) {
+        parser->fault = NMEA_BAD_FIELD;
+    }
+}
 
-            break;
-        // course over ground and ground speed
-        case SENTENCE_VTG:
+static void gnss_nmea_parse_start(gnss_nmea_parser_t *parser) {
+    parser->state = NMEA_STATE_ADDRESS;
+    parser->checksum = 0;
+    parser->received_checksum = 0;
+    parser->checksum_digits = 0;
+    parser->address_len = 0;
+    parser->talker = 0;
+    parser->sentence = 0;
+    parser->field_idx = 0;
+    parser->fault = NMEA_NO_FAULT;
+    parser->schema = NULL;
+    parser->schema_pos = 0;
+    parser->decoded = 0;
+    gnss_nmea_field_clear(&parser->field);
+}
 
-            break;
-        // time and date
-        case SENTENCE_ZDA:
+static void gnss_nmea_parse_PUBX_field(gnss_nmea_parser_t *parser) {
+    uint8_t msg_id = 0xFF;
 
-            break;
-        // unknown sentence format
-        default:
-            return NMEA_UNKNOWN_SENTENCE;
+    // only the message ID is decoded
+    if(parser->field_idx != 0) {
+        return;
     }
-    return NMEA_NO_FAULT;
-}
 
-static int8_t gnss_nmea_decode_PUBX(gnss_t *gnss_obj, uint8_t sentence_id, uint8_t *payload) {
-    switch(sentence_id) {
+    gnss_nmea_field_int8(&parser->field, &msg_id);
+    switch(msg_id) {
         // lat/long position data
         case SENTENCE_UBX_POSITION:
 
@@ -290,162 +592,205 @@ static int8_t gnss_nmea_decode_PUBX(gnss_t *gnss_obj, uint8_t sentence_id, uint8
             break;
         // unknown sentence format
         default:
-            return NMEA_UNKNOWN_SENTENCE;
-    }
-    return NMEA_NO_FAULT;
-}
-
-static bool gnss_nmea_decode_field(uint8_t *payload, uint8_t **field, bool (*format_data)(uint8_t*, uint8_t*, void*), void *data) {
-    uint8_t *start;
-    if(**field == ',') {
-        *field += 1;
-    }
-    start = *field;
-    while(*field < (payload + GNSS_RX_MAX_PAYLOAD)) {
-        if(**field == '*') {
-            if(format_data != NULL) {
-                format_data(start, *field, data);
-            }
-            return false;
-        }
-        if(**field == ',') {
-            if(format_data != NULL) {
-                format_data(start, *field, data);
-            }
-            return true;
-        }
-        *field += 1;
+            parser->fault = NMEA_UNKNOWN_SENTENCE;
+            break;
     }
-    return false;
 }
 
-static bool gnss_nmea_field_latitude(uint8_t *start, uint8_t *end, void *data) {
-    gnss_coordinate_t *coord = (gnss_coordinate_t*)data;
-    uint8_t temp[6];
+static bool gnss_nmea_field_coordinate(gnss_nmea_field_t *field, uint8_t deg_digits, gnss_coordinate_t *coord) {
+    uint32_t decMilliSec;
 
-    // ensure the correct length
-    if( (end - start) != 10) {
+    // ensure the correct format: (d)ddmm.m(mmmm)
+    if( !field->numeric || field->negative || (field->int_digits != deg_digits + 2) || (field->frac_digits == 0)
+        || ((field->integer % 100) >= 60) ) {
         return false;
     }
 
-    // initialize direction to be invalid
-    coord->dir = 'e';
-
     // degrees
-    coord->decMilliSec = ((uint32_t)gnss_nmea_atoi(temp, start, 2)) * 3600000;
-    start += 2;
+    decMilliSec = ((uint32_t)(field->integer / 100)) * 3600000;
     // minutes
-    coord->decMilliSec += ((uint32_t)gnss_nmea_atoi(temp, start, 2)) * 60000;
-    start += 2;
-
-    // milliseconds
-    start++; // skip decimal place
-    coord->decMilliSec += ((uint32_t)gnss_nmea_atoi(temp, start, 5));
-    return true;
-}
+    decMilliSec += ((uint32_t)(field->integer % 100)) * 60000;
+    // milliseconds, rounded from 1e-5 minutes (0.6 ms)
+    decMilliSec += ((uint32_t)gnss_nmea_scale(field->fraction, field->frac_digits, 5) * 3 + 2) / 5;
 
-static bool gnss_nmea_field_longitude(uint8_t *start, uint8_t *end, void *data) {
-    gnss_coordinate_t *coord = (gnss_coordinate_t*)data;
-    uint8_t temp[6];
-
-
-    // ensure the correct length
-    if( (end - start) != 11) {
+    // up to 90 or 180 degrees, minutes included
+    if(decMilliSec > ((deg_digits == 2) ? 90 : 180) * GNSS_MSEC_ARC_PER_DEG) {
         return false;
     }
 
     // initialize direction to be invalid
     coord->dir = 'e';
+    coord->decMilliSec = decMilliSec;
+    return true;
+}
 
-    // degrees
-    coord->decMilliSec = ((uint32_t)gnss_nmea_atoi(temp, start, 3)) * 3600000;
-    start += 3;
-    // minutes
-    coord->decMilliSec += ((uint32_t)gnss_nmea_atoi(temp, start, 2)) * 60000;
-    start += 2;
+static bool gnss_nmea_field_direction(gnss_nmea_field_t *field, const char *hemispheres, gnss_coordinate_t *coord) {
+    // ensure correct length and one of the two hemispheres of the axis
+    if( (field->len != 1) || ((field->chr != hemispheres[0]) && (field->chr != hemispheres[1])) ) {
+        return false;
+    }
 
-    // milliseconds
-    start++; // skip decimal place
-    coord->decMilliSec += ((uint32_t)gnss_nmea_atoi(temp, start, 5));
+    coord->dir = field->chr;
     return true;
 }
 
-static bool gnss_nmea_field_direction(uint8_t *start, uint8_t *end, void *data) {
-    gnss_coordinate_t *coord = (gnss_coordinate_t*)data;
-    // ensure correct length
-    if( (end - start) != 1) {
+static bool gnss_nmea_field_time(gnss_nmea_field_t *field, gnss_time_t *time) {
+    // ensure the correct format: hhmmss.ss (up to a leap second)
+    if( !field->numeric || field->negative || (field->int_digits != 6) || (field->integer / 10000 >= 24)
+        || ((field->integer / 100) % 100 >= 60) || (field->integer % 100 > 60) ) {
         return false;
     }
 
-    coord->dir = *start;
+    time->hour = field->integer / 10000;
+    time->min = (field->integer / 100) % 100;
+    time->msec = 1000 * (field->integer % 100) + gnss_nmea_scale(field->fraction, field->frac_digits, 3);
     return true;
 }
 
-static bool gnss_nmea_field_time(uint8_t *start, uint8_t *end, void *data) {
-    gnss_time_t *time = (gnss_time_t*)data;
-    uint8_t temp[3];
+static bool gnss_nmea_field_fixed(gnss_nmea_field_t *field, uint8_t decimals, int32_t *output) {
+    int32_t value = field->integer;
+    int32_t fraction;
+    uint8_t i;
 
-    // ensure correct length
-    if( (end - start) != 9) {
+    if( (field->len == 0) || !field->numeric ) {
         return false;
     }
 
-    // hours
-    time->hour = gnss_nmea_atoi(temp, start, 2);
-    start += 2;
-
-    // minutes
-    time->min = gnss_nmea_atoi(temp, start, 2);
-    start += 2;
-
-    // seconds
-    time->msec = 1000 * gnss_nmea_atoi(temp, start, 2);
-    start += 2;
+    // fixed point with the given number of decimal places, truncating any further digits
+    for(i = 0; i < decimals; i++) {
+        if(value > INT32_MAX / 10) {
+            return false;
+        }
+        value *= 10;
+    }
+    fraction = gnss_nmea_scale(field->fraction, field->frac_digits, decimals);
+    if(value > INT32_MAX - fraction) {
+        return false;
+    }
+    value += fraction;
 
-    // milliseconds
-    start++; // skip decimal place
-    time->msec += 10 * gnss_nmea_atoi(temp, start, 2);
+    *output = field->negative ? -value : value;
     return true;
 }
 
-static bool gnss_nmea_field_char(uint8_t *start, uint8_t *end, void *data) {
-    char *output = (char *)data;
-    // ensure correct length
-    if( (end - start) != 1) {
-        *output = 0;
+static bool gnss_nmea_field_int8(gnss_nmea_field_t *field, uint8_t *output) {
+    if( (field->len == 0) || !field->numeric || field->negative || (field->integer > 0xFF) ) {
+        *output = 0xFF;
         return false;
     }
 
-    *output = *start;
+    *output = field->integer;
     return true;
 }
 
-static bool gnss_nmea_field_int32(uint8_t *start, uint8_t *end, void *data) {
-    int32_t *output = (int32_t *)data;
-    uint8_t temp[10];
-    if( (end - start) == 0) {
-        *output = 0xFFFFFFFF;
+static bool gnss_nmea_field_mode(gnss_nmea_field_t *field, gnss_quality_t *quality) {
+    if(field->len == 0) {
         return false;
     }
 
-    *output = gnss_nmea_atoi(temp, start, end - start);
+    // the first character is the mode of the combined solution
+    switch(field->chr) {
+    case 'A':
+        *quality = auto_fix;
+        break;
+    case 'D':
+        *quality = diff_fix;
+        break;
+    case 'R':
+        *quality = rtk_fix;
+        break;
+    case 'F':
+        *quality = rtk_float;
+        break;
+    case 'E':
+        *quality = dead_reckon;
+        break;
+    default:
+        *quality = no_fix;
+        break;
+    }
     return true;
 }
 
-static bool gnss_nmea_field_int8(uint8_t *start, uint8_t *end, void *data) {
-    uint8_t *output = (uint8_t*)data;
-    uint8_t temp[10];
-    if( (end - start) == 0) {
-        *output = 0xFF;
+static bool gnss_nmea_field_knots(gnss_nmea_field_t *field, int32_t *output) {
+    int32_t milli_knots;
+
+    // 1 knot = 463/900 m/s
+    if( !gnss_nmea_field_fixed(field, 3, &milli_knots) || (milli_knots > INT32_MAX / 463) || (milli_knots < -INT32_MAX / 463) ) {
         return false;
     }
 
-    *output = gnss_nmea_atoi(temp, start, end - start);
+    *output = milli_knots * 463 / 900;
     return true;
 }
 
-static inline long gnss_nmea_atoi(uint8_t *temp, uint8_t *ascii, uint8_t length) {
-    temp[length] = '\0';
-    memcpy(temp, ascii, length);
-    return atol((char *)temp);
+static inline void gnss_nmea_field_add(gnss_nmea_field_t *field, uint8_t datum) {
+    if(field->len == 0) {
+        field->chr = datum;
+    }
+    if(field->len < 0xFF) {
+        field->len++;
+    }
+
+    if( (datum >= '0') && (datum <= '9') ) {
+        // digits beyond the supported precision are dropped from the fraction
+        if(field->decimal) {
+            if(field->frac_digits < GNSS_NMEA_MAX_DIGITS) {
+                field->fraction = 10 * field->fraction + (datum - '0');
+                field->frac_digits++;
+            }
+        }
+        else if(field->int_digits < GNSS_NMEA_MAX_DIGITS) {
+            field->integer = 10 * field->integer + (datum - '0');
+            field->int_digits++;
+        }
+        else {
+            field->numeric = false;
+        }
+    }
+    else if( (datum == '.') && !field->decimal ) {
+        field->decimal = true;
+    }
+    else if( (datum == '-') && (field->len == 1) ) {
+        field->negative = true;
+    }
+    else {
+        field->numeric = false;
+    }
+}
+
+static inline void gnss_nmea_field_clear(gnss_nmea_field_t *field) {
+    field->integer = 0;
+    field->fraction = 0;
+    field->int_digits = 0;
+    field->frac_digits = 0;
+    field->len = 0;
+    field->negative = false;
+    field->decimal = false;
+    field->numeric = true;
+    field->chr = 0;
+}
+
+static inline int32_t gnss_nmea_scale(int32_t fraction, uint8_t digits, uint8_t target) {
+    // change the number of decimal places of a fraction, truncating
+    for(; digits < target; digits++) {
+        fraction *= 10;
+    }
+    for(; digits > target; digits--) {
+        fraction /= 10;
+    }
+    return fraction;
+}
+
+static inline int8_t gnss_nmea_hex(uint8_t datum) {
+    if( (datum >= '0') && (datum <= '9') ) {
+        return datum - '0';
+    }
+    if( (datum >= 'A') && (datum <= 'F') ) {
+        return datum - 'A' + 10;
+    }
+    if( (datum >= 'a') && (datum <= 'f') ) {
+        return datum - 'a' + 10;
+    }
+    return -1;
 }
@@ -15,6 +15,7 @@ extern "C" {
 
 // standard libraries
 #include <stdint.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 // application drivers
@@ -31,6 +32,13 @@ extern "C" {
 #define TALKER(x,y)                 ( (x << 8) | y )
 #define SENTENCE(x,y,z)             ( ( (uint32_t)x << 16 ) | ( (uint32_t)y << 8 ) | (uint32_t)z )
 
+// most digits converted on either side of the decimal point of a numeric field
+#define GNSS_NMEA_MAX_DIGITS        9
+
+// sentence schema lookup table, the hash must not collide between sentences with a schema
+#define GNSS_NMEA_SCHEMA_BUCKETS    16
+#define GNSS_NMEA_HASH(id)          ( ( (id) ^ ((id) >> 8) ) & (GNSS_NMEA_SCHEMA_BUCKETS - 1) )
+
 // ----- Talker IDs ----- //
 #define TALKER_UBX                  TALKER('P','U')
 #define TALKER_GPS                  TALKER('G','P')
@@ -72,6 +80,117 @@ extern "C" {
 #define NMEA_UNKNOWN_PROPRIETARY     -3
 #define NMEA_PAYLOAD_OVERFLOW        -4
 #define NMEA_EMPTY_BUFFER            -5
+#define NMEA_CHECKSUM_MISMATCH       -6
+#define NMEA_BAD_FIELD               -7
+#define NMEA_FAULTS                  8       // number of fault codes including NMEA_NO_FAULT
+
+// ----- NMEA Parser Status ----- //
+#define NMEA_SENTENCE_PENDING        1
+
+// ----- Fields decoded from the current sentence ----- //
+#define NMEA_DECODED_TIME            0x01
+#define NMEA_DECODED_LATITUDE        0x02
+#define NMEA_DECODED_LONGITUDE       0x04
+#define NMEA_DECODED_QUALITY         0x08
+#define NMEA_DECODED_FIX             (NMEA_DECODED_TIME | NMEA_DECODED_LATITUDE | NMEA_DECODED_LONGITUDE | NMEA_DECODED_QUALITY)
+
+
+
+
+
+// ---------------------------------------------------------- //
+// -------------------- type definitions -------------------- //
+// ---------------------------------------------------------- //
+
+/** @enum gnss_nmea_parse_state_t
+ *  @brief position of the streaming parser within a sentence
+ *
+ */
+typedef enum {
+    NMEA_STATE_IDLE,            /**< waiting for the '$' that starts a sentence */
+    NMEA_STATE_ADDRESS,         /**< reading the talker and sentence IDs */
+    NMEA_STATE_FIELD,           /**< reading the data fields */
+    NMEA_STATE_CHECKSUM,        /**< reading the two checksum digits after '*' */
+    NMEA_STATE_END              /**< waiting for the '\n' that ends a sentence */
+} gnss_nmea_parse_state_t;
+
+/** @enum gnss_nmea_field_type_t
+ *  @brief decoder used for a field of a sentence schema
+ *
+ */
+typedef enum {
+    NMEA_FIELD_TIME,            /**< hhmmss.ss into gnss_time_t */
+    NMEA_FIELD_LATITUDE,        /**< ddmm.mmmmm into gnss_coordinate_t */
+    NMEA_FIELD_LONGITUDE,       /**< dddmm.mmmmm into gnss_coordinate_t */
+    NMEA_FIELD_NORTH_SOUTH,     /**< N/S hemisphere into gnss_coordinate_t, a latitude is only decoded with it */
+    NMEA_FIELD_EAST_WEST,       /**< E/W hemisphere into gnss_coordinate_t, a longitude is only decoded with it */
+    NMEA_FIELD_QUALITY,         /**< GGA quality indicator into gnss_quality_t */
+    NMEA_FIELD_MODE,            /**< positioning mode character into gnss_quality_t */
+    NMEA_FIELD_STATUS,          /**< A (valid) or V (invalid) into gnss_quality_t, only clears it */
+    NMEA_FIELD_UINT8,           /**< integer into uint8_t */
+    NMEA_FIELD_CENTI,           /**< decimal into uint16_t hundredths */
+    NMEA_FIELD_MILLI,           /**< decimal into int32_t thousandths */
+    NMEA_FIELD_KNOTS            /**< knots into int32_t mm/s */
+} gnss_nmea_field_type_t;
+
+/** @struct gnss_nmea_schema_field_t
+ *  @brief decoder of one field of a sentence
+ *
+ */
+typedef struct {
+    uint8_t field_idx;          /**< index of the field, 0 is the first field after the address */
+    uint8_t type;               /**< gnss_nmea_field_type_t of the field */
+    uint8_t offset;             /**< offset of the decoded value in gnss_fix_t */
+} gnss_nmea_schema_field_t;
+
+/** @struct gnss_nmea_schema_t
+ *  @brief fields decoded from a sentence, in order of field index
+ *
+ */
+typedef struct {
+    uint32_t sentence;          /**< sentence ID using the SENTENCE() macro */
+    const gnss_nmea_schema_field_t *fields;
+    uint8_t num_fields;
+    bool position;              /**< the sentence reports the time, position and quality of its own epoch */
+} gnss_nmea_schema_t;
+
+/** @struct gnss_nmea_field_t
+ *  @brief field of a sentence, converted as its characters arrive
+ *
+ */
+typedef struct {
+    int32_t integer;            /**< value of the digits before the decimal point */
+    int32_t fraction;           /**< value of the digits after the decimal point */
+    uint8_t int_digits;         /**< number of digits before the decimal point */
+    uint8_t frac_digits;        /**< number of digits after the decimal point */
+    uint8_t len;                /**< number of characters in the field */
+    bool negative;              /**< field starts with '-' */
+    bool decimal;               /**< decimal point received */
+    bool numeric;               /**< false once a character that isn't part of a number is received */
+    char chr;                   /**< first character of the field */
+} gnss_nmea_field_t;
+
+/** @struct gnss_nmea_parser_t
+ *  @brief state of the streaming NMEA parser
+ *
+ */
+typedef struct {
+    gnss_nmea_parse_state_t state;
+    uint8_t checksum;           /**< XOR of the characters between '$' and '*' */
+    uint8_t received_checksum;  /**< checksum sent at the end of the sentence */
+    uint8_t checksum_digits;    /**< number of checksum digits received */
+    uint8_t address[5];
+    uint8_t address_len;
+    uint16_t talker;            /**< talker ID using the TALKER() macro */
+    uint32_t sentence;          /**< sentence ID using the SENTENCE() macro */
+    uint8_t field_idx;          /**< index of the field being read, 0 is the first field after the address */
+    gnss_nmea_field_t field;    /**< field being read */
+    int8_t fault;               /**< first fault found in the sentence */
+    const gnss_nmea_schema_t *schema;   /**< fields to decode from the sentence, NULL if none */
+    uint8_t schema_pos;         /**< next entry of the schema to decode */
+    uint8_t decoded;            /**< "Fields decoded from the current sentence" flags */
+    gnss_fix_t fix;             /**< fix data decoded from the sentences */
+} gnss_nmea_parser_t;
 
 
 
@@ -93,9 +212,52 @@ extern "C" {
  */
 bool gnss_nmea_queue(gnss_t *gnss_obj, uint8_t datum);
 
+/*!
+ * \brief NMEA queue span
+ * 
+ * Same as gnss_nmea_queue() for a run of received bytes.
+ * Scans the span for the start and end of sentences and copies each part of a sentence into the ring buffer in one block.
+ * 
+ * @param gnss_obj is the GNSS object
+ * @param data is the run of received bytes
+ * @param len is the number of bytes in the run
+ * \return number of sentences finished
+ * 
+ */
+uint8_t gnss_nmea_queue_span(gnss_t *gnss_obj, const uint8_t *data, uint16_t len);
+
+/*!
+ * \brief Resets the streaming NMEA parser
+ * 
+ * Also clears parser->fix. It is not cleared at the start of each sentence, so the fields of consecutive sentences are merged into it.
+ * 
+ * @param parser is the parser to reset
+ * \return None
+ * 
+ */
+void gnss_nmea_parse_init(gnss_nmea_parser_t *parser);
+
+/*!
+ * \brief Feeds one byte to the streaming NMEA parser
+ * 
+ * Single pass parser: the checksum is accumulated, fields are split and numeric fields are converted as the bytes arrive.
+ * A '$' starts a new sentence at any point. The sentence is decoded, or rejected on a checksum mismatch, when its '\n' arrives.
+ * Fields are decoded into parser->fix using the schema of the sentence. parser->fix should be discarded after a sentence with a fault.
+ * 
+ * @param parser is the parser state
+ * @param datum is the next received byte
+ * \return NMEA_SENTENCE_PENDING until the end of a sentence, then an error code defined by "NMEA Faults" macros
+ * 
+ */
+int8_t gnss_nmea_parse(gnss_nmea_parser_t *parser, uint8_t datum);
+
 /*!
  * \brief Decodes the next NMEA sentence in the ring buffer
  * 
+ * The sentence is fed to the streaming parser in place in the ring buffer and released once decoded.
+ * Its fields are merged into the last fix, which is only updated if the checksum matches.
+ * A position sentence (GGA, GNS, RMC) is always published, as no_fix unless it carries its own time, position and quality.
+ * Other sentences (GSA, VTG) are only published if they change a valid fix of the same epoch (see GNSS_EPOCH_WINDOW).
  * 
  * @param gnss_obj is the GNSS object
  * \return error code defined by "NMEA Faults" macros
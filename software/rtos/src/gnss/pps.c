@@ -0,0 +1,243 @@
+
+#include "pps.h"
+/*-------------------------------------------------------------------------------- /
+/ ATACS GNSS PPS capture and UTC clock
+/ -------------------------------------------------------------------------------- /
+/ Part of the ATACS (Aerial Termination And Communication System) project
+/       https://github.com/michigan-balloon-recovery/ATACS
+/       released under the GPLv2 license (see ATACS/LICENSE in git repository)
+/ Creation Date: November 2019
+/ Contributors: Paul Young
+/ --------------------------------------------------------------------------------*/
+
+
+
+
+
+// ---------------------------------------------------------- //
+// -------------------- global variables -------------------- //
+// ---------------------------------------------------------- //
+
+extern gnss_t GNSS;
+
+
+
+
+
+// ------------------------------------------------------------ //
+// -------------------- private prototypes -------------------- //
+// ------------------------------------------------------------ //
+
+/*!
+ * \brief reads the timer count
+ *
+ * Must be called with interrupts disabled.
+ *
+ * @param pps is the PPS object
+ * @param tar is where to store TA0R
+ * \return timer counts since startup
+ */
+static uint32_t gnss_pps_counts(const gnss_pps_t *pps, uint16_t *tar);
+
+/*!
+ * \brief stores the timer count of a captured PPS edge
+ *
+ * Called from the timer A0 ISR.
+ *
+ * @param pps is the PPS object
+ * \return None
+ */
+static void gnss_pps_capture(gnss_pps_t *pps);
+
+
+
+
+
+// ---------------------------------------------------- //
+// -------------------- public API -------------------- //
+// ---------------------------------------------------- //
+
+void gnss_pps_init(gnss_pps_t *pps) {
+    pps->captured = false;
+    pps->clock.valid = false;
+    pps->clock_seq = 0;
+    pps->rate_valid = false;
+
+    // capture rising edges of CCI3A, synchronized to the timer clock
+    GPIO_setAsPeripheralModuleFunctionInputPin(GNSS_PPS_PORT, GNSS_PPS_PIN);
+    TA0CCTL3 = CM_1 | CCIS_0 | SCS | CAP | CCIE;
+}
+
+void gnss_pps_tick(gnss_pps_t *pps) {
+    pps->ticks++;
+}
+
+bool gnss_pps_fix(gnss_pps_t *pps, const gnss_time_t *time) {
+    gnss_clock_t clock = pps->clock;
+    int32_t msec = gnss_time_to_msec(time);
+    int32_t seconds;
+    uint32_t elapsed;
+    uint32_t capture;
+    uint32_t now;
+    uint32_t rate;
+    uint16_t tar;
+    bool captured;
+
+    // only the fixes of whole seconds line up with a PPS edge
+    if(msec % 1000 != 0) {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    capture = pps->capture;
+    captured = pps->captured;
+    pps->captured = false;
+    now = gnss_pps_counts(pps, &tar);
+    taskEXIT_CRITICAL();
+
+    // the edge must be the one of this fix, not of an earlier second
+    if(!captured || (now - capture >= (pps->rate_valid ? clock.counts_per_sec >> 8 : GNSS_PPS_TIMER_HZ))) {
+        return false;
+    }
+
+    if(!clock.valid) {
+        clock.counts_per_sec = GNSS_PPS_TIMER_HZ << 8;
+    }
+    else {
+        seconds = msec - clock.ref_msec;
+        if(seconds < 0) {
+            seconds += GNSS_MSEC_PER_DAY;
+        }
+        seconds /= 1000;
+
+        // whole seconds counted by the timer since the reference edge
+        elapsed = (capture - clock.ref_counts + (clock.counts_per_sec >> 9)) / (clock.counts_per_sec >> 8);
+
+        // a fix time that doesn't move forward with the edges would make the clock jump, a stale
+        // reference is only replaced without the check once it is GNSS_PPS_MAX_INTERVAL s old
+        if( (elapsed <= GNSS_PPS_MAX_INTERVAL) && ((uint32_t)seconds != elapsed) ) {
+            return false;
+        }
+
+        // measure the timer rate against the PPS
+        if( (seconds > 0) && (seconds <= GNSS_PPS_MAX_INTERVAL) ) {
+            rate = ((capture - clock.ref_counts) << 8) / seconds;
+            if( (rate >= (uint32_t)(GNSS_PPS_TIMER_HZ - GNSS_PPS_MAX_DRIFT) << 8) && (rate <= (uint32_t)(GNSS_PPS_TIMER_HZ + GNSS_PPS_MAX_DRIFT) << 8) ) {
+                if(pps->rate_valid) {
+                    clock.counts_per_sec += ((int32_t)(rate - clock.counts_per_sec)) / GNSS_PPS_RATE_FILTER;
+                }
+                else {
+                    clock.counts_per_sec = rate;
+                    pps->rate_valid = true;
+                }
+            }
+        }
+    }
+    clock.ref_counts = capture;
+    clock.ref_msec = msec;
+    clock.valid = true;
+
+    // the sequence count is odd while the clock is being written
+    pps->clock_seq++;
+    portMEMORY_BARRIER();
+    pps->clock = clock;
+    portMEMORY_BARRIER();
+    pps->clock_seq++;
+    return true;
+}
+
+bool gnss_pps_now(gnss_pps_t *pps, gnss_utc_t *utc) {
+    gnss_clock_t clock;
+    uint64_t usec;
+    uint32_t now;
+    uint16_t tar;
+    uint16_t seq;
+    uint8_t attempt;
+
+    utc->msec = -1;
+    utc->usec = 0;
+
+    for(attempt = 0; attempt < GNSS_PPS_READ_ATTEMPTS; attempt++) {
+        seq = pps->clock_seq;
+        portMEMORY_BARRIER();
+        clock = pps->clock;
+        taskENTER_CRITICAL();
+        now = gnss_pps_counts(pps, &tar);
+        taskEXIT_CRITICAL();
+        portMEMORY_BARRIER();
+
+        if( !(seq & 1) && (seq == pps->clock_seq) ) {
+            break;
+        }
+
+        // let a preempted GNSS task finish writing
+        taskYIELD();
+    }
+    if( (attempt == GNSS_PPS_READ_ATTEMPTS) || !clock.valid ) {
+        return false;
+    }
+
+    // time since the reference edge at the measured rate
+    usec = (uint64_t)(now - clock.ref_counts) * (1000000ULL << 8) / clock.counts_per_sec;
+    utc->msec = (clock.ref_msec + (int32_t)((usec / 1000) % GNSS_MSEC_PER_DAY)) % GNSS_MSEC_PER_DAY;
+    utc->usec = usec % 1000;
+    return true;
+}
+
+bool time_now_utc(gnss_utc_t *utc) {
+    return gnss_pps_now(&GNSS.pps, utc);
+}
+
+void gnss_utc_to_time(const gnss_utc_t *utc, gnss_time_t *time) {
+    time->hour = utc->msec / 3600000;
+    time->min = (utc->msec / 60000) % 60;
+    time->msec = utc->msec % 60000;
+}
+
+
+
+
+
+// ----------------------------------------------------- //
+// -------------------- private API -------------------- //
+// ----------------------------------------------------- //
+
+static uint32_t gnss_pps_counts(const gnss_pps_t *pps, uint16_t *tar) {
+    uint16_t period = TA0CCR0 + 1;
+    uint32_t ticks = pps->ticks;
+
+    // the timer runs from ACLK, so TA0R is read until two reads agree
+    do {
+        *tar = TA0R;
+    } while(*tar != TA0R);
+
+    // the timer wrapped but the tick interrupt hasn't run yet
+    if( (TA0CCTL0 & CCIFG) && (*tar < period / 2) ) {
+        ticks++;
+    }
+    return ticks * period + *tar;
+}
+
+static void gnss_pps_capture(gnss_pps_t *pps) {
+    uint16_t edge = TA0CCR3;
+    uint16_t tar;
+    uint32_t now = gnss_pps_counts(pps, &tar);
+
+    // the timer wrapped between the edge and now
+    pps->capture = now - tar + edge - ((edge > tar) ? (uint32_t)(TA0CCR0 + 1) : 0);
+    pps->captured = true;
+}
+
+/*
+ * PPS capture ISR
+ */
+#pragma vector=TIMER0_A1_VECTOR
+__interrupt void TIMER0_A1_ISR (void) {
+    switch(__even_in_range(TA0IV, TA0IV_TAIFG)) {
+    case TA0IV_TACCR3:
+        gnss_pps_capture(&GNSS.pps);
+        break;
+    default:
+        break;
+    }
+}
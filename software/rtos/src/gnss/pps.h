@@ -0,0 +1,135 @@
+#ifndef PPS_H
+#define PPS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+
+
+// -------------------------------------------------------------- //
+// -------------------- include dependencies -------------------- //
+// -------------------------------------------------------------- //
+
+// standard libraries
+#include <stdint.h>
+#include <stdbool.h>
+// MSP430 hardware
+#include <msp430.h>
+#include <driverlib.h>
+// application drivers
+#include "gnss.h"
+
+
+
+
+
+// ------------------------------------------------------- //
+// -------------------- public macros -------------------- //
+// ------------------------------------------------------- //
+
+/* PPS capture:
+ *      - the PPS line is captured by CCR3 of timer A0, which also generates the FreeRTOS tick (see vApplicationSetupTimerInterrupt())
+ *      - times are counted in timer counts: tick interrupts * (TA0CCR0 + 1) + TA0R
+ */
+#define GNSS_PPS_PORT               GPIO_PORT_P1
+#define GNSS_PPS_PIN                GPIO_PIN4       // TA0.CCI3A, P1.2 and P1.3 (CCI1A, CCI2A) drive the APRS radio
+#define GNSS_PPS_TIMER_HZ           32768L          // ACLK
+
+/* clock discipline:
+ *      - the clock is set from the PPS edge before each fix of a whole second
+ *      - the fix must be as many seconds after the reference as the timer counted, unless that was more than GNSS_PPS_MAX_INTERVAL s ago
+ *      - the timer rate is measured between PPS edges up to GNSS_PPS_MAX_INTERVAL s apart and filtered with a time constant of GNSS_PPS_RATE_FILTER measurements
+ *      - rates more than GNSS_PPS_MAX_DRIFT counts per second from GNSS_PPS_TIMER_HZ are rejected (REFO is good to 3.5%)
+ */
+#define GNSS_PPS_MAX_INTERVAL       64
+#define GNSS_PPS_RATE_FILTER        4
+#define GNSS_PPS_MAX_DRIFT          (GNSS_PPS_TIMER_HZ / 20)
+
+// times time_now_utc() tries to copy the clock before giving up because it keeps being rewritten
+#define GNSS_PPS_READ_ATTEMPTS      4
+
+
+
+
+
+// ----------------------------------------------------------- //
+// -------------------- public prototypes -------------------- //
+// ----------------------------------------------------------- //
+
+/*!
+ * \brief starts capturing the PPS line
+ *
+ * Must be called after the scheduler started timer A0.
+ *
+ * @param pps is the PPS object
+ * \return None
+ *
+ */
+void gnss_pps_init(gnss_pps_t *pps);
+
+/*!
+ * \brief counts a tick interrupt
+ *
+ * Must be called from vApplicationTickHook().
+ *
+ * @param pps is the PPS object
+ * \return None
+ *
+ */
+void gnss_pps_tick(gnss_pps_t *pps);
+
+/*!
+ * \brief sets the clock from the last PPS edge
+ *
+ * Only called by the GNSS task, with the time of each decoded fix.
+ * A fix of a whole second is matched with the PPS edge captured before it, if that edge was less than a second ago.
+ * The fix time must move forward from the reference by the seconds the timer counted, so the clock never jumps back.
+ *
+ * @param pps is the PPS object
+ * @param time is the UTC time of the fix
+ * \return true if the clock was set
+ *
+ */
+bool gnss_pps_fix(gnss_pps_t *pps, const gnss_time_t *time);
+
+/*!
+ * \brief reads the clock
+ *
+ * Can't be called from an ISR.
+ *
+ * @param pps is the PPS object
+ * @param utc is where to store the time, msec is -1 if the clock isn't set
+ * \return true if the clock is set
+ *
+ */
+bool gnss_pps_now(gnss_pps_t *pps, gnss_utc_t *utc);
+
+/*!
+ * \brief reads the UTC clock of the GNSS object
+ *
+ * Same as gnss_pps_now() for the GNSS global.
+ *
+ * @param utc is where to store the time, msec is -1 if the clock isn't set
+ * \return true if the clock is set
+ *
+ */
+bool time_now_utc(gnss_utc_t *utc);
+
+/*!
+ * \brief converts a UTC time of day to hours, minutes and milliseconds
+ *
+ * @param utc is the time to convert
+ * @param time is where to store the time
+ * \return None
+ *
+ */
+void gnss_utc_to_time(const gnss_utc_t *utc, gnss_time_t *time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PPS_H */
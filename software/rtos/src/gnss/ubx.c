@@ -0,0 +1,482 @@
+
+#include "ubx.h"
+/*-------------------------------------------------------------------------------- /
+/ ATACS UBX (u-blox proprietary binary protocol) driver
+/ -------------------------------------------------------------------------------- /
+/ Part of the ATACS (Aerial Termination And Communication System) project
+/       https://github.com/michigan-balloon-recovery/ATACS
+/       released under the GPLv2 license (see ATACS/LICENSE in git repository)
+/ Creation Date: November 2019
+/ Contributors: Paul Young
+/ --------------------------------------------------------------------------------*/
+
+
+
+
+
+// ---------------------------------------------------------- //
+// -------------------- global variables -------------------- //
+// ---------------------------------------------------------- //
+
+extern UARTConfig * prtInfList[5];
+
+
+
+
+
+// ------------------------------------------------------------ //
+// -------------------- private prototypes -------------------- //
+// ------------------------------------------------------------ //
+
+/*!
+ * \brief Decode a NAV-PVT (navigation position velocity time solution) message
+ *
+ * @param gnss_obj is the GNSS object
+ * @param span is the frame in the ring buffer, starting with the class and ID
+ * \return UBX fault code
+ */
+static int8_t gnss_ubx_decode_nav_pvt(gnss_t *gnss_obj, const ring_buff_span_t span[2]);
+
+/*!
+ * \brief Match one received byte against the acknowledgment frame being waited for
+ *
+ * @param ack is the acknowledgment search state
+ * @param datum is the received byte
+ * \return None
+ */
+static inline void gnss_ubx_ack_byte(gnss_ubx_ack_t *ack, uint8_t datum);
+
+// ----- utility functions ----- //
+static inline uint8_t gnss_ubx_byte(const ring_buff_span_t span[2], uint16_t idx);
+static inline uint32_t gnss_ubx_read(const ring_buff_span_t span[2], uint16_t offset, uint8_t size);
+static inline uint32_t gnss_ubx_to_decMilliSec(int32_t deg7);
+
+
+
+
+
+// ---------------------------------------------------- //
+// -------------------- public API -------------------- //
+// ---------------------------------------------------- //
+
+bool gnss_ubx_queue(gnss_t *gnss_obj, uint8_t datum) {
+    gnss_ubx_framer_t *framer = &gnss_obj->ubx_framer;
+    ring_buff_t *buff = &gnss_obj->gnss_rx_buff;
+    bool end_of_packet = false;
+
+    // the checksum covers everything from the class to the end of the payload
+    if( (framer->state >= UBX_STATE_CLASS) && (framer->state <= UBX_STATE_PAYLOAD) ) {
+        framer->ck_a += datum;
+        framer->ck_b += framer->ck_a;
+    }
+
+    switch(framer->state) {
+    case UBX_STATE_SYNC_1:
+        if(datum == UBX_SYNC_1) {
+            framer->state = UBX_STATE_SYNC_2;
+        }
+        break;
+    case UBX_STATE_SYNC_2:
+        if(datum == UBX_SYNC_2) {
+            gnss_obj->decoding_message = true;
+            ring_buff_write_clear_packet(buff);
+            framer->ck_a = 0;
+            framer->ck_b = 0;
+            framer->state = UBX_STATE_CLASS;
+        }
+        else if(datum != UBX_SYNC_1) {
+            framer->state = UBX_STATE_SYNC_1;
+        }
+        break;
+    case UBX_STATE_CLASS:
+    case UBX_STATE_ID:
+        ring_buff_write(buff, datum);
+        framer->state++;
+        break;
+    case UBX_STATE_LEN_1:
+        framer->len = datum;
+        framer->state = UBX_STATE_LEN_2;
+        break;
+    case UBX_STATE_LEN_2:
+        framer->len |= (uint16_t)datum << 8;
+        framer->count = 0;
+        // frames too long to store are dropped and the framer looks for the next sync characters
+        if(framer->len > GNSS_UBX_MAX_PAYLOAD) {
+            gnss_obj->decoding_message = false;
+            ring_buff_write_clear_packet(buff);
+            framer->state = UBX_STATE_SYNC_1;
+        }
+        else if(framer->len == 0) {
+            framer->state = UBX_STATE_CK_A;
+        }
+        else {
+            framer->state = UBX_STATE_PAYLOAD;
+        }
+        break;
+    case UBX_STATE_PAYLOAD:
+        ring_buff_write(buff, datum);
+        if(++framer->count >= framer->len) {
+            framer->state = UBX_STATE_CK_A;
+        }
+        break;
+    case UBX_STATE_CK_A:
+        framer->state = (datum == framer->ck_a) ? UBX_STATE_CK_B : UBX_STATE_SYNC_1;
+        if(framer->state == UBX_STATE_SYNC_1) {
+            gnss_obj->decoding_message = false;
+            ring_buff_write_clear_packet(buff);
+        }
+        break;
+    case UBX_STATE_CK_B:
+        gnss_obj->decoding_message = false;
+        if( (datum == framer->ck_b) && (ring_buff_write_finish_packet(buff) > 0) ) {
+            end_of_packet = true;
+        }
+        else {
+            ring_buff_write_clear_packet(buff);
+        }
+        framer->state = UBX_STATE_SYNC_1;
+        break;
+    default:
+        framer->state = UBX_STATE_SYNC_1;
+        break;
+    }
+
+    return end_of_packet;
+}
+
+uint8_t gnss_ubx_queue_span(gnss_t *gnss_obj, const uint8_t *data, uint16_t len) {
+    uint8_t finished = 0;
+
+    while(len > 0) {
+        if(gnss_ubx_queue(gnss_obj, *data)) {
+            finished++;
+        }
+        data++;
+        len--;
+    }
+
+    return finished;
+}
+
+int8_t gnss_ubx_decode(gnss_t *gnss_obj) {
+    ring_buff_span_t span[2];
+    ring_buff_t *buff = &gnss_obj->gnss_rx_buff;
+    uint16_t length;
+    int8_t result;
+
+    // locate the oldest finished frame in place
+    length = ring_buff_peek_packet(buff, span);
+    if(length < 2) {
+        if(length > 0) {
+            ring_buff_consume_packet(buff, length);
+        }
+        return UBX_EMPTY_BUFFER;
+    }
+
+    switch(UBX_MSG(gnss_ubx_byte(span, 0), gnss_ubx_byte(span, 1))) {
+    // navigation position velocity time solution
+    case UBX_NAV_PVT:
+        if( (length - 2) != UBX_NAV_PVT_LEN ) {
+            result = UBX_BAD_LENGTH;
+            break;
+        }
+        result = gnss_ubx_decode_nav_pvt(gnss_obj, span);
+        break;
+    // acknowledgments of configuration messages
+    case UBX_ACK_ACK:
+    case UBX_ACK_NAK:
+        result = UBX_NO_FAULT;
+        break;
+    // unknown message
+    default:
+        result = UBX_UNKNOWN_MESSAGE;
+        break;
+    }
+
+    // mark the whole frame as read
+    ring_buff_consume_packet(buff, length);
+    return result;
+}
+
+int8_t gnss_ubx_send(gnss_t *gnss_obj, uint16_t msg, const uint8_t *payload, uint8_t len) {
+    uint8_t frame[UBX_CFG_MAX_PAYLOAD + 8];
+    uint8_t ck_a = 0;
+    uint8_t ck_b = 0;
+    uint8_t i;
+
+    if(len > UBX_CFG_MAX_PAYLOAD) {
+        return UBX_BAD_LENGTH;
+    }
+
+    frame[0] = UBX_SYNC_1;
+    frame[1] = UBX_SYNC_2;
+    frame[2] = msg >> 8;
+    frame[3] = msg & 0xFF;
+    frame[4] = len;
+    frame[5] = 0;
+    memcpy(&frame[6], payload, len);
+
+    // Fletcher checksum over everything from the class to the end of the payload
+    for(i = 2; i < len + 6; i++) {
+        ck_a += frame[i];
+        ck_b += ck_a;
+    }
+    frame[len + 6] = ck_a;
+    frame[len + 7] = ck_b;
+
+    if(uartSendDataTask(prtInfList[gnss_obj->uart_module], frame, len + 8, UBX_CFG_TIMEOUT / portTICK_RATE_MS) != UART_SUCCESS) {
+        return UBX_TX_FAULT;
+    }
+    return UBX_NO_FAULT;
+}
+
+int8_t gnss_ubx_send_cfg(gnss_t *gnss_obj, uint16_t msg, const uint8_t *payload, uint8_t len) {
+    gnss_ubx_ack_t *ack = &gnss_obj->ubx_ack;
+    int8_t result = UBX_CFG_NO_ACK;
+    uint16_t wait;
+    uint8_t attempt;
+
+    for(attempt = 0; attempt < UBX_CFG_RETRIES; attempt++) {
+        // arm the acknowledgment search last so the RX callback never sees a half set up search
+        ack->cls = msg >> 8;
+        ack->id = msg & 0xFF;
+        ack->idx = 0;
+        ack->result = UBX_CFG_PENDING;
+
+        result = gnss_ubx_send(gnss_obj, msg, payload, len);
+        if(result != UBX_NO_FAULT) {
+            ack->result = result;
+            continue;
+        }
+
+        for(wait = 0; (ack->result == UBX_CFG_PENDING) && (wait < UBX_CFG_TIMEOUT); wait += UBX_CFG_POLL_PERIOD) {
+            vTaskDelay(UBX_CFG_POLL_PERIOD / portTICK_RATE_MS);
+#ifdef GNSS_RX_DMA
+            // received bytes only reach the RX callback when the DMA buffer is polled
+            uartDmaRxPoll(prtInfList[gnss_obj->uart_module]);
+#endif
+        }
+
+        if(ack->result == UBX_CFG_PENDING) {
+            ack->result = UBX_CFG_NO_ACK;
+        }
+        result = ack->result;
+
+        // a rejected message won't be accepted the next time either
+        if( (result == UBX_NO_FAULT) || (result == UBX_CFG_NAK) ) {
+            break;
+        }
+    }
+
+    return result;
+}
+
+void gnss_ubx_ack_scan(gnss_t *gnss_obj, const uint8_t *data, uint16_t len) {
+    gnss_ubx_ack_t *ack = &gnss_obj->ubx_ack;
+
+    // nothing is waiting for an acknowledgment
+    if(ack->result != UBX_CFG_PENDING) {
+        return;
+    }
+
+    while(len > 0) {
+        gnss_ubx_ack_byte(ack, *data);
+        data++;
+        len--;
+    }
+}
+
+
+
+
+
+// ----------------------------------------------------- //
+// -------------------- private API -------------------- //
+// ----------------------------------------------------- //
+
+static int8_t gnss_ubx_decode_nav_pvt(gnss_t *gnss_obj, const ring_buff_span_t span[2]) {
+    gnss_fix_t current_fix = {.quality = no_fix};
+    uint8_t fix_type = gnss_ubx_read(span, 2 + UBX_NAV_PVT_FIX_TYPE, 1);
+    uint8_t flags = gnss_ubx_read(span, 2 + UBX_NAV_PVT_FLAGS, 1);
+    uint8_t valid = gnss_ubx_read(span, 2 + UBX_NAV_PVT_VALID, 1);
+    int32_t msec;
+    int8_t hour;
+    int8_t min;
+    int32_t sec;
+    int32_t nano;
+    int32_t lat;
+    int32_t lon;
+
+    // reject frames with a time or location out of range
+    lat = (int32_t)gnss_ubx_read(span, 2 + UBX_NAV_PVT_LAT, 4);
+    lon = (int32_t)gnss_ubx_read(span, 2 + UBX_NAV_PVT_LON, 4);
+    if( (gnss_ubx_read(span, 2 + UBX_NAV_PVT_HOUR, 1) >= 24) || (gnss_ubx_read(span, 2 + UBX_NAV_PVT_MIN, 1) >= 60)
+        || (gnss_ubx_read(span, 2 + UBX_NAV_PVT_SEC, 1) > 60) || (lat > 900000000L) || (lat < -900000000L) || (lon > 1800000000L) || (lon < -1800000000L) ) {
+        GPIO_setOutputLowOnPin(GPIO_PORT_P8, GPIO_PIN4);
+        return UBX_BAD_FIELD;
+    }
+
+    // fix quality, a fix is only used once the UTC time is resolved
+    if( !(valid & UBX_NAV_PVT_VALID_TIME) || !(flags & UBX_NAV_PVT_GNSS_FIX_OK) || (fix_type == UBX_NAV_PVT_FIX_NONE) || (fix_type == UBX_NAV_PVT_FIX_TIME_ONLY) ) {
+        current_fix.quality = no_fix;
+    }
+    else if(fix_type == UBX_NAV_PVT_FIX_DEAD_RECKON) {
+        current_fix.quality = dead_reckon;
+    }
+    else if(flags & UBX_NAV_PVT_CARR_FIXED) {
+        current_fix.quality = rtk_fix;
+    }
+    else if(flags & UBX_NAV_PVT_CARR_FLOAT) {
+        current_fix.quality = rtk_float;
+    }
+    else if(flags & UBX_NAV_PVT_DIFF_SOLN) {
+        current_fix.quality = diff_fix;
+    }
+    else {
+        current_fix.quality = auto_fix;
+    }
+
+    // UTC time, the nanoseconds are a signed correction to the rounded second
+    hour = gnss_ubx_read(span, 2 + UBX_NAV_PVT_HOUR, 1);
+    min = gnss_ubx_read(span, 2 + UBX_NAV_PVT_MIN, 1);
+    sec = gnss_ubx_read(span, 2 + UBX_NAV_PVT_SEC, 1);
+    nano = (int32_t)gnss_ubx_read(span, 2 + UBX_NAV_PVT_NANO, 4);
+    if(nano < 0) {
+        // borrow a second
+        sec--;
+        nano += 1000000000L;
+    }
+    msec = 1000 * sec + nano / 1000000;
+    if(msec < 0) {
+        // borrow a minute, which may carry into the hour and day
+        msec += 60000;
+        if(--min < 0) {
+            min = 59;
+            if(--hour < 0) {
+                hour = 23;
+            }
+        }
+    }
+    current_fix.time.hour = hour;
+    current_fix.time.min = min;
+    current_fix.time.msec = msec;
+
+    // location in 1e-7 degrees
+    current_fix.location.latitude.decMilliSec = gnss_ubx_to_decMilliSec(lat);
+    current_fix.location.latitude.dir = (lat < 0) ? 'S' : 'N';
+    current_fix.location.longitude.decMilliSec = gnss_ubx_to_decMilliSec(lon);
+    current_fix.location.longitude.dir = (lon < 0) ? 'W' : 'E';
+
+    current_fix.num_satellites = gnss_ubx_read(span, 2 + UBX_NAV_PVT_NUM_SV, 1);
+
+    // height above mean sea level in mm
+    current_fix.altitude_mm = (int32_t)gnss_ubx_read(span, 2 + UBX_NAV_PVT_HMSL, 4);
+
+    // ground speed in mm/s and heading of motion in 1e-5 degrees
+    current_fix.speed_mmps = (int32_t)gnss_ubx_read(span, 2 + UBX_NAV_PVT_GSPEED, 4);
+    current_fix.course_mdeg = (int32_t)gnss_ubx_read(span, 2 + UBX_NAV_PVT_HEAD_MOT, 4) / 100;
+    current_fix.pdop = gnss_ubx_read(span, 2 + UBX_NAV_PVT_PDOP, 2);
+
+    // same convention as the NMEA GSA navigation mode
+    if(current_fix.quality == no_fix) {
+        current_fix.fix_mode = 1;
+    }
+    else if(fix_type == UBX_NAV_PVT_FIX_2D) {
+        current_fix.fix_mode = 2;
+    }
+    else {
+        current_fix.fix_mode = 3;
+    }
+
+    // a solution without a fix is published too, so the last fix stops being reported as current
+    gnss_publish_fix(gnss_obj, &current_fix);
+    if(current_fix.quality != no_fix) {
+        GPIO_setOutputHighOnPin(GPIO_PORT_P8, GPIO_PIN4);
+    } else {
+        GPIO_setOutputLowOnPin(GPIO_PORT_P8, GPIO_PIN4);
+    }
+    return UBX_NO_FAULT;
+}
+
+static inline void gnss_ubx_ack_byte(gnss_ubx_ack_t *ack, uint8_t datum) {
+    bool match;
+
+    // acknowledgment frame: sync, class 0x05, ID (0x01 ACK or 0x00 NAK), length 2, acknowledged class and ID, checksum
+    switch(ack->idx) {
+    case 0:
+        match = (datum == UBX_SYNC_1);
+        break;
+    case 1:
+        match = (datum == UBX_SYNC_2);
+        ack->ck_a = 0;
+        ack->ck_b = 0;
+        break;
+    case 2:
+        match = (datum == (UBX_ACK_ACK >> 8));
+        break;
+    case 3:
+        match = (datum == (UBX_ACK_ACK & 0xFF)) || (datum == (UBX_ACK_NAK & 0xFF));
+        ack->nak = (datum == (UBX_ACK_NAK & 0xFF));
+        break;
+    case 4:
+        match = (datum == 2);
+        break;
+    case 5:
+        match = (datum == 0);
+        break;
+    case 6:
+        match = (datum == ack->cls);
+        break;
+    case 7:
+        match = (datum == ack->id);
+        break;
+    case 8:
+        match = (datum == ack->ck_a);
+        break;
+    default:
+        match = (datum == ack->ck_b);
+        break;
+    }
+
+    if(!match) {
+        // the byte may start the next frame
+        ack->idx = (datum == UBX_SYNC_1) ? 1 : 0;
+        return;
+    }
+
+    if( (ack->idx >= 2) && (ack->idx <= 7) ) {
+        ack->ck_a += datum;
+        ack->ck_b += ack->ck_a;
+    }
+
+    if(++ack->idx == 10) {
+        ack->idx = 0;
+        ack->result = ack->nak ? UBX_CFG_NAK : UBX_NO_FAULT;
+    }
+}
+
+static inline uint8_t gnss_ubx_byte(const ring_buff_span_t span[2], uint16_t idx) {
+    // the frame may wrap around the end of the ring buffer
+    if(idx < span[0].len) {
+        return span[0].data[idx];
+    }
+    return span[1].data[idx - span[0].len];
+}
+
+static inline uint32_t gnss_ubx_read(const ring_buff_span_t span[2], uint16_t offset, uint8_t size) {
+    uint32_t value = 0;
+
+    // UBX fields are little endian
+    while(size > 0) {
+        size--;
+        value = (value << 8) | gnss_ubx_byte(span, offset + size);
+    }
+    return value;
+}
+
+static inline uint32_t gnss_ubx_to_decMilliSec(int32_t deg7) {
+    uint32_t magnitude = (deg7 < 0) ? -(uint32_t)deg7 : (uint32_t)deg7;
+
+    // 1e-7 degrees * 0.36 = milliseconds of arc, split to stay within 32 bits
+    return (magnitude / 25) * 9 + ((magnitude % 25) * 9) / 25;
+}
@@ -0,0 +1,204 @@
+#ifndef UBX_H
+#define UBX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+
+
+// -------------------------------------------------------------- //
+// -------------------- include dependencies -------------------- //
+// -------------------------------------------------------------- //
+
+// standard libraries
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+// application drivers
+#include "gnss.h"
+#include "uart_stream.h"
+
+
+
+
+
+// ------------------------------------------------------- //
+// -------------------- public macros -------------------- //
+// ------------------------------------------------------- //
+
+#define UBX_MSG(class,id)           ( ( (uint16_t)class << 8 ) | (uint16_t)id )
+#define UBX_U16(x)                  (uint8_t)(x), (uint8_t)((x) >> 8)
+#define UBX_U32(x)                  UBX_U16(x), (uint8_t)((x) >> 16), (uint8_t)((x) >> 24)
+
+// longest frame payload that is stored in the ring buffer
+#define GNSS_UBX_MAX_PAYLOAD        100
+
+// ----- Configuration ----- //
+#define UBX_CFG_MAX_PAYLOAD         20
+#define UBX_CFG_RETRIES             3
+#define UBX_CFG_TIMEOUT             500
+#define UBX_CFG_POLL_PERIOD         10
+
+// ----- Frame Sync Characters ----- //
+#define UBX_SYNC_1                  0xB5
+#define UBX_SYNC_2                  0x62
+
+// ----- Frame States ----- //
+#define UBX_STATE_SYNC_1            0
+#define UBX_STATE_SYNC_2            1
+#define UBX_STATE_CLASS             2
+#define UBX_STATE_ID                3
+#define UBX_STATE_LEN_1             4
+#define UBX_STATE_LEN_2             5
+#define UBX_STATE_PAYLOAD           6
+#define UBX_STATE_CK_A              7
+#define UBX_STATE_CK_B              8
+
+// ----- Message IDs ----- //
+#define UBX_ACK_NAK                 UBX_MSG(0x05, 0x00)
+#define UBX_ACK_ACK                 UBX_MSG(0x05, 0x01)
+#define UBX_CFG_PRT                 UBX_MSG(0x06, 0x00)
+#define UBX_CFG_MSG                 UBX_MSG(0x06, 0x01)
+#define UBX_CFG_RATE                UBX_MSG(0x06, 0x08)
+#define UBX_NAV_PVT                 UBX_MSG(0x01, 0x07)
+
+// ----- NAV-PVT Payload ----- //
+#define UBX_NAV_PVT_LEN             92
+#define UBX_NAV_PVT_HOUR            8
+#define UBX_NAV_PVT_MIN             9
+#define UBX_NAV_PVT_SEC             10
+#define UBX_NAV_PVT_VALID           11
+#define UBX_NAV_PVT_NANO            16
+#define UBX_NAV_PVT_FIX_TYPE        20
+#define UBX_NAV_PVT_FLAGS           21
+#define UBX_NAV_PVT_NUM_SV          23
+#define UBX_NAV_PVT_LON             24
+#define UBX_NAV_PVT_LAT             28
+#define UBX_NAV_PVT_HMSL            36
+#define UBX_NAV_PVT_GSPEED          60
+#define UBX_NAV_PVT_HEAD_MOT        64
+#define UBX_NAV_PVT_PDOP            76
+
+#define UBX_NAV_PVT_FIX_NONE        0
+#define UBX_NAV_PVT_FIX_DEAD_RECKON 1
+#define UBX_NAV_PVT_FIX_2D          2
+#define UBX_NAV_PVT_FIX_TIME_ONLY   5
+
+#define UBX_NAV_PVT_VALID_TIME      0x02
+
+#define UBX_NAV_PVT_GNSS_FIX_OK     0x01
+#define UBX_NAV_PVT_DIFF_SOLN       0x02
+#define UBX_NAV_PVT_CARR_FLOAT      0x40
+#define UBX_NAV_PVT_CARR_FIXED      0x80
+
+// ----- UBX Faults ----- //
+#define UBX_NO_FAULT                0
+#define UBX_UNKNOWN_MESSAGE         -1
+#define UBX_BAD_LENGTH              -2
+#define UBX_EMPTY_BUFFER            -3
+#define UBX_CFG_NAK                 -4
+#define UBX_CFG_NO_ACK              -5
+#define UBX_TX_FAULT                -6
+#define UBX_BAD_FIELD               -7
+#define UBX_FAULTS                  8       // number of fault codes including UBX_NO_FAULT
+
+// ----- UBX Configuration Status ----- //
+#define UBX_CFG_PENDING             1
+
+
+
+
+
+// ----------------------------------------------------------- //
+// -------------------- public prototypes -------------------- //
+// ----------------------------------------------------------- //
+
+/*!
+ * \brief UBX queue byte
+ * 
+ * Runs the UBX framing state machine and adds the class, ID and payload of the frame to the ring buffer.
+ * The frame is only finished in the ring buffer if its Fletcher checksum matches.
+ * 
+ * @param gnss_obj is the GNSS object
+ * @param datum is the byte to add to the buffer
+ * \return true if end of a valid frame
+ * 
+ */
+bool gnss_ubx_queue(gnss_t *gnss_obj, uint8_t datum);
+
+/*!
+ * \brief UBX queue span
+ * 
+ * Same as gnss_ubx_queue() for a run of received bytes.
+ * 
+ * @param gnss_obj is the GNSS object
+ * @param data is the run of received bytes
+ * @param len is the number of bytes in the run
+ * \return number of valid frames finished
+ * 
+ */
+uint8_t gnss_ubx_queue_span(gnss_t *gnss_obj, const uint8_t *data, uint16_t len);
+
+/*!
+ * \brief Decodes the next UBX frame in the ring buffer
+ * 
+ * The frame is read in place in the ring buffer and released once decoded.
+ * 
+ * @param gnss_obj is the GNSS object
+ * \return error code defined by "UBX Faults" macros
+ * 
+ */
+int8_t gnss_ubx_decode(gnss_t *gnss_obj);
+
+/*!
+ * \brief Sends a UBX message to the receiver
+ * 
+ * Blocks the calling task until the frame has been sent.
+ * 
+ * @param gnss_obj is the GNSS object
+ * @param msg is the class and ID of the message using the UBX_MSG() macro
+ * @param payload is the message payload
+ * @param len is the number of bytes in the payload, at most UBX_CFG_MAX_PAYLOAD
+ * \return error code defined by "UBX Faults" macros
+ * 
+ */
+int8_t gnss_ubx_send(gnss_t *gnss_obj, uint16_t msg, const uint8_t *payload, uint8_t len);
+
+/*!
+ * \brief Sends a UBX configuration message and waits for its acknowledgment
+ * 
+ * The message is sent again if no acknowledgment is received within UBX_CFG_TIMEOUT ms, up to UBX_CFG_RETRIES times.
+ * A rejected (ACK-NAK) message isn't sent again.
+ * The received bytes must be passed to gnss_ubx_ack_scan() while waiting.
+ * 
+ * @param gnss_obj is the GNSS object
+ * @param msg is the class and ID of the message using the UBX_MSG() macro
+ * @param payload is the message payload
+ * @param len is the number of bytes in the payload, at most UBX_CFG_MAX_PAYLOAD
+ * \return UBX_NO_FAULT if acknowledged, otherwise an error code defined by "UBX Faults" macros
+ * 
+ */
+int8_t gnss_ubx_send_cfg(gnss_t *gnss_obj, uint16_t msg, const uint8_t *payload, uint8_t len);
+
+/*!
+ * \brief Searches received bytes for the acknowledgment gnss_ubx_send_cfg() is waiting for
+ * 
+ * Only matches ACK-ACK and ACK-NAK frames, so it can run alongside either protocol without storing anything.
+ * Can be called from an ISR.
+ * 
+ * @param gnss_obj is the GNSS object
+ * @param data is the run of received bytes
+ * @param len is the number of bytes in the run
+ * \return None
+ * 
+ */
+void gnss_ubx_ack_scan(gnss_t *gnss_obj, const uint8_t *data, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UBX_H */
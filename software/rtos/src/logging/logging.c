@@ -20,6 +20,9 @@ log_t rb_log = {.session_started = false};
 log_t gnss_log = {.session_started = false};
 log_t aprs_log = {.session_started = false};
 log_t sens_log = {.session_started = false};
+log_t buff_log = {.session_started = false};
+log_t uart_log = {.session_started = false};
+log_t gdec_log = {.session_started = false};
 
 extern ROCKBLOCK_t rb;
 extern gnss_t GNSS;
@@ -66,6 +69,28 @@ static void log_convert_file_name(char *file_name);
  */
 static void log_init();
 
+/*!
+ * \brief Writes one line of UART statistics to a file
+ *
+ * @param file open file to write to
+ * @param name name of the port, written in the first column
+ * @param port UART port to take the statistics of
+ * @return None
+ *
+ */
+static void log_uart_port(FIL *file, char *name, UARTConfig *port);
+
+/*!
+ * \brief Writes the current UTC time to a file as the first column of a line
+ *
+ * Format: ms since midnight with 3 decimals (ex. 43200123.456), or ??? if the clock isn't set.
+ *
+ * @param file open file to write to
+ * @return None
+ *
+ */
+static void log_utc(FIL *file);
+
 
 
 
@@ -87,6 +112,11 @@ void task_log() {
         if(rb.is_valid) {
             log_rb();
         }
+        if(GNSS.is_valid) {
+            log_buff();
+            log_gdec();
+        }
+        log_uart();
         GPIO_setOutputLowOnPin(GPIO_PORT_P8, GPIO_PIN2);
         vTaskDelay(LOG_PERIOD / portTICK_RATE_MS);
     }
@@ -103,12 +133,12 @@ static void log_init() {
         log_start_session(&gnss_log,
                             "gnss",
                             "000000.csv",
-                            "GNSS log file\nhr:min,latitude(decMilliSec),longitude(decMilliSec),altitude(m)\n"
+                            "GNSS log file\nutc(ms),hr:min,latitude(decMilliSec),longitude(decMilliSec),altitude(m)\n"
                             );
         log_start_session(&sens_log,
                             "sens",
                             "000000.csv",
-                            "sensor log file\npressure(mBar),temperature(degC),humidity(%),temperature(degC)\n"
+                            "sensor log file\nutc(ms),pressure(mBar),temperature(degC),humidity(%),temperature(degC)\n"
                             );
         log_start_session(&rb_log,
                             "rb",
@@ -120,6 +150,25 @@ static void log_init() {
                             "000000.csv",
                             "APRS log file\n"
                             );
+        log_start_session(&buff_log,
+                            "buff",
+                            "000000.csv",
+                            "ring buffer log file\ngnss rx dropped bytes,gnss rx dropped frames,gnss rx high water(bytes)\n"
+                            );
+        log_start_session(&uart_log,
+                            "uart",
+                            "000000.csv",
+                            "UART log file\nport,rx bytes,tx bytes,overrun errors,framing errors,parity errors,callback max(cycles),callback avg(cycles),tx queued(bytes)\n"
+                            );
+        log_start_session(&gdec_log,
+                            "gdec",
+                            "000000.csv",
+#ifdef GNSS_UBX
+                            "GNSS decoder log file\ndecoded,unknown message,bad length,empty,nak,no ack,tx fault,bad field,decode max(cycles),decode avg(cycles)\n"
+#else
+                            "GNSS decoder log file\ndecoded,unknown talker,unknown sentence,unknown proprietary,overflow,empty,checksum,bad field,decode max(cycles),decode avg(cycles)\n"
+#endif
+                            );
     }
 }
 
@@ -136,13 +185,19 @@ void log_gnss() {
     UINT bw;
 
     if(log_resume_session(&gnss_log, &file)) {
+        //one snapshot so the whole line comes from the same fix
+        gnss_fix_t fix;
+        bool fix_valid = gnss_get_fix(&GNSS,&fix);
+
+        //write log time
+        log_utc(&file);
+
         //write gps time
-        gnss_time_t time;
-        if(gnss_get_time(&GNSS,&time)) {
+        if(fix_valid) {
             char hStr[20];
             char mStr[20];
-            ltoa(time.hour,hStr);
-            ltoa(time.min,mStr);
+            ltoa(fix.time.hour,hStr);
+            ltoa(fix.time.min,mStr);
             //writes hours:minutes
             int length = strlen(hStr);
             f_write(&file,hStr,length,&bw);
@@ -156,19 +211,18 @@ void log_gnss() {
         f_write(&file,",",1,&bw);
         
         //write gps location 
-        gnss_coordinate_pair_t location;
-        if(gnss_get_location(&GNSS,&location)) {
+        if(fix_valid) {
             char lat[10];
             char lon[10];
-            ltoa(location.latitude.decMilliSec,lat);
-            ltoa(location.longitude.decMilliSec,lon);
+            ltoa(fix.location.latitude.decMilliSec,lat);
+            ltoa(fix.location.longitude.decMilliSec,lon);
             int length = strlen(lat);
             f_write(&file,lat,length,&bw);
-            f_write(&file,&location.latitude.dir,1,&bw);
+            f_write(&file,&fix.location.latitude.dir,1,&bw);
             f_write(&file,",",1,&bw);
             length = strlen(lon);
             f_write(&file,lon,length,&bw);
-            f_write(&file,&location.longitude.dir,1,&bw);
+            f_write(&file,&fix.location.longitude.dir,1,&bw);
         }
         else {
             f_write(&file,"??,??",5,&bw);
@@ -176,10 +230,9 @@ void log_gnss() {
         f_write(&file,",",1,&bw);
         
         //write gps altitude
-        int32_t altitude;
-        if(gnss_get_altitude(&GNSS,&altitude)) {
+        if(fix_valid) {
             char aStr[20];
-            ltoa(altitude,aStr);
+            ltoa(fix.altitude_mm / 1000,aStr);
             int length = strlen(aStr);
             f_write(&file,aStr,length,&bw);
         }
@@ -197,6 +250,9 @@ void log_sens() {
     UINT bw;
 
     if(log_resume_session(&sens_log, &file)) {
+        //write log time
+        log_utc(&file);
+
         //write pressure data
         int32_t pressure;
         if(sens_get_pres(&pressure)) {
@@ -275,6 +331,86 @@ void log_aprs() {
     }
 }
 
+void log_buff() {
+    FIL file;
+    UINT bw;
+
+    if(log_resume_session(&buff_log, &file)) {
+        ring_buff_stats_t stats;
+        char str[20];
+        int length;
+        ring_buff_get_stats(&GNSS.gnss_rx_buff, &stats);
+
+        //write dropped bytes
+        ltoa(stats.dropped_bytes,str);
+        length = strlen(str);
+        f_write(&file,str,length,&bw);
+        f_write(&file,",",1,&bw);
+
+        //write dropped frames
+        ltoa(stats.dropped_frames,str);
+        length = strlen(str);
+        f_write(&file,str,length,&bw);
+        f_write(&file,",",1,&bw);
+
+        //write high water mark
+        ltoa(stats.high_water,str);
+        length = strlen(str);
+        f_write(&file,str,length,&bw);
+        f_write(&file,"\n",1,&bw);
+
+        log_pause_session(&buff_log, &file);
+    }
+}
+
+void log_uart() {
+    FIL file;
+
+    if(log_resume_session(&uart_log, &file)) {
+        if(GNSS.is_valid) {
+            log_uart_port(&file, "gnss", &USCI_A0_cnf);
+        }
+        if(rb.is_valid) {
+            log_uart_port(&file, "rb", &USCI_A1_cnf);
+        }
+        log_pause_session(&uart_log, &file);
+    }
+}
+
+void log_gdec() {
+    FIL file;
+    UINT bw;
+
+    if(log_resume_session(&gdec_log, &file)) {
+        gnss_decode_stats_t stats;
+        char str[20];
+        uint8_t i;
+        gnss_get_stats(&GNSS, &stats);
+
+        //write decoded count
+        ltoa(stats.decoded,str);
+        f_write(&file,str,strlen(str),&bw);
+
+        //write rejected counts, rejected[0] would be NO_FAULT
+        for(i = 1; i < GNSS_DECODE_FAULTS; i++) {
+            f_write(&file,",",1,&bw);
+            ltoa(stats.rejected[i],str);
+            f_write(&file,str,strlen(str),&bw);
+        }
+
+        //write decode times
+        f_write(&file,",",1,&bw);
+        ltoa(stats.decode_max,str);
+        f_write(&file,str,strlen(str),&bw);
+        f_write(&file,",",1,&bw);
+        ltoa(stats.decode_avg,str);
+        f_write(&file,str,strlen(str),&bw);
+        f_write(&file,"\n",1,&bw);
+
+        log_pause_session(&gdec_log, &file);
+    }
+}
+
 FRESULT log_start_session(log_t *log_obj, char *dir, char* seed_name, char* header) {
     FRESULT res;
 
@@ -370,3 +506,52 @@ static void log_convert_file_name(char *file_name) {
     }
     *ptr += 1; // increment
 }
+
+static void log_uart_port(FIL *file, char *name, UARTConfig *port) {
+    UARTStats stats;
+    uint32_t fields[8];
+    char str[20];
+    uint8_t i;
+    UINT bw;
+
+    uartGetStats(port, &stats);
+    fields[0] = stats.rxBytes;
+    fields[1] = stats.txBytes;
+    fields[2] = stats.overrunErrors;
+    fields[3] = stats.framingErrors;
+    fields[4] = stats.parityErrors;
+    fields[5] = stats.callbackMax;
+    fields[6] = stats.callbackAvg;
+    fields[7] = stats.txQueued;
+
+    //write port name
+    f_write(file,name,strlen(name),&bw);
+
+    //write counters
+    for(i = 0; i < 8; i++) {
+        f_write(file,",",1,&bw);
+        ltoa(fields[i],str);
+        f_write(file,str,strlen(str),&bw);
+    }
+    f_write(file,"\n",1,&bw);
+}
+
+static void log_utc(FIL *file) {
+    gnss_utc_t now;
+    char str[20];
+    UINT bw;
+
+    if(time_now_utc(&now)) {
+        ltoa(now.msec,str);
+        f_write(file,str,strlen(str),&bw);
+        str[0] = '.';
+        str[1] = '0' + now.usec / 100;
+        str[2] = '0' + (now.usec / 10) % 10;
+        str[3] = '0' + now.usec % 10;
+        f_write(file,str,4,&bw);
+    }
+    else {
+        f_write(file,"???",3,&bw);
+    }
+    f_write(file,",",1,&bw);
+}
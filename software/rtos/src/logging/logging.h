@@ -38,7 +38,7 @@ extern "C" {
 
 #define LOG_MAX_ENTRIES                     30
 #define LOG_MAX_PATH_LEN                    30
-#define LOG_MAX_HEADER_LEN                  100
+#define LOG_MAX_HEADER_LEN                  160
 #define LOG_PERIOD                          1000
 #define LOG_TIMEOUT                         100
 
@@ -113,7 +113,7 @@ FRESULT log_pause_session(log_t *log_obj, FIL *file);
 /*!
  * \brief Pseudo-periodic logging task
  * 
- * Calls log_rb(), log_gnss(), log_sens(), and log_aprs().
+ * Calls log_rb(), log_gnss(), log_sens(), log_aprs(), log_buff(), log_uart(), and log_gdec().
  * Delay of LOG_PERIOD milliseconds between logs (not strictly periodic).
  * 
  * \return None
@@ -162,6 +162,39 @@ void log_sens();
  */
 void log_aprs();
 
+/*!
+ * \brief Logs ring buffer statistics
+ * 
+ * Logs the overflow statistics of the GNSS RX buffer since startup.
+ * Format: dropped bytes, dropped frames, high water mark(bytes).
+ * 
+ * \return None
+ * 
+ */
+void log_buff();
+
+/*!
+ * \brief Logs UART statistics
+ * 
+ * Logs one line per active port (GNSS and rockBLOCK) with the counters since startup.
+ * Format: port, rx bytes, tx bytes, overrun errors, framing errors, parity errors, callback max(cycles), callback avg(cycles), tx queued(bytes).
+ * 
+ * \return None
+ * 
+ */
+void log_uart();
+
+/*!
+ * \brief Logs GNSS decoder statistics
+ * 
+ * Logs the sentences (or UBX frames) decoded and rejected since startup, with the time spent decoding.
+ * Format: decoded, rejected by fault code (1 to 7), decode max(cycles), decode avg(cycles).
+ * 
+ * \return None
+ * 
+ */
+void log_gdec();
+
 #ifdef __cplusplus
 }
 #endif
@@ -21,6 +21,8 @@
 
 static void prvSetupHardware(void);
 
+extern gnss_t GNSS;
+
 /*-----------------------------------------------------------*/
 
 void main( void ) {
@@ -28,7 +30,7 @@ void main( void ) {
     prvSetupHardware();
 
     /* Create Tasks */
-    xTaskCreate((TaskFunction_t) task_gnss,           "gnss",             128, NULL, 1, NULL);
+    xTaskCreate((TaskFunction_t) task_gnss,           "gnss",             256, NULL, 1, NULL);
     xTaskCreate((TaskFunction_t) task_aprs,           "aprs",             512, NULL, 1, NULL);
     xTaskCreate((TaskFunction_t) task_pressure,       "pressure",         128, NULL, 1, NULL);
     xTaskCreate((TaskFunction_t) task_humidity,       "humidity",         128, NULL, 1, NULL);
@@ -97,7 +99,8 @@ static void prvSetupHardware(void) {
 
 
 void vApplicationTickHook(void) {
-	return;
+	/* Extend the tick count for the PPS disciplined UTC clock. */
+	gnss_pps_tick(&GNSS.pps);
 }
 
 /*-----------------------------------------------------------*/
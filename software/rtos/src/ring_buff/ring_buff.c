@@ -21,26 +21,94 @@
 // ------------------------------------------------------------ //
 
 /*!
- * \brief Increment ring buffer pointer
+ * \brief Advance a ring buffer index
+ *
+ * @param buff is the ring_buff_t instance
+ * @param idx is the index to advance
+ * @param len is the number of bytes to advance by
+ * \return the wrapped index
+ */
+static inline uint16_t ring_buff_advance(ring_buff_t *buff, uint16_t idx, uint16_t len);
+
+/*!
+ * \brief Calculate number of bytes between two ring buffer indices
+ *
+ * measures length from start_idx to end_idx.
+ * if two indices are the same, returns 0.
+ *
+ * @param buff is the ring_buff_t instance
+ * @param start_idx is the start of the region to measure
+ * @param end_idx is the end of the region to measure
+ * \return length between indices
+ */
+static inline uint16_t ring_buff_length(ring_buff_t *buff, uint16_t start_idx, uint16_t end_idx);
+
+/*!
+ * \brief Calculate number of bytes free for writing
+ *
+ * @param buff is the ring_buff_t instance
+ * \return number of bytes that can be added to the current packet
+ */
+static inline uint16_t ring_buff_free(ring_buff_t *buff);
+
+/*!
+ * \brief Release finished data from the start of the unread packet
+ *
+ * Advances the packet read index and drops the descriptors of any packets that were completely released.
+ *
+ * @param buff is the ring_buff_t instance
+ * @param len is the number of bytes to release
+ * \return None
+ */
+static void ring_buff_release(ring_buff_t *buff, uint16_t len);
+
+/*!
+ * \brief Make room for bytes to be added to the current packet
+ *
+ * Applies the overflow policy if there isn't enough room.
+ * Once a packet overflows, the rest of it is rejected until it is finished or cleared.
+ *
+ * @param buff is the ring_buff_t instance
+ * @param len is the number of bytes to make room for
+ * \return true if the bytes can be written
+ */
+static bool ring_buff_reserve(ring_buff_t *buff, uint16_t len);
+
+/*!
+ * \brief Discard the oldest unread packet to free memory
+ *
+ * Only done with the RING_BUFF_DROP_OLDEST policy and while the consumer isn't reading.
+ *
+ * @param buff is the ring_buff_t instance
+ * \return true if a packet was discarded
+ */
+static bool ring_buff_evict(ring_buff_t *buff);
+
+/*!
+ * \brief Stop the producer from evicting packets before the consumer reads the indices
+ *
+ * @param buff is the ring_buff_t instance
+ * \return None
+ */
+static inline void ring_buff_hold(ring_buff_t *buff);
+
+/*!
+ * \brief Allow eviction again after a read returned nothing
+ *
+ * The hold is kept if part of a packet was already read.
  *
  * @param buff is the ring_buff_t instance
- * @param ptr is a pointer to the ring buffer pointer to be incremented
  * \return None
  */
-static inline void ring_buff_increment_ptr(ring_buff_t *buff, uint8_t **ptr);
+static inline void ring_buff_release_hold(ring_buff_t *buff);
 
 /*!
- * \brief Calculate number of bytes between two ring buffer pointers
- * 
- * measures length from start_ptr to end_ptr.
- * if two pointers are the same, returns full length of the buffer.
+ * \brief Record the number of bytes stored if it is a new maximum
  *
  * @param buff is the ring_buff_t instance
- * @param start_ptr is the start of the region to measure
- * @param end_ptr is the end of the region to measure
- * \return length between pointers
+ * \return None
  */
-static uint16_t ring_buff_length(ring_buff_t *buff, uint8_t *start_ptr, uint8_t *end_ptr);
+static inline void ring_buff_update_high_water(ring_buff_t *buff);
 
 
 
@@ -50,67 +118,325 @@ static uint16_t ring_buff_length(ring_buff_t *buff, uint8_t *start_ptr, uint8_t
 // -------------------- public API -------------------- //
 // ---------------------------------------------------- //
 
-void ring_buff_init(ring_buff_t *buff, uint8_t *memory, uint16_t size) {
+bool ring_buff_init(ring_buff_t *buff, uint8_t *memory, uint16_t size) {
+    // size must be a non-zero power of two for index masking
+    if( (size == 0) || ((size & (size - 1)) != 0) ) {
+        buff->size = 0;
+        buff->mask = 0;
+        buff->start = NULL;
+        buff->desc = NULL;
+        return false;
+    }
+
     buff->size = size;
+    buff->mask = size - 1;
     buff->start = memory;
-    buff->read_ptr_byte = memory;
-    buff->read_ptr_packet = memory;
-    buff->write_ptr_byte = memory;
-    buff->write_ptr_packet = memory;
+    buff->read_idx_byte = 0;
+    buff->read_idx_packet = 0;
+    buff->write_idx_byte = 0;
+    buff->write_idx_packet = 0;
+    buff->desc = NULL;
+    buff->desc_mask = 0;
+    buff->desc_head = 0;
+    buff->desc_tail = 0;
+    buff->policy = RING_BUFF_REJECT_NEW;
+    buff->write_overflow = false;
+    buff->read_hold = false;
+    ring_buff_reset_stats(buff);
+    return true;
+}
+
+bool ring_buff_init_descriptors(ring_buff_t *buff, uint16_t *memory, uint16_t count) {
+    // count must be a power of two that fits the 8-bit descriptor indices
+    if( (count < 2) || (count > 256) || ((count & (count - 1)) != 0) ) {
+        return false;
+    }
+
+    buff->desc = memory;
+    buff->desc_mask = count - 1;
+    buff->desc_head = 0;
+    buff->desc_tail = 0;
+    return true;
+}
+
+bool ring_buff_set_policy(ring_buff_t *buff, ring_buff_policy_t policy) {
+    // packet boundaries must be known to discard whole packets
+    if( (policy == RING_BUFF_DROP_OLDEST) && (buff->desc == NULL) ) {
+        return false;
+    }
+    buff->policy = policy;
+    return true;
+}
+
+void ring_buff_get_stats(ring_buff_t *buff, ring_buff_stats_t *stats) {
+    // copy again if the producer updated the statistics part way through
+    do {
+        stats->dropped_bytes = buff->stats.dropped_bytes;
+        stats->dropped_frames = buff->stats.dropped_frames;
+        stats->high_water = buff->stats.high_water;
+    } while( (stats->dropped_bytes != buff->stats.dropped_bytes) ||
+             (stats->dropped_frames != buff->stats.dropped_frames) ||
+             (stats->high_water != buff->stats.high_water) );
+}
+
+void ring_buff_reset_stats(ring_buff_t *buff) {
+    buff->stats.dropped_bytes = 0;
+    buff->stats.dropped_frames = 0;
+    buff->stats.high_water = 0;
 }
 
 bool ring_buff_write(ring_buff_t *buff, uint8_t datum) {
-    if(ring_buff_length(buff, buff->write_ptr_byte, buff->read_ptr_packet) <= 1) {
+    uint16_t idx;
+
+    if(!ring_buff_reserve(buff, 1)) {
         return false;
     }
 
-    *buff->write_ptr_byte = datum;
+    idx = buff->write_idx_byte;
+    buff->start[idx] = datum;
+    buff->write_idx_byte = ring_buff_advance(buff, idx, 1);
+    ring_buff_update_high_water(buff);
+    return true;
+}
+
+bool ring_buff_write_block(ring_buff_t *buff, const uint8_t *data, uint16_t len) {
+    uint16_t idx;
+    uint16_t run;
+
+    if(!ring_buff_reserve(buff, len)) {
+        return false;
+    }
 
-    ring_buff_increment_ptr(buff, &buff->write_ptr_byte);
+    idx = buff->write_idx_byte;
+    // copy up to the end of the memory array, then wrap to the start
+    run = buff->size - idx;
+    if(run > len) {
+        run = len;
+    }
+    memcpy(buff->start + idx, data, run);
+    memcpy(buff->start, data + run, len - run);
+
+    buff->write_idx_byte = ring_buff_advance(buff, idx, len);
+    ring_buff_update_high_water(buff);
     return true;
 }
 
+uint16_t ring_buff_write_span(ring_buff_t *buff, uint8_t **span) {
+    uint16_t idx = buff->write_idx_byte;
+    uint16_t free_bytes = ring_buff_free(buff);
+    uint16_t run = buff->size - idx;
+
+    *span = buff->start + idx;
+    return (free_bytes < run) ? free_bytes : run;
+}
+
+void ring_buff_write_commit(ring_buff_t *buff, uint16_t len) {
+    buff->write_idx_byte = ring_buff_advance(buff, buff->write_idx_byte, len);
+    ring_buff_update_high_water(buff);
+}
+
 uint16_t ring_buff_write_finish_packet(ring_buff_t *buff) {
     uint16_t packet_size;
+    uint16_t idx = buff->write_idx_byte;
 
-    packet_size = ring_buff_length(buff, buff->write_ptr_packet, buff->write_ptr_byte);
-    buff->write_ptr_packet = buff->write_ptr_byte;
+    packet_size = ring_buff_length(buff, buff->write_idx_packet, idx);
+
+    // part of the packet was rejected, so none of it can be used
+    if(buff->write_overflow) {
+        ring_buff_write_clear_packet(buff);
+        return 0;
+    }
+
+    if(buff->desc != NULL) {
+        uint8_t head = buff->desc_head;
+        uint8_t next = (head + 1) & buff->desc_mask;
+
+        if(packet_size == 0) {
+            return 0;
+        }
+        // no room to record the packet, so it can't be finished
+        if( (next == buff->desc_tail) && !ring_buff_evict(buff) ) {
+            buff->write_idx_byte = buff->write_idx_packet;
+            buff->stats.dropped_frames++;
+            buff->stats.dropped_bytes += packet_size;
+            return 0;
+        }
+        // record the length before the packet becomes visible to the reader
+        buff->desc[head] = packet_size;
+        buff->desc_head = next;
+    }
+
+    buff->write_idx_packet = idx;
     return packet_size;
 }
 
 void ring_buff_write_clear_packet(ring_buff_t *buff) {
-    buff->write_ptr_byte = buff->write_ptr_packet;
+    // count a packet that overflowed as dropped
+    if(buff->write_overflow) {
+        buff->stats.dropped_frames++;
+        buff->stats.dropped_bytes += ring_buff_length(buff, buff->write_idx_packet, buff->write_idx_byte);
+        buff->write_overflow = false;
+    }
+    buff->write_idx_byte = buff->write_idx_packet;
 }
 
 bool ring_buff_read(ring_buff_t *buff, uint8_t *datum) {
+    uint16_t idx;
+
+    ring_buff_hold(buff);
+    idx = buff->read_idx_byte;
+
     // check if buffer is empty
-    if(buff->read_ptr_byte == buff->write_ptr_packet) {
+    if(idx == buff->write_idx_packet) {
+        ring_buff_release_hold(buff);
         return false;
     }
     if(datum != NULL) {
-        *datum = *buff->read_ptr_byte;
+        *datum = buff->start[idx];
     }
-    ring_buff_increment_ptr(buff, &buff->read_ptr_byte);
+    buff->read_idx_byte = ring_buff_advance(buff, idx, 1);
     return true;
 }
 
+uint16_t ring_buff_read_block(ring_buff_t *buff, uint8_t *data, uint16_t len) {
+    uint16_t idx;
+    uint16_t available;
+    uint16_t run;
+
+    ring_buff_hold(buff);
+    idx = buff->read_idx_byte;
+    available = ring_buff_length(buff, idx, buff->write_idx_packet);
+    if(available == 0) {
+        ring_buff_release_hold(buff);
+        return 0;
+    }
+
+    if(len > available) {
+        len = available;
+    }
+
+    if(data != NULL) {
+        // copy up to the end of the memory array, then wrap to the start
+        run = buff->size - idx;
+        if(run > len) {
+            run = len;
+        }
+        memcpy(data, buff->start + idx, run);
+        memcpy(data + run, buff->start, len - run);
+    }
+
+    buff->read_idx_byte = ring_buff_advance(buff, idx, len);
+    return len;
+}
+
+uint16_t ring_buff_read_span(ring_buff_t *buff, uint8_t **span) {
+    uint16_t idx;
+    uint16_t available;
+    uint16_t run;
+
+    ring_buff_hold(buff);
+    idx = buff->read_idx_byte;
+    available = ring_buff_length(buff, idx, buff->write_idx_packet);
+    run = buff->size - idx;
+    if(available == 0) {
+        ring_buff_release_hold(buff);
+    }
+
+    *span = buff->start + idx;
+    return (available < run) ? available : run;
+}
+
+void ring_buff_read_commit(ring_buff_t *buff, uint16_t len) {
+    buff->read_idx_byte = ring_buff_advance(buff, buff->read_idx_byte, len);
+}
+
+uint16_t ring_buff_peek_packet(ring_buff_t *buff, ring_buff_span_t span[2]) {
+    uint16_t idx;
+    uint16_t available;
+    uint16_t run;
+
+    // keep the producer from discarding the packet while it is in use
+    ring_buff_hold(buff);
+    idx = buff->read_idx_packet;
+    run = buff->size - idx;
+
+    // only return the oldest packet if the boundaries are known
+    if(buff->desc != NULL) {
+        available = (buff->desc_tail == buff->desc_head) ? 0 : buff->desc[buff->desc_tail];
+    }
+    else {
+        available = ring_buff_length(buff, idx, buff->write_idx_packet);
+    }
+    if(available == 0) {
+        ring_buff_release_hold(buff);
+    }
+
+    span[0].data = buff->start + idx;
+    span[1].data = buff->start;
+    if(available > run) {
+        span[0].len = run;
+        span[1].len = available - run;
+    }
+    else {
+        span[0].len = available;
+        span[1].len = 0;
+    }
+    return available;
+}
+
+void ring_buff_consume_packet(ring_buff_t *buff, uint16_t len) {
+    ring_buff_release(buff, len);
+    buff->read_idx_byte = buff->read_idx_packet;
+    buff->read_hold = false;
+}
+
+uint16_t ring_buff_skip_packet(ring_buff_t *buff) {
+    uint16_t packet_size;
+
+    if( (buff->desc == NULL) || (buff->desc_tail == buff->desc_head) ) {
+        return 0;
+    }
+
+    packet_size = buff->desc[buff->desc_tail];
+    ring_buff_consume_packet(buff, packet_size);
+    return packet_size;
+}
+
+uint16_t ring_buff_packet_count(ring_buff_t *buff) {
+    if(buff->desc != NULL) {
+        return (uint8_t)(buff->desc_head - buff->desc_tail) & buff->desc_mask;
+    }
+    return (buff->read_idx_packet != buff->write_idx_packet) ? 1 : 0;
+}
+
+uint16_t ring_buff_available(ring_buff_t *buff) {
+    return ring_buff_length(buff, buff->read_idx_byte, buff->write_idx_packet);
+}
+
 void ring_buff_clear_buff(ring_buff_t *buff) {
-    buff->read_ptr_byte = buff->start;
-    buff->read_ptr_packet = buff->start;
-    buff->write_ptr_byte = buff->start;
-    buff->write_ptr_packet = buff->start;
+    buff->read_idx_byte = 0;
+    buff->read_idx_packet = 0;
+    buff->write_idx_byte = 0;
+    buff->write_idx_packet = 0;
+    buff->desc_head = 0;
+    buff->desc_tail = 0;
+    buff->write_overflow = false;
+    buff->read_hold = false;
 }
 
 uint16_t ring_buff_read_finish_packet(ring_buff_t *buff) {
     uint16_t packet_size;
+    uint16_t idx = buff->read_idx_byte;
 
-    packet_size = ring_buff_length(buff, buff->read_ptr_packet, buff->read_ptr_byte);
-    buff->read_ptr_packet = buff->read_ptr_byte;
+    packet_size = ring_buff_length(buff, buff->read_idx_packet, idx);
+    ring_buff_release(buff, packet_size);
+    buff->read_hold = false;
     return packet_size;
 }
 
 void ring_buff_read_clear_packet(ring_buff_t *buff) {
-    buff->read_ptr_byte = buff->read_ptr_packet;
+    buff->read_idx_byte = buff->read_idx_packet;
+    buff->read_hold = false;
 }
 
 
@@ -121,21 +447,99 @@ void ring_buff_read_clear_packet(ring_buff_t *buff) {
 // -------------------- private API -------------------- //
 // ----------------------------------------------------- //
 
-static inline void ring_buff_increment_ptr(ring_buff_t *buff, uint8_t **ptr) {
-    *ptr += 1;
-    if(*ptr >= (buff->start + buff->size)) {
-        *ptr = buff->start;
+static inline uint16_t ring_buff_advance(ring_buff_t *buff, uint16_t idx, uint16_t len) {
+    return (idx + len) & buff->mask;
+}
+
+static inline uint16_t ring_buff_length(ring_buff_t *buff, uint16_t start_idx, uint16_t end_idx) {
+    return (end_idx - start_idx) & buff->mask;
+}
+
+static inline uint16_t ring_buff_free(ring_buff_t *buff) {
+    // one byte is always left empty to tell a full buffer apart from an empty one
+    return (buff->read_idx_packet - buff->write_idx_byte - 1) & buff->mask;
+}
+
+static void ring_buff_release(ring_buff_t *buff, uint16_t len) {
+    uint16_t idx = ring_buff_advance(buff, buff->read_idx_packet, len);
+    uint8_t tail;
+
+    if(buff->desc != NULL) {
+        tail = buff->desc_tail;
+        while( (len > 0) && (tail != buff->desc_head) ) {
+            // packet only partially released, shrink it to the remaining bytes
+            if(buff->desc[tail] > len) {
+                buff->desc[tail] -= len;
+                break;
+            }
+            len -= buff->desc[tail];
+            tail = (tail + 1) & buff->desc_mask;
+        }
+        buff->desc_tail = tail;
     }
+
+    buff->read_idx_packet = idx;
 }
 
-static uint16_t ring_buff_length(ring_buff_t *buff, uint8_t *start_ptr, uint8_t *end_ptr) {
-    int32_t diff;
+static bool ring_buff_reserve(ring_buff_t *buff, uint16_t len) {
+    // the rest of a packet that already overflowed is rejected
+    if(buff->write_overflow) {
+        buff->stats.dropped_bytes += len;
+        return false;
+    }
 
-    diff = end_ptr - start_ptr;
-    if(diff > 0) {
-        return diff;
+    // more than evicting every finished packet could free, reject it before anything is dropped for it
+    if(len > buff->mask - ring_buff_length(buff, buff->write_idx_packet, buff->write_idx_byte)) {
+        buff->write_overflow = true;
+        buff->stats.dropped_bytes += len;
+        return false;
     }
-    else {
-        return buff->size + diff;
+
+    while(ring_buff_free(buff) < len) {
+        if(!ring_buff_evict(buff)) {
+            buff->write_overflow = true;
+            buff->stats.dropped_bytes += len;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool ring_buff_evict(ring_buff_t *buff) {
+    uint8_t tail = buff->desc_tail;
+    uint16_t packet_size;
+    uint16_t idx;
+
+    if( (buff->policy != RING_BUFF_DROP_OLDEST) || buff->read_hold || (tail == buff->desc_head) ) {
+        return false;
+    }
+
+    packet_size = buff->desc[tail];
+    idx = ring_buff_advance(buff, buff->read_idx_packet, packet_size);
+    buff->read_idx_byte = idx;
+    buff->read_idx_packet = idx;
+    buff->desc_tail = (tail + 1) & buff->desc_mask;
+
+    buff->stats.dropped_frames++;
+    buff->stats.dropped_bytes += packet_size;
+    return true;
+}
+
+static inline void ring_buff_hold(ring_buff_t *buff) {
+    // the indices are read after this, so they are either from before or after the last eviction, never from during it
+    buff->read_hold = true;
+}
+
+static inline void ring_buff_release_hold(ring_buff_t *buff) {
+    if(buff->read_idx_byte == buff->read_idx_packet) {
+        buff->read_hold = false;
+    }
+}
+
+static inline void ring_buff_update_high_water(ring_buff_t *buff) {
+    uint16_t used = ring_buff_length(buff, buff->read_idx_packet, buff->write_idx_byte);
+
+    if(used > buff->stats.high_water) {
+        buff->stats.high_water = used;
     }
 }
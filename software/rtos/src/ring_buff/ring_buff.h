@@ -17,6 +17,7 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 
@@ -26,19 +27,65 @@ extern "C" {
 // -------------------- type definitions -------------------- //
 // ---------------------------------------------------------- //
 
+/** @enum ring_buff_policy_t
+ *  @brief action taken when a byte is written to a full ring buffer
+ *
+ */
+typedef enum {
+    RING_BUFF_REJECT_NEW,       /**< reject the new data and drop the packet being written */
+    RING_BUFF_DROP_OLDEST       /**< discard the oldest whole unread packets to make room */
+} ring_buff_policy_t;
+
+/** @struct ring_buff_stats_t
+ *  @brief overflow accounting for a ring buffer
+ *
+ */
+typedef struct {
+    uint32_t dropped_bytes;     /**< bytes lost, including the rest of every dropped packet */
+    uint16_t dropped_frames;    /**< packets lost to overflow or eviction */
+    uint16_t high_water;        /**< largest number of bytes stored at once */
+} ring_buff_stats_t;
+
 /** @struct ring_buff_t
  *  @brief object storing ring buffer configuration and status data
  *
+ *  Positions are stored as indices into the memory array and wrapped with a mask,
+ *  so the size of the memory array must be a power of two.
+ *  Safe for a single producer and a single consumer (e.g. an ISR and a task) without locking.
+ *  Each index is a single 16-bit word. The write indices and desc_head are only written by the producer.
+ *  The read indices and desc_tail are written by the consumer, and also by the producer when it evicts a packet
+ *  with RING_BUFF_DROP_OLDEST. read_hold is the handshake for that: the consumer sets it before it reads the
+ *  indices and keeps it while it has data in use, and the producer only evicts while it is clear.
+ *  An optional descriptor queue (see ring_buff_init_descriptors()) records the length of each finished packet.
+ *
  */
 typedef struct {
     uint16_t size;
+    uint16_t mask;
     uint8_t *start;
-    uint8_t *read_ptr_byte;
-    uint8_t *read_ptr_packet;
-    uint8_t *write_ptr_byte;
-    uint8_t *write_ptr_packet;
+    volatile uint16_t read_idx_byte;
+    volatile uint16_t read_idx_packet;
+    volatile uint16_t write_idx_byte;
+    volatile uint16_t write_idx_packet;
+    uint16_t *desc;
+    uint8_t desc_mask;
+    volatile uint8_t desc_head;
+    volatile uint8_t desc_tail;
+    ring_buff_policy_t policy;
+    volatile bool write_overflow;
+    volatile bool read_hold;
+    volatile ring_buff_stats_t stats;
 } ring_buff_t;
 
+/** @struct ring_buff_span_t
+ *  @brief contiguous region of a ring buffer's memory
+ *
+ */
+typedef struct {
+    uint8_t *data;
+    uint16_t len;
+} ring_buff_span_t;
+
 
 
 
@@ -50,95 +97,285 @@ typedef struct {
 /*!
  * \brief Initializes the ring buffer
  *
- * Assigns memory to the ring buffer and initializes the pointers to indicate an empty buffer.
+ * Assigns memory to the ring buffer and initializes the indices to indicate an empty buffer.
  * The number of bytes that can be stored in the buffer is size-1.
  * This function initializes all members of the ring_buff_t struct.
- * 
+ *
  * @param buff is the ring_buff_t instance to be initialized
  * @param memory is the memory array to store the buffer's data. This should be global scope
- * @param size is the length of the memory array in bytes
+ * @param size is the length of the memory array in bytes. Must be a power of two
+ * \return true if the buffer was initialized, false if size is not a power of two
+ *
+ */
+bool ring_buff_init(ring_buff_t *buff, uint8_t *memory, uint16_t size);
+
+/*!
+ * \brief Attaches a packet descriptor queue to the ring buffer
+ *
+ * Once attached, the length of each finished packet is recorded so readers can find packet
+ * boundaries without scanning the data. Must be called after ring_buff_init() and before the
+ * buffer is used. The number of packets that can be pending at once is count-1.
+ *
+ * @param buff is the ring_buff_t instance
+ * @param memory is the array to store the packet lengths. This should be global scope
+ * @param count is the length of the descriptor array. Must be a power of two between 2 and 256
+ * \return true if the queue was attached, false if count is not valid
+ *
+ */
+bool ring_buff_init_descriptors(ring_buff_t *buff, uint16_t *memory, uint16_t count);
+
+/*!
+ * \brief Selects what happens when data is written to a full ring buffer
+ *
+ * RING_BUFF_REJECT_NEW (the default) drops the packet being written.
+ * RING_BUFF_DROP_OLDEST discards the oldest whole packets that are not being read to make room.
+ * Dropping the oldest packets requires a descriptor queue and a producer that can't be interrupted
+ * by the consumer (e.g. a UART ISR writing and a task reading).
+ *
+ * @param buff is the ring_buff_t instance
+ * @param policy is the overflow policy to use
+ * \return true if the policy was set, false if it requires a descriptor queue
+ *
+ */
+bool ring_buff_set_policy(ring_buff_t *buff, ring_buff_policy_t policy);
+
+/*!
+ * \brief Get the overflow statistics of the ring buffer
+ *
+ * Safe to call while the producer is writing.
+ *
+ * @param buff is the ring_buff_t instance
+ * @param stats is updated with a copy of the statistics
+ * \return None
+ *
+ */
+void ring_buff_get_stats(ring_buff_t *buff, ring_buff_stats_t *stats);
+
+/*!
+ * \brief Clears the overflow statistics of the ring buffer
+ *
+ * @param buff is the ring_buff_t instance
  * \return None
  *
  */
-void ring_buff_init(ring_buff_t *buff, uint8_t *memory, uint16_t size);
+void ring_buff_reset_stats(ring_buff_t *buff);
 
 /*!
  * \brief Write a byte to the ring buffer
- * 
+ *
  * Writes a byte to the current packet being writen to the ring buffer.
  * This byte cannot be read out of the buffer until the packet is finished.
- * 
+ * If the byte doesn't fit, the rest of the packet is rejected and the packet is dropped when it is finished.
+ *
  * @param buff is the ring_buff_t instance
  * @param datum is the byte to add to the buffer
  * \return true if the byte was sucessfully writen to the buffer
- * 
+ *
  */
 bool ring_buff_write(ring_buff_t *buff, uint8_t datum);
 
+/*!
+ * \brief Write a block of bytes to the ring buffer
+ *
+ * Appends len bytes to the current packet being written to the ring buffer.
+ * Nothing is written unless there is room for the entire block.
+ * If the block doesn't fit, the rest of the packet is rejected and the packet is dropped when it is finished.
+ *
+ * @param buff is the ring_buff_t instance
+ * @param data is the array of bytes to add to the buffer
+ * @param len is the number of bytes to add
+ * \return true if the block was sucessfully written to the buffer
+ *
+ */
+bool ring_buff_write_block(ring_buff_t *buff, const uint8_t *data, uint16_t len);
+
+/*!
+ * \brief Get the contiguous free region at the write position
+ *
+ * Returns the largest run of free bytes that can be written without wrapping.
+ * The producer can fill the span directly and then call ring_buff_write_commit().
+ *
+ * @param buff is the ring_buff_t instance
+ * @param span is updated to point at the first free byte
+ * \return number of contiguous free bytes
+ *
+ */
+uint16_t ring_buff_write_span(ring_buff_t *buff, uint8_t **span);
+
+/*!
+ * \brief Commit bytes written directly into a write span
+ *
+ * Adds len bytes to the current packet. len must not exceed the value returned by ring_buff_write_span().
+ *
+ * @param buff is the ring_buff_t instance
+ * @param len is the number of bytes written into the span
+ * \return None
+ *
+ */
+void ring_buff_write_commit(ring_buff_t *buff, uint16_t len);
+
 /*!
  * \brief Mark the current packet being written as finished
- * 
+ *
  * Marks the current packet being written to the ring buffer as finished.
  * This finalizes the previous bytes written and allows them to be read in.
- * 
+ * If part of the packet was rejected, or a descriptor queue is attached and it is full, the packet is cleared instead.
+ *
  * @param buff is the ring_buff_t instance
- * \return size of the finished packet
- * 
+ * \return size of the finished packet. 0 if the packet was cleared
+ *
  */
 uint16_t ring_buff_write_finish_packet(ring_buff_t *buff);
 
 /*!
  * \brief Clears the packet currently being written
- * 
+ *
  * Removes all bytes written to the buffer since the last ring_buff_write_finish_packet() call.
  * Starts a new packet by discarding the old one.
- * 
+ *
  * @param buff is the ring_buff_t instance
  * \return None
- * 
+ *
  */
 void ring_buff_write_clear_packet(ring_buff_t *buff);
 
 /*!
  * \brief Reads a byte from the ring buffer
- * 
+ *
  * Reads in the next byte of the current packet.
  * The byte must be part of a complete packet to be read in.
- * 
+ *
  * @param buff is the ring_buff_t instance
  * @param datum is updated to the value read from the buffer
  * \return true if a value was available to read from the buffer
- * 
+ *
  */
 bool ring_buff_read(ring_buff_t *buff, uint8_t *datum);
 
+/*!
+ * \brief Reads a block of bytes from the ring buffer
+ *
+ * Reads up to len bytes of finished packets.
+ *
+ * @param buff is the ring_buff_t instance
+ * @param data is the array to copy the bytes into. NULL to skip the bytes
+ * @param len is the maximum number of bytes to read
+ * \return number of bytes read
+ *
+ */
+uint16_t ring_buff_read_block(ring_buff_t *buff, uint8_t *data, uint16_t len);
+
+/*!
+ * \brief Get the contiguous readable region at the read position
+ *
+ * Returns the largest run of finished bytes that can be read without wrapping.
+ * The consumer can use the span in place and then call ring_buff_read_commit().
+ *
+ * @param buff is the ring_buff_t instance
+ * @param span is updated to point at the first unread byte
+ * \return number of contiguous readable bytes
+ *
+ */
+uint16_t ring_buff_read_span(ring_buff_t *buff, uint8_t **span);
+
+/*!
+ * \brief Commit bytes read directly from a read span
+ *
+ * Advances the read position by len bytes. len must not exceed the value returned by ring_buff_read_span().
+ *
+ * @param buff is the ring_buff_t instance
+ * @param len is the number of bytes read from the span
+ * \return None
+ *
+ */
+void ring_buff_read_commit(ring_buff_t *buff, uint16_t len);
+
 /*!
  * \brief Marks a packet as done being read
- * 
+ *
  * Indicates to the ring buffer that the application has sucessfully read in the packet.
  * This will allow the packet's memory to be overwritten by new data.
- * 
+ *
  * @param buff is the ring_buff_t instance
  * \return size of the finished packet
- * 
+ *
  */
 uint16_t ring_buff_read_finish_packet(ring_buff_t *buff);
 
 /*!
  * \brief Restarts reading a packet
- * 
+ *
  * @param buff is the ring_buff_t instance
  * \return None
- * 
+ *
  */
 void ring_buff_read_clear_packet(ring_buff_t *buff);
 
+/*!
+ * \brief Get the finished data at the start of the unread packet without copying it
+ *
+ * Returns the finished, unread bytes as at most two contiguous spans.
+ * The second span is only non-empty when the data wraps around the end of the memory array.
+ * If a descriptor queue is attached only the oldest packet is returned,
+ * otherwise all finished packets are returned back to back.
+ * The data stays in the buffer until ring_buff_consume_packet() is called.
+ *
+ * @param buff is the ring_buff_t instance
+ * @param span is an array of two spans updated to the location of the data
+ * \return total number of bytes in both spans
+ *
+ */
+uint16_t ring_buff_peek_packet(ring_buff_t *buff, ring_buff_span_t span[2]);
+
+/*!
+ * \brief Releases data returned by ring_buff_peek_packet()
+ *
+ * Marks len bytes from the start of the unread packet as read, allowing their memory to be overwritten.
+ *
+ * @param buff is the ring_buff_t instance
+ * @param len is the number of bytes to release. Must not exceed the length returned by ring_buff_peek_packet()
+ * \return None
+ *
+ */
+void ring_buff_consume_packet(ring_buff_t *buff, uint16_t len);
+
+/*!
+ * \brief Discards the oldest unread packet without reading it
+ *
+ * Requires a descriptor queue. Any partial read of the packet is discarded as well.
+ *
+ * @param buff is the ring_buff_t instance
+ * \return size of the discarded packet. 0 if no packet was pending
+ *
+ */
+uint16_t ring_buff_skip_packet(ring_buff_t *buff);
+
+/*!
+ * \brief Get the number of finished packets waiting to be read
+ *
+ * Without a descriptor queue, packet boundaries are unknown and 1 is returned if any finished data is pending.
+ *
+ * @param buff is the ring_buff_t instance
+ * \return number of pending packets
+ *
+ */
+uint16_t ring_buff_packet_count(ring_buff_t *buff);
+
+/*!
+ * \brief Get the number of finished bytes waiting to be read
+ *
+ * @param buff is the ring_buff_t instance
+ * \return number of finished, unread bytes
+ *
+ */
+uint16_t ring_buff_available(ring_buff_t *buff);
+
 /*!
  * \brief Clears the entire ring buffer
- * 
+ *
  * @param buff is the ring_buff_t instance
  * \return None
- * 
+ *
  */
 void ring_buff_clear_buff(ring_buff_t *buff);
 
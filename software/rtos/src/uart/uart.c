@@ -22,18 +22,82 @@
  */
 
 #include <msp430.h>
-#include <math.h>
 #include <string.h>
 #include "uart.h"
 #include <driverlib.h>
 
 
+// DMA triggers of the USCI modules that have one
+#define UART_DMA_TRIGGER_A0_TX	DMA_TRIGGERSOURCE_17
+#define UART_DMA_TRIGGER_A1_TX	DMA_TRIGGERSOURCE_21
+#define UART_DMA_TRIGGER_A0_RX	DMA_TRIGGERSOURCE_16
+#define UART_DMA_TRIGGER_A1_RX	DMA_TRIGGERSOURCE_20
+#define UART_DMA_NUM_CHANNELS	3
+
+// UCBRSx modulation patterns, bit i is the extra clock added to bit i of a frame (bit 0 is the start bit)
+static const uint8_t uartBrsPattern[8] = {0x00, 0x02, 0x22, 0x2A, 0xAA, 0xAE, 0xEE, 0xFE};
+
 // Port Information List so user isn't forced to pass information all the time
 UARTConfig * prtInfList[5];
 
+// Port using each DMA channel, so the DMA ISR can find it
+static UARTConfig * dmaPortList[UART_DMA_NUM_CHANNELS];
+
+// Free-running Timer_B0 count in SMCLK cycles, used to time the callbacks
+#if defined(__MSP430_HAS_T0B7__)
+#define UART_STATS_TIMER() (TB0R)
+#else
+#define UART_STATS_TIMER() (0)
+#endif
+
 /* ----- Private Function Prototypes ----- */
-static void uartRxIsr(UARTConfig * prtInf);
-static void uartTxIsr(UARTConfig * prtInf);
+static inline void uartRxDispatch(UARTConfig * prtInf, uint8_t datum);
+static inline bool uartTxNext(UARTConfig * prtInf, uint8_t * datum);
+static uint16_t uartBaudError(UARTConfig * prtInf, const UARTBaudRegs * regs, uint8_t pattern);
+static inline bool uartRxStatus(UARTConfig * prtInf, uint8_t stat);
+static inline void uartStatsCallback(UARTConfig * prtInf, uint16_t start);
+static bool uartTxDmaClaim(UARTConfig * prtInf);
+static void uartTxIntKick(UARTConfig * prtInf);
+static void uartTxDmaStart(UARTConfig * prtInf, const uint8_t * src, uint16_t len);
+static void uartTxDmaKick(UARTConfig * prtInf);
+static void uartTxDmaIsr(UARTConfig * prtInf);
+
+/*
+ * Interrupt vector for USCI_An.
+ * Generated per module so the ISR touches the module's registers and UARTConfig directly
+ * instead of going through prtInfList and the USCIUARTRegs pointers.
+ */
+#define UART_PRAGMA(x) _Pragma(#x)
+#define UART_USCI_ISR(n)											\
+UART_PRAGMA(vector=USCI_A##n##_VECTOR)								\
+__interrupt void USCI_A##n##_ISR(void)								\
+{																	\
+	uint8_t datum;													\
+	switch(__even_in_range(UCA##n##IV,4))							\
+	{																\
+	  case 0:break;                 /* Vector 0 - no interrupt */	\
+	  case 2:                       /* Vector 2 - RXIFG */			\
+		if(uartRxStatus(&USCI_A##n##_cnf, UCA##n##STAT)) {			\
+			uartRxDispatch(&USCI_A##n##_cnf, UCA##n##RXBUF);		\
+		}															\
+		else {														\
+			/* Reading RXBUF discards the byte and clears the errors */	\
+			(void)UCA##n##RXBUF;									\
+		}															\
+		break;														\
+	  case 4:                       /* Vector 4 - TXIFG */			\
+		if(uartTxNext(&USCI_A##n##_cnf, &datum)) {					\
+			UCA##n##TXBUF = datum;									\
+		}															\
+		else {														\
+			/* Disable TX IE and clear TX IFG */					\
+			UCA##n##IE &= ~UCTXIE;									\
+			UCA##n##IFG &= ~UCTXIFG;								\
+		}															\
+		break;														\
+	  default: break;												\
+	}																\
+}
 
 /*!
  * \brief Initializes the UART Driver
@@ -50,6 +114,11 @@ void initUartDriver()
 	{
 		prtInfList[i] = NULL;
 	}
+
+#if defined(__MSP430_HAS_T0B7__)
+	// Timer_B0 counts SMCLK cycles continuously to time the callbacks
+	TB0CTL = TBSSEL__SMCLK | MC__CONTINUOUS | TBCLR;
+#endif
 }
 
 int initUSCIUart(UARTConfig * prtInf, ring_buff_t *txbuf, ring_buff_t *rxbuf){
@@ -57,9 +126,24 @@ int initUSCIUart(UARTConfig * prtInf, ring_buff_t *txbuf, ring_buff_t *rxbuf){
 	prtInf->rxBuf = rxbuf;
 	prtInf->rxCallback = NULL;
 	prtInf->rxCallbackParams = NULL;
+	prtInf->rxSpanCallback = NULL;
+	prtInf->rxSpanCallbackParams = NULL;
+	prtInf->rxTerminators = NULL;
+	prtInf->rxStageMax = UART_RX_STAGE_SIZE;
+	prtInf->rxStageLen = 0;
 	prtInf->txBuf = txbuf;
 	prtInf->txCallback = NULL;
 	prtInf->txCallbackParams = NULL;
+	prtInf->txDmaEnabled = false;
+	prtInf->txDmaBusy = false;
+	prtInf->txDmaUserBuf = false;
+	prtInf->txDmaLen = 0;
+	prtInf->txDoneCallback = NULL;
+	prtInf->txDoneCallbackParams = NULL;
+	prtInf->rxDmaEnabled = false;
+	prtInf->txIntBuf = NULL;
+	prtInf->txIntLen = 0;
+	memset((void *)&prtInf->stats, 0, sizeof(UARTStats));
 	switch(prtInf->moduleName){
 		case USCI_A0:
 			memcpy(&USCI_A0_cnf, prtInf, sizeof(UARTConfig));
@@ -137,6 +221,36 @@ void initUartRxCallback(UARTConfig * prtInf, void (*callback) (void *params, uin
 	prtInf->rxCallbackParams = params;
 }
 
+/*!
+ * \brief Registers the RX span callback for the UART module
+ *
+ * This function allows a callback function to receive a run of bytes at a time instead of one byte per interrupt.
+ * Received bytes are collected in a small staging buffer and handed to the callback when a terminator
+ * is received or maxLen bytes have been collected, so the callback is only run once per span.
+ * When receiving with DMA, uartDmaRxPoll() hands over the received bytes in place instead, one contiguous
+ * run of the DMA buffer at a time, regardless of terminators.
+ * The span callback takes priority over the single byte RX callback.
+ * The callback function will be called from within an Interrupt Service Routine (ISR) unless receiving with DMA.
+ *
+ * @param prtInf is UARTConfig instance with the configuration settings
+ * @param callback is the function pointer of the callback function
+ * @param params is a pointer to the memory storing application parameters to the callback function
+ * @param terminators is a NULL terminated string of bytes that end a span (the terminator is included). May be NULL
+ * @param maxLen is the maximum length of a span. Limited to UART_RX_STAGE_SIZE
+ *
+ */
+void initUartRxSpanCallback(UARTConfig * prtInf, void (*callback) (void *params, const uint8_t *data, uint16_t len), void *params, const char *terminators, uint8_t maxLen) {
+	if( (maxLen == 0) || (maxLen > UART_RX_STAGE_SIZE) ) {
+		maxLen = UART_RX_STAGE_SIZE;
+	}
+	prtInf->rxSpanCallback = NULL;
+	prtInf->rxStageLen = 0;
+	prtInf->rxTerminators = terminators;
+	prtInf->rxStageMax = maxLen;
+	prtInf->rxSpanCallbackParams = params;
+	prtInf->rxSpanCallback = callback;
+}
+
 /*!
  * \brief Registers the TX Callback for the UART module
  * 
@@ -154,6 +268,254 @@ void initUartTxCallback(UARTConfig * prtInf, bool (*callback) (void *params, uin
 	prtInf->txCallback = callback;
 	prtInf->txCallbackParams = params;
 }
+
+/*!
+ * \brief Configures a DMA channel to transmit for the UART module
+ *
+ * Once configured, uartSendDataInt() streams the TX ring buffer to the module with DMA instead of
+ * taking an interrupt per byte, and uartSendDataDma() can send a caller buffer without copying it.
+ * Only USCI_A0 and USCI_A1 can trigger DMA transfers. Must be called after initUSCIUart().
+ *
+ * @param prtInf is UARTConfig instance with the configuration settings
+ * @param channel is the DMA channel to use (DMA_CHANNEL_0 to DMA_CHANNEL_2). Must not be shared
+ * \return Success or errors as defined by UART_ERR_CODES
+ *
+ */
+int initUartTxDma(UARTConfig * prtInf, uint8_t channel)
+{
+	DMA_initParam param = {0};
+	uint8_t idx = channel >> 4;
+
+	switch(prtInf->moduleName)
+	{
+		case USCI_A0:
+			param.triggerSourceSelect = UART_DMA_TRIGGER_A0_TX;
+			break;
+		case USCI_A1:
+			param.triggerSourceSelect = UART_DMA_TRIGGER_A1_TX;
+			break;
+		default:
+			return UART_DMA_UNSUPPORTED;
+	}
+	if(idx >= UART_DMA_NUM_CHANNELS)
+	{
+		return UART_DMA_UNSUPPORTED;
+	}
+
+	// one byte per TXIFG rising edge, from an incrementing source into TXBUF
+	param.channelSelect = channel;
+	param.transferModeSelect = DMA_TRANSFER_SINGLE;
+	param.transferSize = 0;
+	param.transferUnitSelect = DMA_SIZE_SRCBYTE_DSTBYTE;
+	param.triggerTypeSelect = DMA_TRIGGER_RISINGEDGE;
+	DMA_init(&param);
+	DMA_setDstAddress(channel, (uint32_t)(uintptr_t)prtInf->usciRegs->TX_BUF, DMA_DIRECTION_UNCHANGED);
+	DMA_clearInterrupt(channel);
+	DMA_enableInterrupt(channel);
+
+	prtInf->txDmaChannel = channel;
+	prtInf->txDmaBusy = false;
+	prtInf->txDmaUserBuf = false;
+	prtInf->txDmaLen = 0;
+	dmaPortList[idx] = prtInf;
+	prtInf->txDmaEnabled = true;
+	return UART_SUCCESS;
+}
+
+/*!
+ * \brief Configures a DMA channel to receive for the UART module
+ *
+ * Received bytes are written by DMA into a circular buffer without any interrupts.
+ * The RX interrupt is disabled and the bytes are handed to the RX callback (or RX ring buffer)
+ * from task context by uartDmaRxPoll(). The buffer must be large enough to hold everything
+ * received between two polls, since the DMA overwrites bytes that haven't been polled yet.
+ * Only USCI_A0 and USCI_A1 can trigger DMA transfers. Must be called after initUSCIUart().
+ *
+ * @param prtInf is UARTConfig instance with the configuration settings
+ * @param channel is the DMA channel to use (DMA_CHANNEL_0 to DMA_CHANNEL_2). Must not be shared
+ * @param mem is the circular buffer for the DMA to write into. This should be global scope
+ * @param size is the length of the circular buffer in bytes
+ * \return Success or errors as defined by UART_ERR_CODES
+ *
+ */
+int initUartDmaRx(UARTConfig * prtInf, uint8_t channel, uint8_t * mem, uint16_t size)
+{
+	DMA_initParam param = {0};
+
+	switch(prtInf->moduleName)
+	{
+		case USCI_A0:
+			param.triggerSourceSelect = UART_DMA_TRIGGER_A0_RX;
+			break;
+		case USCI_A1:
+			param.triggerSourceSelect = UART_DMA_TRIGGER_A1_RX;
+			break;
+		default:
+			return UART_DMA_UNSUPPORTED;
+	}
+	if( ((channel >> 4) >= UART_DMA_NUM_CHANNELS) || (size == 0) )
+	{
+		return UART_DMA_UNSUPPORTED;
+	}
+
+	// the DMA takes over the RX flag from the interrupt
+	*prtInf->usciRegs->IE_REG &= ~UCRXIE;
+
+	// one byte per RXIFG from RXBUF into the buffer, restarting at the beginning after the last byte
+	param.channelSelect = channel;
+	param.transferModeSelect = DMA_TRANSFER_REPEATED_SINGLE;
+	param.transferSize = size;
+	param.transferUnitSelect = DMA_SIZE_SRCBYTE_DSTBYTE;
+	param.triggerTypeSelect = DMA_TRIGGER_RISINGEDGE;
+	DMA_init(&param);
+	DMA_setSrcAddress(channel, (uint32_t)(uintptr_t)prtInf->usciRegs->RX_BUF, DMA_DIRECTION_UNCHANGED);
+	DMA_setDstAddress(channel, (uint32_t)(uintptr_t)mem, DMA_DIRECTION_INCREMENT);
+
+	prtInf->rxDmaChannel = channel;
+	prtInf->rxDmaMem = mem;
+	prtInf->rxDmaSize = size;
+	prtInf->rxDmaReadIdx = 0;
+	prtInf->rxDmaEnabled = true;
+	DMA_enableTransfers(channel);
+	return UART_SUCCESS;
+}
+
+/*!
+ * \brief Hands the bytes received by DMA since the last poll to the application
+ *
+ * Each byte is passed to the RX callback, or written to the RX ring buffer as a finished frame
+ * if there is no callback, the same way the RX interrupt would. The callback is called from the
+ * context of the caller rather than from an ISR.
+ *
+ * @param prtInf is a pointer to the UART configuration. DMA must be set up with initUartDmaRx()
+ * \return number of bytes handed out
+ *
+ */
+int uartDmaRxPoll(UARTConfig * prtInf)
+{
+	uint16_t read_idx = prtInf->rxDmaReadIdx;
+	uint16_t write_idx;
+	int count = 0;
+
+	if(!prtInf->rxDmaEnabled)
+	{
+		return 0;
+	}
+
+	// DMAxSZ counts down once per byte and is reloaded with the buffer size after the last one
+	write_idx = prtInf->rxDmaSize - DMA_getTransferSize(prtInf->rxDmaChannel);
+	if(write_idx >= prtInf->rxDmaSize)
+	{
+		write_idx = 0;
+	}
+
+	// hand over the new bytes in place, at most two runs if they wrap around the end of the buffer
+	if(prtInf->rxSpanCallback != NULL)
+	{
+		while(read_idx != write_idx)
+		{
+			uint16_t run_end = (write_idx > read_idx) ? write_idx : prtInf->rxDmaSize;
+			uint16_t start = UART_STATS_TIMER();
+			prtInf->rxSpanCallback(prtInf->rxSpanCallbackParams, &prtInf->rxDmaMem[read_idx], run_end - read_idx);
+			uartStatsCallback(prtInf, start);
+			prtInf->stats.rxBytes += run_end - read_idx;
+			count += run_end - read_idx;
+			read_idx = (run_end == prtInf->rxDmaSize) ? 0 : run_end;
+		}
+	}
+
+	while(read_idx != write_idx)
+	{
+		uartRxDispatch(prtInf, prtInf->rxDmaMem[read_idx]);
+		read_idx++;
+		if(read_idx == prtInf->rxDmaSize)
+		{
+			read_idx = 0;
+		}
+		count++;
+	}
+
+	prtInf->rxDmaReadIdx = read_idx;
+	return count;
+}
+
+/*!
+ * \brief Feeds recorded bytes through the RX path as if they had been received
+ *
+ * Used to replay serial captures through the real drivers on the board. The bytes are handed out
+ * exactly like received ones: to the span callback in place on DMA ports, otherwise one at a time
+ * to the span callback staging, the RX callback or the RX ring buffer. The callbacks are called
+ * from the context of the caller. The port's receiver must be idle (RX interrupt disabled with
+ * disableUSCIUartInterrupts() and no DMA poll running) so there is a single producer.
+ * Pace the calls (e.g. baudRate/10 bytes per second) to reproduce a given link speed.
+ *
+ * @param prtInf is a pointer to the UART configuration
+ * @param buf is the array of recorded bytes
+ * @param len is the number of bytes to feed
+ * \return number of bytes handed out
+ *
+ */
+int uartReplayRx(UARTConfig * prtInf, const unsigned char * buf, int len)
+{
+	int i;
+
+	if(len <= 0)
+	{
+		return 0;
+	}
+
+	// DMA ports pass whole runs to the span callback, see uartDmaRxPoll()
+	if(prtInf->rxDmaEnabled && prtInf->rxSpanCallback != NULL)
+	{
+		prtInf->rxSpanCallback(prtInf->rxSpanCallbackParams, buf, len);
+		return len;
+	}
+
+	for(i = 0; i < len; i++)
+	{
+		uartRxDispatch(prtInf, buf[i]);
+	}
+	return len;
+}
+
+/*!
+ * \brief Takes a snapshot of the traffic and error counters of a UART port
+ *
+ * The counters are copied with interrupts disabled so they are consistent with each other.
+ * Framing and parity errors aren't detected on ports receiving with DMA.
+ *
+ * @param prtInf is a pointer to the UART configuration
+ * @param stats is updated with a copy of the counters, the average callback time and the TX queue depth
+ * \return None
+ *
+ */
+void uartGetStats(UARTConfig * prtInf, UARTStats * stats)
+{
+	unsigned short state = __get_interrupt_state();
+
+	__disable_interrupt();
+	memcpy(stats, (const void *)&prtInf->stats, sizeof(UARTStats));
+	__set_interrupt_state(state);
+
+	stats->callbackAvg = (stats->callbackCount > 0) ? (uint16_t)(stats->callbackTotal / stats->callbackCount) : 0;
+	stats->txQueued = (prtInf->txBuf != NULL) ? ring_buff_available(prtInf->txBuf) : 0;
+}
+
+/*!
+ * \brief Clears the traffic and error counters of a UART port
+ *
+ * @param prtInf is a pointer to the UART configuration
+ * \return None
+ *
+ */
+void uartResetStats(UARTConfig * prtInf)
+{
+	unsigned short state = __get_interrupt_state();
+
+	__disable_interrupt();
+	memset((void *)&prtInf->stats, 0, sizeof(UARTStats));
+	__set_interrupt_state(state);
+}
 /*!
  * \brief Configures the MSP430 pins for UART module
  *
@@ -327,6 +689,9 @@ int configUSCIUart(UARTConfig * prtInf,USCIUARTRegs * confRegs)
 	// Place Module in reset to allow us to modify its bits
 	*confRegs->CTL1_REG |= UCSWRST;
 
+	// Interrupt on bytes with framing or parity errors too, so they can be counted
+	*confRegs->CTL1_REG |= UCRXEIE;
+
 	// Configure UART Settings
 	if(prtInf->parity == UART_PARITY_EVEN)
 	{
@@ -363,31 +728,20 @@ int configUSCIUart(UARTConfig * prtInf,USCIUARTRegs * confRegs)
 	}
 
 	// Set the baudrate dividers and modulation
-	unsigned int N_div;
-	N_div = prtInf->clkRate / prtInf->baudRate;
-
-	float N_div_f;
-	N_div_f = (float)prtInf->clkRate / (float)prtInf->baudRate;
-
-	if(N_div >= 16)
+	UARTBaudRegs baud;
+	if(uartCalcBaudRate(prtInf, &baud) != UART_SUCCESS)
 	{
-		// We can use Oversampling mode
-		N_div /= 16;
-		*confRegs->BR0_REG = (N_div & 0x00FF);
-		*confRegs->BR1_REG = ((N_div & 0xFF00) >> 8);
-
-		N_div_f /= 16.0;
-		*confRegs->MCTL_REG = (unsigned char)(((N_div_f) - round(N_div_f))*16.0f) << 4; // Set BRF
-		*confRegs->MCTL_REG |= UCOS16; // Enable Oversampling Mode
+		return UART_BAD_BAUD_RATE;
 	}
-	else
-	{
-		// We must use the Low Frequency mode
-		*confRegs->BR0_REG = (N_div & 0x00FF);
-		*confRegs->BR1_REG = ((N_div & 0xFF00) >> 8);
 
-		*confRegs->MCTL_REG = (unsigned char)((N_div_f - round(N_div_f))*8.0f) << 1; // Set BRS
+	*confRegs->BR0_REG = (baud.brx & 0x00FF);
+	*confRegs->BR1_REG = ((baud.brx & 0xFF00) >> 8);
+	*confRegs->MCTL_REG = (baud.brf << 4) | (baud.brs << 1); // Set BRF and BRS
+	if(baud.oversampling)
+	{
+		*confRegs->MCTL_REG |= UCOS16; // Enable Oversampling Mode
 	}
+	prtInf->baudError = baud.errorPermille;
 
 	// Take Module out of reset
 	*confRegs->CTL1_REG &= ~UCSWRST;
@@ -516,15 +870,16 @@ int configUSARTUart(UARTConfig * prtInf, USARTUARTRegs * confRegs)
 	}
 
 	// Set the baudrate dividers and modulation
-	unsigned int N_div;
-	N_div = prtInf->clkRate / prtInf->baudRate;
-
-
-	*confRegs->UBR0_REG = (N_div & 0x00FF);
-	*confRegs->UBR1_REG = ((N_div & 0xFF00) >> 8);
+	UARTBaudRegs baud;
+	if(uartCalcBaudRate(prtInf, &baud) != UART_SUCCESS)
+	{
+		return UART_BAD_BAUD_RATE;
+	}
 
-	// Modulation currently set to 0. Needs proper handling
-	*confRegs->UMCTL_REG = 0;
+	*confRegs->UBR0_REG = (baud.brx & 0x00FF);
+	*confRegs->UBR1_REG = ((baud.brx & 0xFF00) >> 8);
+	*confRegs->UMCTL_REG = baud.umctl;
+	prtInf->baudError = baud.errorPermille;
 
 	// Take Module out of reset
 	*confRegs->U0CTL_REG &= ~SWRST;
@@ -540,6 +895,95 @@ int configUSARTUart(UARTConfig * prtInf, USARTUARTRegs * confRegs)
 
 #endif
 
+/*!
+ * \brief Computes the baud rate generator settings for a UART
+ *
+ * Follows the algorithm of the MSP430x5xx family user's guide with integer math:
+ * oversampling is used when clkRate/baudRate is at least 16, with UCBRFx rounded to the nearest
+ * sixteenth, and UCBRSx is then chosen as the pattern with the smallest bit timing error.
+ * USART modules get a UMCTL pattern that ends every bit of the frame as close to its ideal time as possible.
+ * The worst-case error is computed over a whole frame using the databits, parity and stopbits settings.
+ *
+ * @param prtInf is UARTConfig instance with the clock rate, baud rate and frame format
+ * @param regs is updated with the register values and the worst-case bit error
+ * \return Success or errors as defined by UART_ERR_CODES
+ *
+ */
+int uartCalcBaudRate(UARTConfig * prtInf, UARTBaudRegs * regs)
+{
+	unsigned long clk = prtInf->clkRate;
+	unsigned long baud = prtInf->baudRate;
+	unsigned long rem;
+	unsigned long cycles = 0;
+	uint16_t error;
+	uint8_t i;
+
+	memset(regs, 0, sizeof(UARTBaudRegs));
+
+	// the baud rate generator needs at least 3 clocks per bit
+	if( (baud == 0) || (clk / baud < 3) || (clk / baud > 0xFFFF) )
+	{
+		return UART_BAD_BAUD_RATE;
+	}
+
+	if(prtInf->moduleName == USART_0 || prtInf->moduleName == USART_1)
+	{
+		regs->brx = clk / baud;
+
+		// add a clock to every bit that would otherwise end more than half a clock early
+		for(i = 0; i < 8; i++)
+		{
+			cycles += regs->brx;
+			if(2 * cycles * baud + baud < 2 * (i + 1) * clk)
+			{
+				regs->umctl |= 1 << i;
+				cycles++;
+			}
+		}
+		regs->errorPermille = uartBaudError(prtInf, regs, regs->umctl);
+		return UART_SUCCESS;
+	}
+
+	if(clk / baud >= 16)
+	{
+		// Oversampling mode, UCBRFx is the rounded fractional part of N/16 in sixteenths
+		regs->oversampling = true;
+		regs->brx = clk / (16 * baud);
+		rem = clk - (unsigned long)regs->brx * 16 * baud;
+		regs->brf = (rem + baud / 2) / baud;
+		if(regs->brf == 16)
+		{
+			regs->brx++;
+			regs->brf = 0;
+		}
+	}
+	else
+	{
+		// Low Frequency mode, UCBRSx is the rounded fractional part of N in eighths
+		regs->brx = clk / baud;
+		rem = clk - (unsigned long)regs->brx * baud;
+		regs->brs = (rem * 8 + baud / 2) / baud;
+		if(regs->brs == 8)
+		{
+			regs->brx++;
+			regs->brs = 0;
+		}
+	}
+
+	// the rounded UCBRSx isn't always the best pattern, keep the one with the smallest error
+	regs->errorPermille = uartBaudError(prtInf, regs, uartBrsPattern[regs->brs]);
+	for(i = 0; i < 8; i++)
+	{
+		error = uartBaudError(prtInf, regs, uartBrsPattern[i]);
+		if(error < regs->errorPermille)
+		{
+			regs->errorPermille = error;
+			regs->brs = i;
+		}
+	}
+	return UART_SUCCESS;
+}
+
 /*!
  * \brief Returns a pointer to the RX Buffer
  *
@@ -572,33 +1016,48 @@ ring_buff_t * getUartRxBuffer(UARTConfig * prtInf)
 int uartSendDataBlocking(UARTConfig * prtInf,unsigned char * buf, int len)
 {
 	int i = 0;
-	for(i = 0; i < len; i++)
-	{
-#if (defined(__MSP430_HAS_USCI_A0__) || defined(__MSP430_HAS_USCI_A1__) || defined(__MSP430_HAS_USCI_A2__)) || defined(__MSP430_HAS_USCI_A3__) && (!defined(__MSP430_HAS_USCI__))
-		if(prtInf->moduleName == USCI_A0|| prtInf->moduleName == USCI_A1 || prtInf->moduleName == USCI_A2 || prtInf->moduleName == USCI_A3)
-		{
+	volatile unsigned char * ifgReg = NULL;
+	volatile unsigned char * txBuf = NULL;
+	unsigned char txFlag = 0;
 
-			while(!( *prtInf->usciRegs->IFG_REG & UCTXIFG));
-			*prtInf->usciRegs->TX_BUF = buf[i];
-		}
+	// look up the registers once instead of for every byte
+#if (defined(__MSP430_HAS_USCI_A0__) || defined(__MSP430_HAS_USCI_A1__) || defined(__MSP430_HAS_USCI_A2__)) || defined(__MSP430_HAS_USCI_A3__) && (!defined(__MSP430_HAS_USCI__))
+	if(prtInf->moduleName == USCI_A0|| prtInf->moduleName == USCI_A1 || prtInf->moduleName == USCI_A2 || prtInf->moduleName == USCI_A3)
+	{
+		ifgReg = prtInf->usciRegs->IFG_REG;
+		txBuf = prtInf->usciRegs->TX_BUF;
+		txFlag = UCTXIFG;
+	}
 #else
-		if(prtInf->moduleName == UCA0)
-		{
-			while(!( *prtInf->usciRegs->IFG_REG & UCA0TXIFG));
-			*prtInf->usciRegs->TX_BUF = buf[i];
-		}
+	if(prtInf->moduleName == UCA0)
+	{
+		ifgReg = prtInf->usciRegs->IFG_REG;
+		txBuf = prtInf->usciRegs->TX_BUF;
+		txFlag = UCA0TXIFG;
+	}
 #endif
 
-
-		if(prtInf->moduleName == USART_0|| prtInf->moduleName == USART_1)
-		{
 #if defined(__MSP430_HAS_UART0__) || defined(__MSP430_HAS_UART1__)
-			while(!(*prtInf->usartRegs->IFG_REG & prtInf->usartRegs->TXIFGFlag));
-			*prtInf->usciRegs->TX_BUF = buf[i];
+	if(prtInf->moduleName == USART_0|| prtInf->moduleName == USART_1)
+	{
+		ifgReg = prtInf->usartRegs->IFG_REG;
+		txBuf = prtInf->usciRegs->TX_BUF;
+		txFlag = prtInf->usartRegs->TXIFGFlag;
+	}
 #endif
-		}
+
+	if(ifgReg == NULL)
+	{
+		return UART_BAD_MODULE_NAME;
 	}
 
+	for(i = 0; i < len; i++)
+	{
+		while(!(*ifgReg & txFlag));
+		*txBuf = buf[i];
+	}
+	prtInf->stats.txBytes += len;
+
 	return UART_SUCCESS;
 }
 
@@ -660,52 +1119,152 @@ int uartSendDataInt(UARTConfig * prtInf,unsigned char * buf, int len)
 		return UART_NO_TX_BUFF;
 	}
 
+	// Stream the ring buffer with DMA instead. If a transfer is already running, the DMA ISR
+	// picks up the new packet when it finishes.
+	if(prtInf->txDmaEnabled && prtInf->txBuf != NULL)
+	{
+		uartTxDmaKick(prtInf);
+		return UART_SUCCESS;
+	}
+
 	// Send the first byte. Since UART interrupt is enabled, it will be called once the byte is sent and will
 	// send the rest of the bytes
+	uartTxIntKick(prtInf);
+	return UART_SUCCESS;
+}
 
-#if (defined(__MSP430_HAS_USCI_A0__) || defined(__MSP430_HAS_USCI_A1__) || defined(__MSP430_HAS_USCI_A2__)) && (!defined(__MSP430_HAS_USCI__))
+/*!
+ * \brief Sends len number of bytes from a caller buffer without blocking
+ *
+ * The buffer is sent in place, with DMA if it was set up with initUartTxDma() and by the TX
+ * interrupt otherwise. It must not be modified until the callback is called.
+ * The callback is called from within an Interrupt Service Routine (ISR) once the last byte
+ * has been moved into the TX buffer of the module. Anything queued with uartSendDataInt()
+ * is sent after the caller buffer.
+ *
+ * @param prtInf is a pointer to the UART configuration
+ * @param buf is a pointer to the buffer containing the bytes to be sent.
+ * @param len is an integer containing the number of bytes to send.
+ * @param callback is the function to call when the transfer is complete. May be NULL
+ * @param params is a pointer to the application parameters for the callback function
+ *
+ * \return Success or errors as defined by UART_ERR_CODES. UART_TX_BUSY if a caller buffer is already being sent
+ *
+ */
+int uartSendDataAsync(UARTConfig * prtInf, const unsigned char * buf, int len, void (*callback) (void *params), void *params)
+{
+	unsigned short state;
+	bool claimed = false;
 
-	if(prtInf->moduleName == USCI_A0 || prtInf->moduleName == USCI_A1 || prtInf->moduleName == USCI_A2 || prtInf->moduleName == USCI_A3)
+	if(prtInf->txDmaEnabled)
 	{
-		// Enable TX IE
-		*prtInf->usciRegs->IFG_REG &= ~UCTXIFG;
-		*prtInf->usciRegs->IE_REG |= UCTXIE;
-
-		// Trigger the TX IFG. This will cause the Interrupt Vector to be called
-		// which will send the data one byte at a time at each interrupt trigger.
-		*prtInf->usciRegs->IFG_REG |= UCTXIFG;
+		return uartSendDataDma(prtInf, buf, len, callback, params);
 	}
-#else
-	if(prtInf->moduleName == UCA0)
+	if(len <= 0)
 	{
-		// Enable TX IE
-		*prtInf->usciRegs->IFG_REG &= ~UCA0TXIFG;
-		*prtInf->usciRegs->IE_REG |= UCA0TXIE;
+		return UART_SUCCESS;
+	}
 
-		// Trigger the TX IFG. This will cause the Interrupt Vector to be called
-		// which will send the data one byte at a time at each interrupt trigger.
-		*prtInf->usciRegs->IFG_REG |= UCA0TXIFG;
+	// the TX ISR releases the buffer, so test and set it with interrupts disabled
+	state = __get_interrupt_state();
+	__disable_interrupt();
+	if(prtInf->txIntBuf == NULL)
+	{
+		prtInf->txDoneCallback = callback;
+		prtInf->txDoneCallbackParams = params;
+		prtInf->txIntLen = len;
+		prtInf->txIntBuf = buf;
+		claimed = true;
 	}
-#endif
+	__set_interrupt_state(state);
 
-#if defined(__MSP430_HAS_UART0__) || defined(__MSP430_HAS_UART1__)
-	if(prtInf->moduleName == USART_0|| prtInf->moduleName == USART_1)
+	if(!claimed)
 	{
-		// Clear TX IFG and Enable TX IE
-		*prtInf->usartRegs->IFG_REG &= ~ prtInf->usartRegs->TXIFGFlag;
-		*prtInf->usartRegs->IE_REG |= prtInf->usartRegs->TXIE;
+		return UART_TX_BUSY;
+	}
 
-		// Trigger the TX IFG. This will cause the Interrupt Vector to be called
-		// which will send the data one byte at a time at each interrupt trigger.
-		*prtInf->usartRegs->IFG_REG |= prtInf->usartRegs->TXIFGFlag;
+	uartTxIntKick(prtInf);
+	return UART_SUCCESS;
+}
 
+/*!
+ * \brief Stops sending the caller buffer passed to uartSendDataAsync() or uartSendDataDma()
+ *
+ * The completion callback is not called, even if the transmission finished just before. The DMA transfer or TX ISR
+ * stops reading the buffer before this returns, so it can go out of scope. The bytes already moved into the module are still sent.
+ * Anything queued in the TX ring buffer is sent once the next transmission starts.
+ *
+ * @param prtInf is a pointer to the UART configuration
+ * \return None
+ *
+ */
+void uartSendDataAbort(UARTConfig * prtInf)
+{
+	unsigned short state = __get_interrupt_state();
+
+	__disable_interrupt();
+	prtInf->txIntBuf = NULL;
+	prtInf->txIntLen = 0;
+	prtInf->txDoneCallback = NULL;
+	if(prtInf->txDmaBusy && prtInf->txDmaUserBuf)
+	{
+		// a transfer that just finished mustn't be reported once interrupts are enabled again
+		DMA_disableTransfers(prtInf->txDmaChannel);
+		DMA_clearInterrupt(prtInf->txDmaChannel);
+		prtInf->txDmaUserBuf = false;
+		prtInf->txDmaLen = 0;
+		prtInf->txDmaBusy = false;
 	}
-#endif
+	__set_interrupt_state(state);
+}
+
+/*!
+ * \brief Sends len number of bytes from a caller buffer using DMA
+ *
+ * The buffer is sent in place with a single interrupt at the end of the transfer.
+ * It must not be modified until the callback is called.
+ * The callback is called from within an Interrupt Service Routine (ISR) once the last byte
+ * has been moved into the TX buffer of the module.
+ *
+ * @param prtInf is a pointer to the UART configuration. DMA must be set up with initUartTxDma()
+ * @param buf is a pointer to the buffer containing the bytes to be sent.
+ * @param len is an integer containing the number of bytes to send.
+ * @param callback is the function to call when the transfer is complete. May be NULL
+ * @param params is a pointer to the application parameters for the callback function
+ *
+ * \return Success or errors as defined by UART_ERR_CODES
+ *
+ */
+int uartSendDataDma(UARTConfig * prtInf, const unsigned char * buf, int len, void (*callback) (void *params), void *params)
+{
+	if(!prtInf->txDmaEnabled)
+	{
+		return UART_DMA_UNSUPPORTED;
+	}
+	if(len <= 0)
+	{
+		return UART_SUCCESS;
+	}
+	if(!uartTxDmaClaim(prtInf))
+	{
+		return UART_TX_BUSY;
+	}
+
+	prtInf->txDoneCallback = callback;
+	prtInf->txDoneCallbackParams = params;
+	prtInf->txDmaUserBuf = true;
+	uartTxDmaStart(prtInf, buf, len);
 	return UART_SUCCESS;
 }
 
 void enableUartRx(UARTConfig * prtInf)
 {
+	// the RX flag is serviced by DMA instead
+	if(prtInf->rxDmaEnabled)
+	{
+		return;
+	}
+
 #if (defined(__MSP430_HAS_USCI_A0__) || defined(__MSP430_HAS_USCI_A1__) || defined(__MSP430_HAS_USCI_A2__)) && (!defined(__MSP430_HAS_USCI__))
 	if(prtInf->moduleName == USCI_A0|| prtInf->moduleName == USCI_A1 || prtInf->moduleName == USCI_A2 || prtInf->moduleName == USCI_A3)
 	{
@@ -732,38 +1291,264 @@ void enableUartRx(UARTConfig * prtInf)
 #endif
 }
 
-static void uartRxIsr(UARTConfig * prtInf) {
+static inline void uartRxDispatch(UARTConfig * prtInf, uint8_t datum) {
+	uint16_t start;
+
+	prtInf->stats.rxBytes++;
+
+	// rx span Callback
+	if(prtInf->rxSpanCallback != NULL) {
+		const char * terminator = prtInf->rxTerminators;
+		bool flush = false;
+
+		prtInf->rxStage[prtInf->rxStageLen++] = datum;
+		if(prtInf->rxStageLen >= prtInf->rxStageMax) {
+			flush = true;
+		}
+		else if(terminator != NULL) {
+			while( (*terminator != '\0') && (*terminator != (char)datum) ) {
+				terminator++;
+			}
+			flush = (*terminator != '\0');
+		}
+
+		if(flush) {
+			start = UART_STATS_TIMER();
+			prtInf->rxSpanCallback(prtInf->rxSpanCallbackParams, prtInf->rxStage, prtInf->rxStageLen);
+			uartStatsCallback(prtInf, start);
+			prtInf->rxStageLen = 0;
+		}
+	}
 	// rx Callback
-	if(prtInf->rxCallback != NULL) {
-		prtInf->rxCallback(prtInf->rxCallbackParams, *prtInf->usciRegs->RX_BUF);
+	else if(prtInf->rxCallback != NULL) {
+		start = UART_STATS_TIMER();
+		prtInf->rxCallback(prtInf->rxCallbackParams, datum);
+		uartStatsCallback(prtInf, start);
 	}
 	// default
 	else if(prtInf->rxBuf != NULL) {
-		ring_buff_write(prtInf->rxBuf, *prtInf->usciRegs->RX_BUF);
+		ring_buff_write(prtInf->rxBuf, datum);
 		ring_buff_write_finish_packet(prtInf->rxBuf);
 	}
 }
 
-static void uartTxIsr(UARTConfig * prtInf) {
+static inline bool uartTxNext(UARTConfig * prtInf, uint8_t * datum) {
+	// caller buffer from uartSendDataAsync()
+	if(prtInf->txIntBuf != NULL) {
+		if(prtInf->txIntLen > 0) {
+			*datum = *prtInf->txIntBuf++;
+			prtInf->txIntLen--;
+			prtInf->stats.txBytes++;
+			return true;
+		}
+		prtInf->txIntBuf = NULL;
+		if(prtInf->txDoneCallback != NULL) {
+			prtInf->txDoneCallback(prtInf->txDoneCallbackParams);
+		}
+	}
 	// tx Callback
 	if(prtInf->txCallback != NULL) {
-		if(!prtInf->txCallback(prtInf->txCallbackParams, prtInf->usciRegs->TX_BUF)) {
-            *prtInf->usciRegs->IE_REG &= ~UCTXIE;
-            // Clear TX IFG
-            *prtInf->usciRegs->IFG_REG &= ~UCTXIFG;
+		uint16_t start = UART_STATS_TIMER();
+		bool next = prtInf->txCallback(prtInf->txCallbackParams, datum);
+		uartStatsCallback(prtInf, start);
+		if(next) {
+			prtInf->stats.txBytes++;
 		}
+		return next;
 	}
 	// default
 	else if(prtInf->txBuf != NULL) {
 		// Send data if the buffer has bytes to send
-		if(!ring_buff_read(prtInf->txBuf, prtInf->usciRegs->TX_BUF)) {
-			ring_buff_read_finish_packet(prtInf->txBuf);
-			// Disable TX IE
-			*prtInf->usciRegs->IE_REG &= ~UCTXIE;
-			// Clear TX IFG
+		if(ring_buff_read(prtInf->txBuf, datum)) {
+			prtInf->stats.txBytes++;
+			return true;
+		}
+		ring_buff_read_finish_packet(prtInf->txBuf);
+	}
+	return false;
+}
+
+static uint16_t uartBaudError(UARTConfig * prtInf, const UARTBaudRegs * regs, uint8_t pattern) {
+	uint8_t frameBits = 1 + prtInf->databits + prtInf->stopbits + ((prtInf->parity != UART_PARITY_NONE) ? 1 : 0);
+	unsigned long cycles = 0;
+	uint16_t worst = 0;
+	long long error;
+	uint8_t m;
+	uint8_t i;
+
+	// compare the end of every bit of the frame with its ideal time
+	for(i = 0; i < frameBits; i++) {
+		m = (pattern >> (i & 7)) & 1;
+		cycles += regs->oversampling ? (16 + m) * (unsigned long)regs->brx + regs->brf : regs->brx + m;
+		error = ((long long)cycles * (long long)prtInf->baudRate - (long long)(i + 1) * (long long)prtInf->clkRate) * 1000 / (long long)prtInf->clkRate;
+		if(error < 0) {
+			error = -error;
+		}
+		if(error > worst) {
+			worst = (uint16_t)error;
+		}
+	}
+	return worst;
+}
+
+static inline bool uartRxStatus(UARTConfig * prtInf, uint8_t stat) {
+	if((stat & (UCOE | UCFE | UCPE)) == 0) {
+		return true;
+	}
+
+	// an overrun loses the previous byte, the one in RXBUF is still good
+	if(stat & UCOE) {
+		prtInf->stats.overrunErrors++;
+	}
+	if(stat & UCFE) {
+		prtInf->stats.framingErrors++;
+		return false;
+	}
+	if(stat & UCPE) {
+		prtInf->stats.parityErrors++;
+		return false;
+	}
+	return true;
+}
+
+static inline void uartStatsCallback(UARTConfig * prtInf, uint16_t start) {
+	uint16_t cycles = UART_STATS_TIMER() - start;
+
+	if(cycles > prtInf->stats.callbackMax) {
+		prtInf->stats.callbackMax = cycles;
+	}
+	prtInf->stats.callbackTotal += cycles;
+	prtInf->stats.callbackCount++;
+}
+
+static void uartTxIntKick(UARTConfig * prtInf) {
+#if (defined(__MSP430_HAS_USCI_A0__) || defined(__MSP430_HAS_USCI_A1__) || defined(__MSP430_HAS_USCI_A2__)) && (!defined(__MSP430_HAS_USCI__))
+
+	if(prtInf->moduleName == USCI_A0 || prtInf->moduleName == USCI_A1 || prtInf->moduleName == USCI_A2 || prtInf->moduleName == USCI_A3)
+	{
+		unsigned short state = __get_interrupt_state();
+
+		// If TX IE is still enabled a transmission is running and its ISR picks up the new data.
+		// Triggering the TX IFG now would overwrite the byte waiting in TXBUF.
+		__disable_interrupt();
+		if(!(*prtInf->usciRegs->IE_REG & UCTXIE))
+		{
+			// Enable TX IE
 			*prtInf->usciRegs->IFG_REG &= ~UCTXIFG;
+			*prtInf->usciRegs->IE_REG |= UCTXIE;
+
+			// Trigger the TX IFG. This will cause the Interrupt Vector to be called
+			// which will send the data one byte at a time at each interrupt trigger.
+			*prtInf->usciRegs->IFG_REG |= UCTXIFG;
 		}
+		__set_interrupt_state(state);
+	}
+#else
+	if(prtInf->moduleName == UCA0)
+	{
+		// Enable TX IE
+		*prtInf->usciRegs->IFG_REG &= ~UCA0TXIFG;
+		*prtInf->usciRegs->IE_REG |= UCA0TXIE;
+
+		// Trigger the TX IFG. This will cause the Interrupt Vector to be called
+		// which will send the data one byte at a time at each interrupt trigger.
+		*prtInf->usciRegs->IFG_REG |= UCA0TXIFG;
+	}
+#endif
+
+#if defined(__MSP430_HAS_UART0__) || defined(__MSP430_HAS_UART1__)
+	if(prtInf->moduleName == USART_0|| prtInf->moduleName == USART_1)
+	{
+		// Clear TX IFG and Enable TX IE
+		*prtInf->usartRegs->IFG_REG &= ~ prtInf->usartRegs->TXIFGFlag;
+		*prtInf->usartRegs->IE_REG |= prtInf->usartRegs->TXIE;
+
+		// Trigger the TX IFG. This will cause the Interrupt Vector to be called
+		// which will send the data one byte at a time at each interrupt trigger.
+		*prtInf->usartRegs->IFG_REG |= prtInf->usartRegs->TXIFGFlag;
+
 	}
+#endif
+}
+
+static bool uartTxDmaClaim(UARTConfig * prtInf) {
+	unsigned short state = __get_interrupt_state();
+	bool claimed = false;
+
+	// the DMA ISR releases the channel, so test and set it with interrupts disabled
+	__disable_interrupt();
+	if(!prtInf->txDmaBusy) {
+		prtInf->txDmaBusy = true;
+		claimed = true;
+	}
+	__set_interrupt_state(state);
+	return claimed;
+}
+
+static void uartTxDmaStart(UARTConfig * prtInf, const uint8_t * src, uint16_t len) {
+	uint8_t channel = prtInf->txDmaChannel;
+
+	DMA_setSrcAddress(channel, (uint32_t)(uintptr_t)src, DMA_DIRECTION_INCREMENT);
+	DMA_setTransferSize(channel, len);
+	prtInf->txDmaLen = len;
+	DMA_enableTransfers(channel);
+
+	// The trigger is edge sensitive. If the TX buffer is still full, the next TXIFG starts the
+	// transfer. If it is already empty, toggle TXIFG to start it.
+	if(*prtInf->usciRegs->IFG_REG & UCTXIFG) {
+		*prtInf->usciRegs->IFG_REG &= ~UCTXIFG;
+		*prtInf->usciRegs->IFG_REG |= UCTXIFG;
+	}
+}
+
+static void uartTxDmaKick(UARTConfig * prtInf) {
+	uint8_t * span;
+	uint16_t len;
+
+	if(!uartTxDmaClaim(prtInf)) {
+		return;
+	}
+
+	len = ring_buff_read_span(prtInf->txBuf, &span);
+	if(len == 0) {
+		ring_buff_read_clear_packet(prtInf->txBuf);
+		prtInf->txDmaBusy = false;
+		return;
+	}
+	prtInf->txDmaUserBuf = false;
+	uartTxDmaStart(prtInf, span, len);
+}
+
+static void uartTxDmaIsr(UARTConfig * prtInf) {
+	uint8_t * span;
+	uint16_t len;
+
+	prtInf->stats.txBytes += prtInf->txDmaLen;
+
+	if(prtInf->txDmaUserBuf) {
+		prtInf->txDmaUserBuf = false;
+		if(prtInf->txDoneCallback != NULL) {
+			prtInf->txDoneCallback(prtInf->txDoneCallbackParams);
+		}
+	}
+	else if(prtInf->txBuf != NULL) {
+		// release the bytes that were just sent
+		ring_buff_read_commit(prtInf->txBuf, prtInf->txDmaLen);
+		ring_buff_read_finish_packet(prtInf->txBuf);
+	}
+
+	// continue with anything queued in the ring buffer (the rest of a wrapped packet or a new one)
+	if(prtInf->txBuf != NULL) {
+		len = ring_buff_read_span(prtInf->txBuf, &span);
+		if(len > 0) {
+			uartTxDmaStart(prtInf, span, len);
+			return;
+		}
+		ring_buff_read_clear_packet(prtInf->txBuf);
+	}
+
+	prtInf->txDmaLen = 0;
+	prtInf->txDmaBusy = false;
 }
 
 #if defined(__MSP430_HAS_UART0__)
@@ -791,7 +1576,7 @@ __interrupt void usart0_tx (void)
 __interrupt void usart0_rx (void)
 {
 	UARTConfig * prtInf = prtInfList[USART_1];
-	uartRxIsr(prtInf);
+	uartRxDispatch(prtInf, *prtInf->usciRegs->RX_BUF);
 }
 
 #endif
@@ -821,28 +1606,13 @@ __interrupt void usart1_tx (void)
 __interrupt void usart1_rx (void)
 {
 	UARTConfig * prtInf = prtInfList[USART_1];
-	uartRxIsr(prtInf);
+	uartRxDispatch(prtInf, *prtInf->usciRegs->RX_BUF);
 }
 
 #endif
 
 #if defined(__MSP430_HAS_USCI_A0__)
-#pragma vector=USCI_A0_VECTOR
-__interrupt void USCI_A0_ISR(void)
-{
-	UARTConfig * prtInf = prtInfList[USCI_A0];
-	switch(__even_in_range(UCA0IV,4))
-	{
-	  case 0:break;                             // Vector 0 - no interrupt
-	  case 2:                                   // Vector 2 - RXIFG
-		uartRxIsr(prtInf);
-		break;
-	  case 4:                                   // Vector 4 - TXIFG
-		uartTxIsr(prtInf);
-		break;
-	  default: break;
-	}
-}
+UART_USCI_ISR(0)
 #endif
 
 #if defined(__MSP430_HAS_USCI__) && (!defined(__MSP430_HAS_USCI_A0__)) && (!defined(__MSP430_HAS_USCI_A1__)) && (!defined(__MSP430_HAS_USCI_A2__))
@@ -890,63 +1660,40 @@ __interrupt void USCI0RX_ISR(void)
 
 
 #if defined(__MSP430_HAS_USCI_A1__)
-#pragma vector=USCI_A1_VECTOR
-__interrupt void USCI_A1_ISR(void)
-{
-	UARTConfig * prtInf = prtInfList[USCI_A1];
-	uint8_t datum;
-	switch(__even_in_range(UCA1IV,4))
-	{
-	  case 0:break;                             // Vector 0 - no interrupt
-	  case 2:                                   // Vector 2 - RXIFG
-
-//	    if(UCA1RXBUF == '\r')
-//	        datum = 200;
-		uartRxIsr(prtInf);
-		break;
-	  case 4:                                   // Vector 4 - TXIFG
-		uartTxIsr(prtInf);
-		break;
-	  default: break;
-	}
-}
+UART_USCI_ISR(1)
 #endif
 
 #if defined(__MSP430_HAS_USCI_A2__)
-#pragma vector=USCI_A2_VECTOR
-__interrupt void USCI_A2_ISR(void)
-{
-	UARTConfig * prtInf = prtInfList[USCI_A2];
-	switch(__even_in_range(UCA2IV,4))
-	{
-	  case 0:break;                             // Vector 0 - no interrupt
-	  case 2:                                   // Vector 2 - RXIFG
-		uartRxIsr(prtInf);
-		break;
-	  case 4:                                   // Vector 4 - TXIFG
-		uartTxIsr(prtInf);
-		break;
-	  default: break;
-	}
-}
+UART_USCI_ISR(2)
 #endif
 
 #if defined(__MSP430_HAS_USCI_A3__)
-#pragma vector=USCI_A3_VECTOR
-__interrupt void USCI_A3_ISR(void)
+UART_USCI_ISR(3)
+#endif
+
+#if defined(__MSP430_HAS_DMAX_3__)
+#pragma vector=DMA_VECTOR
+__interrupt void DMA_ISR(void)
 {
-	UARTConfig * prtInf = prtInfList[USCI_A3];
-	switch(__even_in_range(UCA3IV,4))
+	UARTConfig * prtInf = NULL;
+	switch(__even_in_range(DMAIV,16))
 	{
 	  case 0:break;                             // Vector 0 - no interrupt
-	  case 2:                                   // Vector 2 - RXIFG
-		uartRxIsr(prtInf);
+	  case 2:                                   // Vector 2 - DMA0IFG
+		prtInf = dmaPortList[0];
 		break;
-	  case 4:                                   // Vector 4 - TXIFG
-		uartTxIsr(prtInf);
+	  case 4:                                   // Vector 4 - DMA1IFG
+		prtInf = dmaPortList[1];
+		break;
+	  case 6:                                   // Vector 6 - DMA2IFG
+		prtInf = dmaPortList[2];
 		break;
 	  default: break;
 	}
+	if(prtInf != NULL)
+	{
+		uartTxDmaIsr(prtInf);
+	}
 }
 #endif
 
@@ -50,6 +50,8 @@ extern "C" {
 #define PIN6 6
 #define PIN7 7
 
+#define UART_RX_STAGE_SIZE 32
+
 enum UART_ERR_CODES
 {
 	UART_SUCCESS = 0,
@@ -60,6 +62,9 @@ enum UART_ERR_CODES
 	UART_NO_TX_BUFF,
 	UART_BAD_PORT_SELECTED,
 	UART_INVALID_MODULE,
+	UART_DMA_UNSUPPORTED,
+	UART_TX_BUSY,
+	UART_BAD_BAUD_RATE,
 	UART_UNKNOWN
 };
 
@@ -130,6 +135,39 @@ typedef struct
 	unsigned char RXIE;
 } USARTUARTRegs;
 
+/** @struct UARTBaudRegs
+ *  @brief This struct contains the baud rate generator settings computed by uartCalcBaudRate().
+ *
+ */
+typedef struct
+{
+	uint16_t brx;													/**< Clock prescaler (UCBRx or UBRx) */
+	uint8_t brs;													/**< Second modulation stage (UCBRSx) */
+	uint8_t brf;													/**< First modulation stage (UCBRFx), only used with oversampling */
+	bool oversampling;												/**< Oversampling mode (UCOS16) */
+	uint8_t umctl;													/**< Modulation pattern of USART modules (UMCTL) */
+	uint16_t errorPermille;											/**< Worst-case transmit bit timing error over a frame, in 0.1% of a bit */
+} UARTBaudRegs;
+
+/** @struct UARTStats
+ *  @brief This struct contains the traffic and error counters of a UART port.
+ *  	   Callback times are in SMCLK cycles, measured with Timer_B0.
+ *
+ */
+typedef struct
+{
+	uint32_t rxBytes;												/**< Number of bytes received, not counting bytes with errors */
+	uint32_t txBytes;												/**< Number of bytes transmitted */
+	uint16_t overrunErrors;											/**< Number of times a byte was lost because RXBUF wasn't read in time (UCOE) */
+	uint16_t framingErrors;											/**< Number of bytes discarded for a missing stop bit (UCFE) */
+	uint16_t parityErrors;											/**< Number of bytes discarded for a bad parity bit (UCPE) */
+	uint16_t callbackMax;											/**< Longest RX/TX callback */
+	uint32_t callbackTotal;											/**< Total time spent in RX/TX callbacks */
+	uint32_t callbackCount;											/**< Number of RX/TX callback calls */
+	uint16_t callbackAvg;											/**< Average RX/TX callback time. Only filled in by uartGetStats() */
+	uint16_t txQueued;												/**< Bytes waiting in the TX ring buffer. Only filled in by uartGetStats() */
+} UARTStats;
+
 /** @struct UARTConfig
  *  @brief This struct contains all the configuration needed for
  *  	   UART operation.
@@ -153,8 +191,30 @@ typedef struct
 	ring_buff_t *rxBuf;												/**< Pointer to RX ring buffer */
 	void (*rxCallback) (void *params, uint8_t datum);				/**< Function pointer to RX callback function */
 	void * rxCallbackParams;										/**< Pointer to application parameters for RX callback function */
+	void (*rxSpanCallback) (void *params, const uint8_t *data, uint16_t len);	/**< Function pointer to RX span callback function */
+	void * rxSpanCallbackParams;									/**< Pointer to application parameters for RX span callback function */
+	const char * rxTerminators;										/**< Bytes that end a span (NULL terminated) */
+	uint8_t rxStageMax;												/**< Number of bytes that end a span if no terminator is received */
+	uint8_t rxStageLen;												/**< Number of bytes in the RX staging buffer */
+	uint8_t rxStage[UART_RX_STAGE_SIZE];							/**< RX staging buffer for the span callback */
 	bool (*txCallback) (void *params, uint8_t *txAddress);			/**< Function pointer to TX callback function */
 	void * txCallbackParams;										/**< Pointer to application parameters for TX callback function */
+	bool txDmaEnabled;												/**< TX is done by DMA instead of the TX interrupt */
+	uint8_t txDmaChannel;											/**< DMA channel used for TX (DMA_CHANNEL_x) */
+	volatile bool txDmaBusy;										/**< A DMA transfer is in progress */
+	volatile bool txDmaUserBuf;										/**< The DMA transfer in progress is from a caller buffer */
+	volatile uint16_t txDmaLen;										/**< Number of bytes in the DMA transfer in progress */
+	void (*txDoneCallback) (void *params);							/**< Function pointer to DMA TX complete callback function */
+	void * txDoneCallbackParams;									/**< Pointer to application parameters for DMA TX complete callback function */
+	bool rxDmaEnabled;												/**< RX is done by DMA into a circular buffer instead of the RX interrupt */
+	uint8_t rxDmaChannel;											/**< DMA channel used for RX (DMA_CHANNEL_x) */
+	uint8_t * rxDmaMem;												/**< Circular buffer written by the RX DMA */
+	uint16_t rxDmaSize;												/**< Length of the RX DMA circular buffer */
+	uint16_t rxDmaReadIdx;											/**< Index of the next byte in the RX DMA circular buffer to hand out */
+	const uint8_t * volatile txIntBuf;								/**< Caller buffer being sent by the TX interrupt, NULL if none */
+	volatile uint16_t txIntLen;										/**< Number of bytes of the caller buffer left to send */
+	uint16_t baudError;												/**< Worst-case bit timing error of the configured baud rate, in 0.1% of a bit */
+	volatile UARTStats stats;										/**< Traffic and error counters, read with uartGetStats() */
 } UARTConfig;
 
 /* Global Structs */
@@ -165,14 +225,25 @@ USCIUARTRegs USCI_A0_regs, USCI_A1_regs, USCI_A2_regs, USCI_A3_regs;
 int initUSCIUart(UARTConfig * prtInf, ring_buff_t *txbuf, ring_buff_t *rxbuf);
 void disableUSCIUartInterrupts(UARTConfig* prtInf);
 void initUartRxCallback(UARTConfig * prtInf, void (*callback) (void *params, uint8_t datum), void *params);
+void initUartRxSpanCallback(UARTConfig * prtInf, void (*callback) (void *params, const uint8_t *data, uint16_t len), void *params, const char *terminators, uint8_t maxLen);
 void initUartTxCallback(UARTConfig * prtInf, bool (*callback) (void *params, uint8_t *txAddress), void *params);
 int configUSCIUart(UARTConfig * prtInf,USCIUARTRegs * confRegs);
+int uartCalcBaudRate(UARTConfig * prtInf, UARTBaudRegs * regs);
 int configUSARTUart(UARTConfig * prtInf, USARTUARTRegs * confRegs);
 int uartSendDataBlocking(UARTConfig * prtInf,unsigned char * buf, int len);
 int uartSendStringBlocking(UARTConfig * prtInf,char * string);
 int initUartPort(UARTConfig * prtInf);
 void initUartDriver();
 int uartSendDataInt(UARTConfig * prtInf,unsigned char * buf, int len);
+int initUartTxDma(UARTConfig * prtInf, uint8_t channel);
+int uartSendDataAsync(UARTConfig * prtInf, const unsigned char * buf, int len, void (*callback) (void *params), void *params);
+void uartSendDataAbort(UARTConfig * prtInf);
+int uartSendDataDma(UARTConfig * prtInf, const unsigned char * buf, int len, void (*callback) (void *params), void *params);
+int initUartDmaRx(UARTConfig * prtInf, uint8_t channel, uint8_t * mem, uint16_t size);
+int uartDmaRxPoll(UARTConfig * prtInf);
+int uartReplayRx(UARTConfig * prtInf, const unsigned char * buf, int len);
+void uartGetStats(UARTConfig * prtInf, UARTStats * stats);
+void uartResetStats(UARTConfig * prtInf);
 void enableUartRx(UARTConfig * prtInf);
 ring_buff_t * getUartRxBuffer(UARTConfig * prtInf);
 int readRxBytes(UARTConfig * prtInf, unsigned char * data, int numBytesToRead, int offset);
@@ -0,0 +1,235 @@
+/*
+ * uart_stream.c
+ *
+ * Blocking stream interface on top of the UART driver.
+ * Gives tasks one wake-up per trigger level instead of one per byte, and the same
+ * timeout based backpressure for RX and TX.
+ */
+
+#include "uart_stream.h"
+
+/* ----- Private Function Prototypes ----- */
+static void uartStreamRxCallback(void *params, uint8_t datum);
+static void uartStreamTxDone(void *params);
+
+/*!
+ * \brief Attaches a stream to a UART port
+ *
+ * Registers an RX callback that stores received bytes in the stream's ring buffer,
+ * replacing any RX callback registered before. TX uses the port's TX ring buffer,
+ * so one must have been passed to initUSCIUart().
+ *
+ * @param stream is the UARTStream instance to initialize
+ * @param prtInf is the UART configuration registered with initUSCIUart() (e.g. &USCI_A2_cnf)
+ * @param rxMem is the memory array for received bytes. This should be global scope
+ * @param rxSize is the length of rxMem in bytes. Must be a power of two
+ * @param rxTrigger is the number of bytes that wakes a task waiting in uartStreamReceive()
+ * \return Success or errors as defined by UART_ERR_CODES
+ *
+ */
+int uartStreamInit(UARTStream * stream, UARTConfig * prtInf, uint8_t * rxMem, uint16_t rxSize, uint16_t rxTrigger)
+{
+	if(!ring_buff_init(&stream->rxBuf, rxMem, rxSize))
+	{
+		return UART_INSUFFICIENT_RX_BUF;
+	}
+
+	stream->prtInf = prtInf;
+	stream->rxTask = NULL;
+	uartStreamSetTrigger(stream, rxTrigger);
+	stream->rxWanted = stream->rxTrigger;
+	initUartRxCallback(prtInf, &uartStreamRxCallback, stream);
+	return UART_SUCCESS;
+}
+
+/*!
+ * \brief Changes the RX trigger level of a stream
+ *
+ * @param stream is the UARTStream instance
+ * @param rxTrigger is the number of bytes that wakes a waiting task. Limited to 1 to the capacity of the RX buffer
+ * \return None
+ *
+ */
+void uartStreamSetTrigger(UARTStream * stream, uint16_t rxTrigger)
+{
+	if(rxTrigger == 0)
+	{
+		rxTrigger = 1;
+	}
+	else if(rxTrigger > stream->rxBuf.mask)
+	{
+		rxTrigger = stream->rxBuf.mask;
+	}
+	stream->rxTrigger = rxTrigger;
+}
+
+/*!
+ * \brief Reads received bytes, blocking until enough are available
+ *
+ * Blocks until the trigger level (or len, if smaller) is reached or the timeout expires,
+ * then reads as many bytes as are available, up to len.
+ * Only one task may receive from a stream.
+ *
+ * @param stream is the UARTStream instance
+ * @param buf is the array to copy the bytes into
+ * @param len is the maximum number of bytes to read
+ * @param timeout is the maximum number of ticks to wait
+ * \return number of bytes read. 0 on timeout
+ *
+ */
+uint16_t uartStreamReceive(UARTStream * stream, uint8_t * buf, uint16_t len, TickType_t timeout)
+{
+	uint16_t wanted = (len < stream->rxTrigger) ? len : stream->rxTrigger;
+	uint16_t count;
+	TimeOut_t timeOut;
+
+	if(ring_buff_available(&stream->rxBuf) < wanted)
+	{
+		// drop a count left over from an earlier wake-up, a notification sent after this point can't be lost
+		ulTaskNotifyTake(pdTRUE, 0);
+		// a read shorter than the trigger level is woken as soon as its own bytes are there
+		stream->rxWanted = wanted;
+		stream->rxTask = xTaskGetCurrentTaskHandle();
+
+		vTaskSetTimeOutState(&timeOut);
+		while(ring_buff_available(&stream->rxBuf) < wanted)
+		{
+			if(xTaskCheckForTimeOut(&timeOut, &timeout) == pdTRUE)
+			{
+				break;
+			}
+			ulTaskNotifyTake(pdTRUE, timeout);
+		}
+		stream->rxTask = NULL;
+	}
+
+	count = ring_buff_read_block(&stream->rxBuf, buf, len);
+	ring_buff_read_finish_packet(&stream->rxBuf);
+	return count;
+}
+
+/*!
+ * \brief Queues bytes for transmission, blocking while the TX buffer is full
+ *
+ * Bytes are sent in chunks that fit the TX ring buffer. If the buffer is full, the task
+ * waits a tick at a time until there is room or the timeout expires.
+ *
+ * @param stream is the UARTStream instance
+ * @param buf is the array of bytes to send
+ * @param len is the number of bytes to send
+ * @param timeout is the maximum number of ticks to wait for room in the TX buffer
+ * \return number of bytes queued. Less than len on timeout
+ *
+ */
+uint16_t uartStreamSend(UARTStream * stream, const uint8_t * buf, uint16_t len, TickType_t timeout)
+{
+	ring_buff_t * txBuf = stream->prtInf->txBuf;
+	uint16_t sent = 0;
+	uint16_t chunk;
+	TimeOut_t timeOut;
+
+	if(txBuf == NULL)
+	{
+		return 0;
+	}
+
+	vTaskSetTimeOutState(&timeOut);
+	while(sent < len)
+	{
+		chunk = len - sent;
+		if(chunk > txBuf->mask)
+		{
+			chunk = txBuf->mask;
+		}
+
+		if(uartSendDataInt(stream->prtInf, (unsigned char *)&buf[sent], chunk) == UART_SUCCESS)
+		{
+			sent += chunk;
+		}
+		else if(xTaskCheckForTimeOut(&timeOut, &timeout) == pdTRUE)
+		{
+			break;
+		}
+		else
+		{
+			vTaskDelay(1);
+		}
+	}
+	return sent;
+}
+
+/*!
+ * \brief Sends a buffer, sleeping until the transmission is done
+ *
+ * Starts an interrupt or DMA driven transmission with uartSendDataAsync() and blocks on a task
+ * notification instead of polling the TX flag, so other tasks keep running while it is sent.
+ * Waits a tick at a time while another caller buffer is being sent on the port.
+ * Uses the notification value of the calling task.
+ *
+ * @param prtInf is a pointer to the UART configuration
+ * @param buf is a pointer to the buffer containing the bytes to be sent
+ * @param len is the number of bytes to send
+ * @param timeout is the maximum number of ticks to wait for the port and the transmission
+ * \return Success or errors as defined by UART_ERR_CODES. UART_TX_BUSY on timeout, in which case the transmission is stopped
+ *
+ */
+int uartSendDataTask(UARTConfig * prtInf, const unsigned char * buf, int len, TickType_t timeout)
+{
+	TimeOut_t timeOut;
+	int res;
+
+	if(len <= 0)
+	{
+		return UART_SUCCESS;
+	}
+
+	// a notification left over from a transmission that timed out must not end this one.
+	// xTaskNotifyStateClear() only clears the pending state, the count has to be taken
+	ulTaskNotifyTake(pdTRUE, 0);
+
+	vTaskSetTimeOutState(&timeOut);
+	while((res = uartSendDataAsync(prtInf, buf, len, &uartStreamTxDone, xTaskGetCurrentTaskHandle())) == UART_TX_BUSY)
+	{
+		if(xTaskCheckForTimeOut(&timeOut, &timeout) == pdTRUE)
+		{
+			return UART_TX_BUSY;
+		}
+		vTaskDelay(1);
+	}
+	if(res != UART_SUCCESS)
+	{
+		return res;
+	}
+
+	if(ulTaskNotifyTake(pdTRUE, timeout) == 0)
+	{
+		// the buffer may go out of scope once we return
+		uartSendDataAbort(prtInf);
+		return UART_TX_BUSY;
+	}
+	return UART_SUCCESS;
+}
+
+static void uartStreamTxDone(void *params)
+{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	vTaskNotifyGiveFromISR((TaskHandle_t) params, &xHigherPriorityTaskWoken);
+	portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+static void uartStreamRxCallback(void *params, uint8_t datum)
+{
+	UARTStream * stream = (UARTStream *) params;
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	ring_buff_write(&stream->rxBuf, datum);
+	ring_buff_write_finish_packet(&stream->rxBuf);
+
+	// only wake the reader once enough bytes have arrived
+	if( (stream->rxTask != NULL) && (ring_buff_available(&stream->rxBuf) >= stream->rxWanted) )
+	{
+		vTaskNotifyGiveFromISR(stream->rxTask, &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	}
+}
@@ -0,0 +1,49 @@
+/*
+ * uart_stream.h
+ *
+ * Blocking stream interface on top of the UART driver.
+ * RX bytes are collected in a ring buffer and a waiting task is only woken once a
+ * trigger level is reached, TX blocks while the TX ring buffer is full.
+ * uartSendDataTask() sends a buffer and sleeps until it is done.
+ */
+
+#ifndef UART_STREAM_H_
+#define UART_STREAM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "ring_buff.h"
+#include "uart.h"
+
+/** @struct UARTStream
+ *  @brief This struct contains the state of a stream on top of a UART port.
+ *
+ */
+typedef struct
+{
+	UARTConfig * prtInf;											/**< UART port the stream is attached to */
+	ring_buff_t rxBuf;												/**< Received bytes that haven't been read yet */
+	uint16_t rxTrigger;												/**< Number of bytes that wakes a waiting task */
+	volatile uint16_t rxWanted;										/**< Number of bytes the waiting task needs, rxTrigger or less */
+	volatile TaskHandle_t rxTask;									/**< Task waiting in uartStreamReceive(), NULL if none */
+} UARTStream;
+
+/* Function Declarations */
+int uartStreamInit(UARTStream * stream, UARTConfig * prtInf, uint8_t * rxMem, uint16_t rxSize, uint16_t rxTrigger);
+void uartStreamSetTrigger(UARTStream * stream, uint16_t rxTrigger);
+uint16_t uartStreamReceive(UARTStream * stream, uint8_t * buf, uint16_t len, TickType_t timeout);
+uint16_t uartStreamSend(UARTStream * stream, const uint8_t * buf, uint16_t len, TickType_t timeout);
+int uartSendDataTask(UARTConfig * prtInf, const unsigned char * buf, int len, TickType_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UART_STREAM_H_ */
@@ -0,0 +1,163 @@
+/*-------------------------------------------------------------------------------- /
+/ Baseline AX.25 frame builder
+/ -------------------------------------------------------------------------------- /
+/
+/ The frame building of the baseline firmware (ax25.c before the table driven
+/ CRC), kept only as the reference of the frame benchmark in test_ax25. It updates
+/ the CRC one bit at a time with a branch per bit, from inside the bit stuffing
+/ loop. Changes from the original: the entry points are renamed baseline_ax25_*,
+/ the frame is built in baseline_ax25_state instead of ax25_state, the private
+/ functions are static and ax25_send_byte() is dropped.
+/
+/ --------------------------------------------------------------------------------*/
+
+#include "ax25.h"
+
+ax25_state_t baseline_ax25_state;
+
+void baseline_ax25_send_header(const address_t* addresses, uint8_t num);
+void baseline_ax25_send_string(const char* buf);
+void baseline_ax25_send_footer(void);
+void baseline_ax25_flush_frame(void);
+
+static void update_crc(uint8_t bit);
+static void send_byte(uint8_t byte);
+static void send_flag(void);
+
+
+
+
+
+// ---------------------------------------------------- //
+// -------------------- public API -------------------- //
+// ---------------------------------------------------- //
+
+void baseline_ax25_send_header(const address_t* addresses, uint8_t num){
+    baseline_ax25_state.crc = AX25_CRC_INITIAL;
+    baseline_ax25_state.cont_ones = 0;
+    baseline_ax25_state.packet_len = 0;
+    baseline_ax25_state.raw_len = 0;
+
+    // Start flag(s)
+    uint8_t i;
+    for(i = 0 ; i < AX25_TX_DELAY_MS/10 * 12 / 8 ; i++){
+        // Enough flags to fill AX_TX_DELAY_MS
+        send_flag();
+    }
+
+    // Addresses (Destination, Source, Digipeaters)
+    for(i = 0 ; i < num ; i++){
+        // Callsign
+        uint8_t j;
+        for(j = 0 ; addresses[i].callsign[j] ; j++) {
+            send_byte(addresses[i].callsign[j] << 1);
+        }
+
+        // Padding
+        for( ; j < 6 ; j++) {
+            send_byte(' ' << 1);
+        }
+
+        // SSID
+        if (i == num - 1) {
+            // Trailing 1 terminator
+            send_byte(('0' + addresses[i].ssid) << 1 | 1);
+        } else {
+            send_byte(('0' + addresses[i].ssid) << 1);
+        }
+    }
+
+    // Control Field (UI)
+    send_byte(AX25_CONTROL);
+
+    // Protocol ID
+    send_byte(AX25_PROTOCOL);
+}
+
+void baseline_ax25_send_string(const char* buf){
+    uint8_t i;
+    for(i = 0 ; buf[i] ; i++){
+        send_byte(buf[i]);
+    }
+}
+
+void baseline_ax25_send_footer(void){
+    uint16_t final_crc = baseline_ax25_state.crc;
+    send_byte(~(final_crc & 0xFF));
+    final_crc >>= 8;
+    send_byte(~(final_crc & 0xFF));
+    send_flag();
+}
+
+void baseline_ax25_flush_frame(void){
+    afsk_send(baseline_ax25_state.packet, baseline_ax25_state.packet_len);
+    afsk_transmit();
+}
+
+
+
+
+
+// ----------------------------------------------------- //
+// -------------------- private API -------------------- //
+// ----------------------------------------------------- //
+
+static void update_crc(uint8_t bit){
+    baseline_ax25_state.crc ^= bit;
+    if (baseline_ax25_state.crc & 1){
+        baseline_ax25_state.crc = (baseline_ax25_state.crc >> 1) ^ AX25_CRC_POLY;
+    } else {
+        baseline_ax25_state.crc >>= 1;
+    }
+}
+
+static void send_byte(uint8_t byte) {
+    baseline_ax25_state.raw_packet[baseline_ax25_state.raw_len++] = byte; // For debugging
+
+    uint8_t i = 0;
+    for (i = 0 ; i < 8 ; i++) {
+        uint8_t bit = byte & 1;
+        update_crc(bit);
+        byte = byte >> 1;
+
+        if (bit) {
+            if (baseline_ax25_state.packet_len >= AX25_MAX_PACKET * 8) // Prevent buffer overrun
+                return;
+
+            // set (packet_size % 8)th bit of packet[packet_size/8]
+            baseline_ax25_state.packet[baseline_ax25_state.packet_len >> 3] |= (1 << (baseline_ax25_state.packet_len & 7));
+            baseline_ax25_state.packet_len++;
+
+            baseline_ax25_state.cont_ones++;
+            if (baseline_ax25_state.cont_ones < 5)
+                continue;
+        }
+
+        // Next bit is 0 or zero padding after 5 contiguous 1s
+        if (baseline_ax25_state.packet_len >= AX25_MAX_PACKET * 8)    // Prevent buffer overrun
+            return;
+
+        // reset (packet_size % 8)th bit of packet[packet_size/8]
+        baseline_ax25_state.packet[baseline_ax25_state.packet_len >> 3] &= ~(1 << (baseline_ax25_state.packet_len & 7));
+        baseline_ax25_state.packet_len++;
+        baseline_ax25_state.cont_ones = 0;
+    }
+}
+
+static void send_flag(void){
+    // Basically the same as send_byte(AX25_FLAG), but without CRC updates
+    uint8_t i;
+    for (i = 0 ; i < 8 ; i++) {
+        if (baseline_ax25_state.packet_len >= (AX25_MAX_PACKET * 8))
+            return;
+
+        if ((AX25_FLAG >> i) & 1) {
+            // set (packet_size % 8)th bit of packet[packet_size/8]
+            baseline_ax25_state.packet[baseline_ax25_state.packet_len >> 3] |= (1 << (baseline_ax25_state.packet_len & 7));
+        } else {
+            // reset (packet_size % 8)th bit of packet[packet_size/8]
+            baseline_ax25_state.packet[baseline_ax25_state.packet_len >> 3] &= ~(1 << (baseline_ax25_state.packet_len & 7));
+        }
+        baseline_ax25_state.packet_len++;
+    }
+}
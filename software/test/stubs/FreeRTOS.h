@@ -0,0 +1,40 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+/*
+ * Host stand-in for the FreeRTOS headers used by the firmware.
+ * Critical sections do nothing and the tick count is set by the tests (see host.h).
+ * Barriers are full fences and taskYIELD() yields the host thread, for the tests
+ * that read published data from other threads.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sched.h>
+
+typedef uint16_t TickType_t;
+typedef TickType_t portTickType;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef void * TaskHandle_t;
+typedef void * SemaphoreHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdFALSE                 0
+#define pdTRUE                  1
+#define pdPASS                  1
+#define portMAX_DELAY           ((TickType_t)0xFFFF)
+#define configTICK_RATE_HZ      ((TickType_t)1000)
+#define configCPU_CLOCK_HZ      16000000UL
+#define portTICK_RATE_MS        ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portTICK_PERIOD_MS      portTICK_RATE_MS
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+
+#define configASSERT(x)
+#define portYIELD_FROM_ISR(x)   (void)(x)
+#define portMEMORY_BARRIER()    __sync_synchronize()
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#define taskDISABLE_INTERRUPTS()
+#define taskYIELD()             sched_yield()
+
+#endif /* FREERTOS_H */
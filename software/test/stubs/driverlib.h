@@ -0,0 +1,63 @@
+#ifndef DRIVERLIB_H
+#define DRIVERLIB_H
+/*
+ * Host stand-in for the parts of MSP430 driverlib used by the firmware, implemented in target.c.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ----- GPIO ----- //
+#define GPIO_PORT_P1                1
+#define GPIO_PORT_P8                8
+#define GPIO_PIN0                   0x01
+#define GPIO_PIN1                   0x02
+#define GPIO_PIN2                   0x04
+#define GPIO_PIN3                   0x08
+#define GPIO_PIN4                   0x10
+#define GPIO_PIN5                   0x20
+#define GPIO_PIN6                   0x40
+#define GPIO_PIN7                   0x80
+
+void GPIO_setAsOutputPin(uint8_t port, uint16_t pins);
+void GPIO_setOutputHighOnPin(uint8_t port, uint16_t pins);
+void GPIO_setOutputLowOnPin(uint8_t port, uint16_t pins);
+void GPIO_setAsPeripheralModuleFunctionInputPin(uint8_t port, uint16_t pins);
+
+// ----- DMA ----- //
+#define DMA_CHANNEL_0               0x00
+#define DMA_CHANNEL_1               0x10
+#define DMA_CHANNEL_2               0x20
+#define DMA_TRIGGERSOURCE_16        0x10
+#define DMA_TRIGGERSOURCE_17        0x11
+#define DMA_TRIGGERSOURCE_20        0x14
+#define DMA_TRIGGERSOURCE_21        0x15
+#define DMA_TRANSFER_SINGLE         0x0000
+#define DMA_TRANSFER_REPEATED_SINGLE 0x4000
+#define DMA_TRIGGER_RISINGEDGE      0x00
+#define DMA_SIZE_SRCBYTE_DSTBYTE    0xC0
+#define DMA_DIRECTION_UNCHANGED     0x000
+#define DMA_DIRECTION_INCREMENT     0x300
+
+typedef struct DMA_initParam {
+    uint8_t channelSelect;
+    uint16_t transferModeSelect;
+    uint16_t transferSize;
+    uint8_t triggerSourceSelect;
+    uint8_t transferUnitSelect;
+    uint8_t triggerTypeSelect;
+} DMA_initParam;
+
+void DMA_init(DMA_initParam *param);
+void DMA_setTransferSize(uint8_t channel, uint16_t size);
+uint16_t DMA_getTransferSize(uint8_t channel);
+void DMA_setSrcAddress(uint8_t channel, uint32_t address, uint16_t direction);
+void DMA_setDstAddress(uint8_t channel, uint32_t address, uint16_t direction);
+void DMA_enableTransfers(uint8_t channel);
+void DMA_disableTransfers(uint8_t channel);
+void DMA_enableInterrupt(uint8_t channel);
+void DMA_disableInterrupt(uint8_t channel);
+void DMA_clearInterrupt(uint8_t channel);
+uint16_t DMA_getInterruptStatus(uint8_t channel);
+
+#endif /* DRIVERLIB_H */
@@ -0,0 +1,50 @@
+#ifndef HOST_H
+#define HOST_H
+/*
+ * Controls of the host stand-ins in target.c, used by the tests to drive the firmware.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "FreeRTOS.h"
+
+// tick count returned by xTaskGetTickCount(), vTaskDelay() advances it
+extern TickType_t host_tick;
+
+// pressure in mbar returned by sens_get_pres(), which fails while it is 0
+extern int32_t host_pressure;
+
+// remaining transfer size returned by DMA_getTransferSize() for each channel
+extern uint16_t host_dma_size[3];
+
+// setup of each DMA channel recorded by the driverlib stand-ins
+typedef struct {
+    uint8_t trigger;            // triggerSourceSelect of DMA_init()
+    uint16_t mode;              // transferModeSelect of DMA_init()
+    uint8_t unit;               // transferUnitSelect of DMA_init()
+    uint8_t trigger_type;       // triggerTypeSelect of DMA_init()
+    uint32_t src;               // DMA_setSrcAddress()
+    uint16_t src_dir;
+    uint32_t dst;               // DMA_setDstAddress()
+    uint16_t dst_dir;
+    bool enabled;               // DMA_enableTransfers() until DMA_disableTransfers()
+    bool interrupt;             // DMA_enableInterrupt() until DMA_disableInterrupt()
+} host_dma_channel_t;
+
+extern host_dma_channel_t host_dma[3];
+
+/* task notifications of the task under test (the only task):
+ *      - host_notify is its notification value, given by xTaskNotifyGive() and vTaskNotifyGiveFromISR()
+ *      - host_notify_gives counts the notifications given, host_wakeups the blocking ulTaskNotifyTake() calls
+ *        that returned with a notification
+ *      - host_blocked_hook runs whenever the task blocks (ulTaskNotifyTake() without a notification, vTaskDelay()),
+ *        standing in for the interrupts and tasks that run meanwhile. ticks is how long the task would block.
+ *        After it, a delay advances host_tick by ticks, and so does a notification wait that is still without a
+ *        notification (it timed out). A hook that gives a notification advances host_tick itself
+ */
+extern uint32_t host_notify;
+extern uint32_t host_notify_gives;
+extern uint32_t host_wakeups;
+extern void (*host_blocked_hook)(TickType_t ticks);
+
+#endif /* HOST_H */
@@ -0,0 +1,139 @@
+#ifndef MSP430_H
+#define MSP430_H
+/*
+ * Host stand-in for the MSP430F5438A device header.
+ * Peripheral registers are plain variables (defined in target.c) that the tests read and write,
+ * and the intrinsics do nothing or are implemented in target.c.
+ */
+
+#include <stdint.h>
+
+// ----- peripheral registers ----- //
+#define HOST_REGS_8(X) \
+    X(UCA0CTL0) X(UCA0CTL1) X(UCA0MCTL) X(UCA0BR0) X(UCA0BR1) X(UCA0IE) X(UCA0IFG) X(UCA0STAT) X(UCA0RXBUF) X(UCA0TXBUF) \
+    X(UCA1CTL0) X(UCA1CTL1) X(UCA1MCTL) X(UCA1BR0) X(UCA1BR1) X(UCA1IE) X(UCA1IFG) X(UCA1STAT) X(UCA1RXBUF) X(UCA1TXBUF) \
+    X(UCA2CTL0) X(UCA2CTL1) X(UCA2MCTL) X(UCA2BR0) X(UCA2BR1) X(UCA2IE) X(UCA2IFG) X(UCA2STAT) X(UCA2RXBUF) X(UCA2TXBUF) \
+    X(UCA3CTL0) X(UCA3CTL1) X(UCA3MCTL) X(UCA3BR0) X(UCA3BR1) X(UCA3IE) X(UCA3IFG) X(UCA3STAT) X(UCA3RXBUF) X(UCA3TXBUF) \
+    X(P1SEL) X(P2SEL) X(P3SEL) X(P4SEL) X(P5SEL) X(P6SEL) X(P7SEL) X(P8SEL) X(P9SEL) X(P10SEL) \
+    X(P1DIR) X(P1IN) X(P1OUT) X(P7DIR) X(P7OUT) X(P8DIR) X(P8IN) X(P8OUT)
+
+#define HOST_REGS_16(X) \
+    X(UCA0IV) X(UCA1IV) X(UCA2IV) X(UCA3IV) \
+    X(TA0CTL) X(TA0R) X(TA0CCR0) X(TA0CCTL0) X(TA0CCR1) X(TA0CCTL1) X(TA0CCR3) X(TA0CCTL3) X(TA0IV) \
+    X(TA1CTL) X(TA1CCR0) X(TA1CCR1) X(TA1CCTL1) X(TA1IV) \
+    X(TB0CTL) X(TB0R) X(TB0IV) \
+    X(DMACTL0) X(DMACTL1) X(DMACTL2) X(DMACTL3) X(DMACTL4) X(DMAIV) \
+    X(DMA0CTL) X(DMA0SZ) X(DMA1CTL) X(DMA1SZ) X(DMA2CTL) X(DMA2SZ) \
+    X(WDTCTL)
+
+#define HOST_REG_DECLARE_8(reg)     extern volatile unsigned char reg;
+#define HOST_REG_DECLARE_16(reg)    extern volatile unsigned int reg;
+HOST_REGS_8(HOST_REG_DECLARE_8)
+HOST_REGS_16(HOST_REG_DECLARE_16)
+
+// ----- device features ----- //
+#define __MSP430_HAS_USCI_A0__
+#define __MSP430_HAS_USCI_A1__
+#define __MSP430_HAS_USCI_A2__
+#define __MSP430_HAS_USCI_A3__
+#define __MSP430_HAS_PORT1_R__
+#define __MSP430_HAS_PORT3_R__
+#define __MSP430_HAS_PORT5_R__
+#define __MSP430_HAS_PORT9_R__
+#define __MSP430_HAS_PORT10_R__
+#define __MSP430_HAS_DMAX_3__
+
+// ----- register bits ----- //
+#define BIT0                0x01
+#define BIT1                0x02
+#define BIT2                0x04
+#define BIT3                0x08
+#define BIT4                0x10
+#define BIT5                0x20
+#define BIT6                0x40
+#define BIT7                0x80
+
+#define UCSWRST             0x01
+#define UCRXEIE             0x20
+#define UCBRK               0x08
+#define UCRXERR             0x04
+#define UCPEN               0x80
+#define UCPAR               0x40
+#define UC7BIT              0x10
+#define UCSPB               0x08
+#define UCSSEL1             0x80
+#define UCSSEL0             0x40
+#define UCOS16              0x01
+#define UCRXIFG             0x01
+#define UCTXIFG             0x02
+#define UCRXIE              0x01
+#define UCTXIE              0x02
+#define UCPE                0x10
+#define UCOE                0x20
+#define UCFE                0x40
+
+#define TASSEL_1            0x0100
+#define TASSEL_2            0x0200
+#define TACLR               0x0004
+#define MC_1                0x0010
+#define MC_2                0x0020
+#define CCIE                0x0010
+#define CCIFG               0x0001
+#define COV                 0x0002
+#define CAP                 0x0100
+#define SCS                 0x0800
+#define CCIS_0              0x0000
+#define CM_1                0x4000
+#define TA0IV_TACCR1        0x0002
+#define TA0IV_TACCR3        0x0006
+#define TA0IV_TAIFG         0x000E
+
+#define TBSSEL_2            0x0200
+#define TBSSEL__SMCLK       0x0200
+#define TBCLR               0x0004
+#define TBIE                0x0002
+#define TBIFG               0x0001
+#define MC__CONTINOUS       0x0020
+#define MC__CONTINUOUS      0x0020
+
+#define DMAREQ              0x0001
+#define DMAIE               0x0004
+#define DMAIFG              0x0008
+#define DMAEN               0x0010
+#define DMASRCBYTE          0x0040
+#define DMADSTBYTE          0x0080
+#define DMASRCINCR_3        0x0300
+#define DMADSTINCR_3        0x0C00
+#define DMASBDB             0x0000
+#define DMADT_0             0x0000
+#define DMADT_4             0x4000
+
+#define GIE                 0x0008
+#define WDTPW               0x5A00
+#define WDTHOLD             0x0080
+
+// ----- interrupt vectors ----- //
+#define USCI_A3_VECTOR      44
+#define USCI_A2_VECTOR      45
+#define USCI_A1_VECTOR      46
+#define DMA_VECTOR          50
+#define TIMER0_A1_VECTOR    53
+#define USCI_A0_VECTOR      57
+#define TIMER0_B1_VECTOR    59
+
+// ----- intrinsics ----- //
+#define __interrupt
+#define __even_in_range(x, y)       (x)
+#define __no_operation()
+#define __delay_cycles(x)
+#define __bic_SR_register(x)
+#define __bis_SR_register(x)
+#define __get_SR_register()         0
+#define __data20_write_long(addr, value)  (*(volatile unsigned long *)(uintptr_t)(addr) = (value))
+
+unsigned short __get_interrupt_state(void);
+void __set_interrupt_state(unsigned short state);
+void __disable_interrupt(void);
+void __enable_interrupt(void);
+
+#endif /* MSP430_H */
@@ -0,0 +1,15 @@
+#ifndef SEMPHR_H
+#define SEMPHR_H
+/*
+ * Host stand-in for the FreeRTOS semaphore API. Only the declarations are needed.
+ */
+
+#include "FreeRTOS.h"
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t *woken);
+
+#endif /* SEMPHR_H */
@@ -0,0 +1,129 @@
+/*
+ * Host implementations of the MSP430 registers, driverlib, FreeRTOS and AFSK functions
+ * used by the firmware under test.
+ */
+
+#include <msp430.h>
+#include <driverlib.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "host.h"
+
+#define HOST_REG_DEFINE_8(reg)      volatile unsigned char reg;
+#define HOST_REG_DEFINE_16(reg)     volatile unsigned int reg;
+HOST_REGS_8(HOST_REG_DEFINE_8)
+HOST_REGS_16(HOST_REG_DEFINE_16)
+
+TickType_t host_tick;
+int32_t host_pressure;
+uint16_t host_dma_size[3];
+host_dma_channel_t host_dma[3];
+uint32_t host_notify;
+uint32_t host_notify_gives;
+uint32_t host_wakeups;
+void (*host_blocked_hook)(TickType_t ticks);
+
+static unsigned short interrupt_state = GIE;
+
+// ----- intrinsics ----- //
+unsigned short __get_interrupt_state(void) { return interrupt_state; }
+void __set_interrupt_state(unsigned short state) { interrupt_state = state; }
+void __disable_interrupt(void) { interrupt_state &= ~GIE; }
+void __enable_interrupt(void) { interrupt_state |= GIE; }
+
+// ----- GPIO ----- //
+void GPIO_setAsOutputPin(uint8_t port, uint16_t pins) { (void)port; (void)pins; }
+void GPIO_setOutputHighOnPin(uint8_t port, uint16_t pins) { (void)port; (void)pins; }
+void GPIO_setOutputLowOnPin(uint8_t port, uint16_t pins) { (void)port; (void)pins; }
+void GPIO_setAsPeripheralModuleFunctionInputPin(uint8_t port, uint16_t pins) { (void)port; (void)pins; }
+
+// ----- DMA ----- //
+void DMA_init(DMA_initParam *param) {
+    host_dma_channel_t *dma = &host_dma[param->channelSelect >> 4];
+
+    dma->trigger = param->triggerSourceSelect;
+    dma->mode = param->transferModeSelect;
+    dma->unit = param->transferUnitSelect;
+    dma->trigger_type = param->triggerTypeSelect;
+    dma->enabled = false;
+    host_dma_size[param->channelSelect >> 4] = param->transferSize;
+}
+
+void DMA_setTransferSize(uint8_t channel, uint16_t size) { host_dma_size[channel >> 4] = size; }
+uint16_t DMA_getTransferSize(uint8_t channel) { return host_dma_size[channel >> 4]; }
+void DMA_setSrcAddress(uint8_t channel, uint32_t address, uint16_t direction) { host_dma[channel >> 4].src = address; host_dma[channel >> 4].src_dir = direction; }
+void DMA_setDstAddress(uint8_t channel, uint32_t address, uint16_t direction) { host_dma[channel >> 4].dst = address; host_dma[channel >> 4].dst_dir = direction; }
+void DMA_enableTransfers(uint8_t channel) { host_dma[channel >> 4].enabled = true; }
+void DMA_disableTransfers(uint8_t channel) { host_dma[channel >> 4].enabled = false; }
+void DMA_enableInterrupt(uint8_t channel) { host_dma[channel >> 4].interrupt = true; }
+void DMA_disableInterrupt(uint8_t channel) { host_dma[channel >> 4].interrupt = false; }
+void DMA_clearInterrupt(uint8_t channel) { (void)channel; }
+uint16_t DMA_getInterruptStatus(uint8_t channel) { (void)channel; return 0; }
+
+// ----- FreeRTOS ----- //
+TickType_t xTaskGetTickCount(void) { return host_tick; }
+TickType_t xTaskGetTickCountFromISR(void) { return host_tick; }
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return (TaskHandle_t)1; }
+BaseType_t xTaskNotifyGive(TaskHandle_t task) { (void)task; host_notify++; host_notify_gives++; return pdPASS; }
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) { (void)task; host_notify++; host_notify_gives++; *woken = pdTRUE; }
+
+void vTaskDelay(TickType_t ticks) {
+    if(host_blocked_hook != NULL) {
+        host_blocked_hook(ticks);
+    }
+    host_tick += ticks;
+}
+
+void vTaskDelayUntil(TickType_t *previous, TickType_t increment) {
+    *previous += increment;
+    // no delay if the wake-up time has already passed
+    if((TickType_t)(*previous - host_tick) <= increment) {
+        vTaskDelay(*previous - host_tick);
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    uint32_t value;
+
+    if( (host_notify == 0) && (ticks > 0) ) {
+        if(host_blocked_hook != NULL) {
+            host_blocked_hook(ticks);
+        }
+        if(host_notify == 0) {
+            host_tick += ticks;
+            return 0;
+        }
+        host_wakeups++;
+    }
+    value = host_notify;
+    if(value > 0) {
+        host_notify = clear ? 0 : value - 1;
+    }
+    return value;
+}
+BaseType_t xTaskNotifyStateClear(TaskHandle_t task) { (void)task; return pdFALSE; }
+void vTaskSuspendAll(void) {}
+BaseType_t xTaskResumeAll(void) { return pdFALSE; }
+void vTaskSetTimeOutState(TimeOut_t *timeout) { timeout->start = host_tick; }
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *timeout, TickType_t *remaining) {
+    TickType_t elapsed = host_tick - timeout->start;
+
+    if(elapsed >= *remaining) {
+        *remaining = 0;
+        return pdTRUE;
+    }
+    *remaining -= elapsed;
+    timeout->start = host_tick;
+    return pdFALSE;
+}
+
+// ----- AFSK ----- //
+void afsk_send(uint8_t *buf, uint16_t len) { (void)buf; (void)len; }
+void afsk_transmit(void) {}
+
+// ----- sensors ----- //
+bool sens_get_pres(int32_t *pressure) {
+    *pressure = host_pressure;
+    return host_pressure != 0;
+}
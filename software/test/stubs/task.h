@@ -0,0 +1,28 @@
+#ifndef TASK_H
+#define TASK_H
+/*
+ * Host stand-in for the FreeRTOS task API, implemented in target.c.
+ */
+
+#include "FreeRTOS.h"
+
+typedef struct {
+    TickType_t start;
+} TimeOut_t;
+
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *previous, TickType_t increment);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint16_t stack, void *params, UBaseType_t priority, TaskHandle_t *handle);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+BaseType_t xTaskNotifyStateClear(TaskHandle_t task);
+void vTaskSuspendAll(void);
+BaseType_t xTaskResumeAll(void);
+void vTaskSetTimeOutState(TimeOut_t *timeout);
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *timeout, TickType_t *remaining);
+
+#endif /* TASK_H */
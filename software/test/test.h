@@ -0,0 +1,94 @@
+#ifndef TEST_H
+#define TEST_H
+/*-------------------------------------------------------------------------------- /
+/ Host test helpers
+/ -------------------------------------------------------------------------------- /
+/
+/ Minimal checks for the host tests. Each test file is its own executable: it runs
+/ its checks, prints the failures and returns non-zero from main() if any failed.
+/
+/ --------------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+
+
+
+// ------------------------------------------------------- //
+// -------------------- public macros -------------------- //
+// ------------------------------------------------------- //
+
+static int test_checks = 0;
+static int test_failures = 0;
+
+// check that a condition holds
+#define CHECK(cond) do { \
+        test_checks++; \
+        if(!(cond)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            test_failures++; \
+        } \
+    } while(0)
+
+// check that an integer expression has the expected value
+#define CHECK_EQ(actual, expected) do { \
+        long long actual_ = (long long)(actual); \
+        long long expected_ = (long long)(expected); \
+        test_checks++; \
+        if(actual_ != expected_) { \
+            printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, actual_, expected_); \
+            test_failures++; \
+        } \
+    } while(0)
+
+// check that len bytes match
+#define CHECK_MEM(actual, expected, len) do { \
+        test_checks++; \
+        if(memcmp((actual), (expected), (len)) != 0) { \
+            printf("%s:%d: %s doesn't match %s\n", __FILE__, __LINE__, #actual, #expected); \
+            test_failures++; \
+        } \
+    } while(0)
+
+// print the summary and return the exit code of the test
+#define TEST_RESULT() \
+    (printf("%s: %d checks, %d failed\n", __FILE__, test_checks, test_failures), (test_failures != 0))
+
+
+
+
+
+
+// ---------------------------------------------------------- //
+// -------------------- public functions -------------------- //
+// ---------------------------------------------------------- //
+
+// host cycle count for the benchmarks: the time stamp counter on x86, ns elsewhere
+static inline uint64_t test_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+// host time in s for the benchmarks
+static inline double test_seconds(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+#endif /* TEST_H */
@@ -0,0 +1,203 @@
+/*-------------------------------------------------------------------------------- /
+/ AX.25 CRC tests
+/ -------------------------------------------------------------------------------- /
+/
+/ The table driven frame check sequence against the CRC-16/X.25 check value, a
+/ bitwise reference on random data and the residue of a frame with its FCS, both
+/ for the CRC alone and for a frame built through the public API. Prints the host
+/ time to build a frame of a 100 byte payload against the baseline frame builder
+/ (./ax25_baseline.c), which updates the CRC a bit at a time.
+/
+/ --------------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include "test.h"
+#include "ax25.h"
+
+#define CRC_CHECK           0x906E      // CRC-16/X.25 of "123456789"
+#define CRC_RESIDUE         0xF0B8      // register after a frame and its FCS
+#define RANDOM_ITERATIONS   1000
+#define RANDOM_SEED         1
+#define BENCH_PAYLOAD       100
+#define BENCH_FRAMES        20000
+
+// the driver's state and its private CRC update
+extern ax25_state_t ax25_state;
+void update_crc(uint8_t byte);
+
+// the frame builder before the table driven CRC
+extern ax25_state_t baseline_ax25_state;
+void baseline_ax25_send_header(const address_t* addresses, uint8_t num);
+void baseline_ax25_send_string(const char* buf);
+void baseline_ax25_send_footer(void);
+void baseline_ax25_flush_frame(void);
+
+
+
+
+
+// ----------------------------------------------------------------- //
+// -------------------- private helper functions -------------------- //
+// ----------------------------------------------------------------- //
+
+// one bit at a time, lsb first with AX25_CRC_POLY
+static uint16_t crc_reference(const uint8_t *data, uint16_t len) {
+    uint16_t crc = AX25_CRC_INITIAL;
+    uint16_t i;
+    uint8_t bit;
+
+    for(i = 0; i < len; i++) {
+        crc ^= data[i];
+        for(bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? ((crc >> 1) ^ AX25_CRC_POLY) : (crc >> 1);
+        }
+    }
+    return crc;
+}
+
+static uint16_t crc_table(const uint8_t *data, uint16_t len) {
+    uint16_t i;
+
+    ax25_state.crc = AX25_CRC_INITIAL;
+    for(i = 0; i < len; i++) {
+        update_crc(data[i]);
+    }
+    return ax25_state.crc;
+}
+
+
+
+
+
+// ----------------------------------------------- //
+// -------------------- tests -------------------- //
+// ----------------------------------------------- //
+
+// the catalogued check value, the FCS is the complement of the register
+static void test_check_value(void) {
+    const uint8_t check[] = "123456789";
+
+    CHECK_EQ((uint16_t)~crc_table(check, 9), CRC_CHECK);
+    CHECK_EQ((uint16_t)~crc_reference(check, 9), CRC_CHECK);
+    CHECK_EQ(crc_table(check, 0), AX25_CRC_INITIAL);
+}
+
+// the table matches the bitwise reference for every length and content
+static void test_reference(void) {
+    uint8_t data[64];
+    uint16_t len;
+    uint16_t i;
+    uint16_t n;
+
+    srand(RANDOM_SEED);
+    for(n = 0; n < RANDOM_ITERATIONS; n++) {
+        len = rand() % sizeof(data);
+        for(i = 0; i < len; i++) {
+            data[i] = rand();
+        }
+        CHECK_EQ(crc_table(data, len), crc_reference(data, len));
+    }
+
+    // each single byte, so every table entry is covered
+    for(n = 0; n < 256; n++) {
+        data[0] = n;
+        CHECK_EQ(crc_table(data, 1), crc_reference(data, 1));
+    }
+}
+
+// a receiver running the CRC over the frame and its FCS ends at the residue
+static void test_residue(void) {
+    const address_t addresses[2] = {{"APRS", 0}, {"KD8ABC", 11}};
+    uint8_t data[] = "123456789";
+    uint16_t crc;
+    uint16_t i;
+
+    crc = ~crc_table(data, 9);
+    update_crc(crc & 0xFF);
+    update_crc(crc >> 8);
+    CHECK_EQ(ax25_state.crc, CRC_RESIDUE);
+
+    // a frame through the public API, the FCS is the last two raw bytes, low byte first
+    memset(&ax25_state, 0, sizeof(ax25_state));
+    ax25_send_header(addresses, 2);
+    ax25_send_string("!4217.00N/08343.20WO/A=100000");
+    ax25_send_footer();
+    CHECK(ax25_state.raw_len >= 2);
+    CHECK_EQ(ax25_state.crc, CRC_RESIDUE);
+    crc = ~crc_reference(ax25_state.raw_packet, ax25_state.raw_len - 2);
+    CHECK_EQ(ax25_state.raw_packet[ax25_state.raw_len - 2], crc & 0xFF);
+    CHECK_EQ(ax25_state.raw_packet[ax25_state.raw_len - 1], crc >> 8);
+
+    // a flipped bit anywhere in the frame leaves another residue
+    for(i = 0; i < ax25_state.raw_len * 8; i++) {
+        ax25_state.raw_packet[i / 8] ^= 1 << (i % 8);
+        CHECK(crc_table(ax25_state.raw_packet, ax25_state.raw_len) != CRC_RESIDUE);
+        ax25_state.raw_packet[i / 8] ^= 1 << (i % 8);
+    }
+    CHECK_EQ(crc_table(ax25_state.raw_packet, ax25_state.raw_len), CRC_RESIDUE);
+}
+
+
+// host time to build and flush a frame of a 100 byte payload, with the table and with the bitwise CRC
+static void test_benchmark(void) {
+    const address_t addresses[2] = {{"APRS", 0}, {"KD8ABC", 11}};
+    char payload[BENCH_PAYLOAD + 1];
+    uint64_t cycles[2];
+    double seconds[2];
+    uint32_t n;
+    uint16_t i;
+
+    for(i = 0; i < BENCH_PAYLOAD; i++) {
+        payload[i] = ' ' + i % 95;
+    }
+    payload[BENCH_PAYLOAD] = '\0';
+
+    seconds[0] = test_seconds();
+    cycles[0] = test_cycles();
+    for(n = 0; n < BENCH_FRAMES; n++) {
+        ax25_send_header(addresses, 2);
+        ax25_send_string(payload);
+        ax25_send_footer();
+        ax25_flush_frame();
+    }
+    cycles[0] = test_cycles() - cycles[0];
+    seconds[0] = test_seconds() - seconds[0];
+
+    seconds[1] = test_seconds();
+    cycles[1] = test_cycles();
+    for(n = 0; n < BENCH_FRAMES; n++) {
+        baseline_ax25_send_header(addresses, 2);
+        baseline_ax25_send_string(payload);
+        baseline_ax25_send_footer();
+        baseline_ax25_flush_frame();
+    }
+    cycles[1] = test_cycles() - cycles[1];
+    seconds[1] = test_seconds() - seconds[1];
+
+    // both build the same frame, bit for bit
+    CHECK_EQ(ax25_state.crc, CRC_RESIDUE);
+    CHECK_EQ(ax25_state.raw_len, baseline_ax25_state.raw_len);
+    CHECK_MEM(ax25_state.raw_packet, baseline_ax25_state.raw_packet, ax25_state.raw_len);
+    CHECK_EQ(ax25_state.packet_len, baseline_ax25_state.packet_len);
+    CHECK_MEM(ax25_state.packet, baseline_ax25_state.packet, (ax25_state.packet_len + 7) / 8);
+
+    printf("ax25: %u byte payload, %.2f us %lu cycles per frame with the table CRC, %.2f us %lu cycles with the bitwise CRC\n",
+           BENCH_PAYLOAD, 1e6 * seconds[0] / BENCH_FRAMES, (unsigned long)(cycles[0] / BENCH_FRAMES),
+           1e6 * seconds[1] / BENCH_FRAMES, (unsigned long)(cycles[1] / BENCH_FRAMES));
+}
+
+
+
+
+
+// ---------------------------------------------- //
+// -------------------- main -------------------- //
+// ---------------------------------------------- //
+
+int main(void) {
+    test_check_value();
+    test_reference();
+    test_residue();
+    test_benchmark();
+    return TEST_RESULT();
+}
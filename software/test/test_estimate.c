@@ -0,0 +1,302 @@
+/*-------------------------------------------------------------------------------- /
+/ Estimator tests
+/ -------------------------------------------------------------------------------- /
+/
+/ A synthetic balloon track with fix noise, encoded as GGA sentences and decoded
+/ through gnss_nmea_queue() and gnss_nmea_decode(), so the alpha-beta filter sees
+/ the fields as the decoder publishes them: the extrapolated position must stay
+/ within a bound of the true track, including across the wrap of the 16 bit tick
+/ count. Also covers the restart on implausible jumps, the longitude limit scaled
+/ by latitude, expiry and barometric altitude, and prints the host cycles per
+/ update.
+/
+/ --------------------------------------------------------------------------------*/
+
+#include "test.h"
+#include "host.h"
+#include "gnss.h"
+#include "nmea.h"
+#include "estimate.h"
+
+#define LAT_START       (42 * GNSS_MSEC_ARC_PER_DEG + 1000000)  // about 42.28 N
+#define LON_START       (-(83 * GNSS_MSEC_ARC_PER_DEG + 2600000))  // about 83.72 W
+#define LAT_RATE        100         // milliseconds of arc per second, about 3 m/s north
+#define LON_RATE        400         // about 9 m/s east
+#define ASCENT          5000        // mm/s
+#define POS_NOISE       50          // milliseconds of arc, about 1.5 m
+#define ALT_NOISE       2000        // mm
+#define TIMING_UPDATES  100000
+
+static uint32_t noise_state = 1;
+static gnss_t gnss;
+
+
+
+
+
+// ----------------------------------------------------------------- //
+// -------------------- private helper functions -------------------- //
+// ----------------------------------------------------------------- //
+
+// deterministic noise in [-amplitude, amplitude]
+static int32_t noise(int32_t amplitude) {
+    noise_state = noise_state * 1103515245 + 12345;
+    return (int32_t)((noise_state >> 8) % (2 * amplitude + 1)) - amplitude;
+}
+
+static gnss_fix_t make_fix(int32_t msec, int32_t latitude, int32_t longitude, int32_t altitude_mm) {
+    gnss_fix_t fix = {0};
+
+    fix.time.hour = msec / 3600000;
+    fix.time.min = (msec / 60000) % 60;
+    fix.time.msec = msec % 60000;
+    fix.location.latitude.dir = (latitude < 0) ? 'S' : 'N';
+    fix.location.latitude.decMilliSec = (latitude < 0) ? -latitude : latitude;
+    fix.location.longitude.dir = (longitude < 0) ? 'W' : 'E';
+    fix.location.longitude.decMilliSec = (longitude < 0) ? -longitude : longitude;
+    fix.altitude_mm = altitude_mm;
+    fix.quality = auto_fix;
+    return fix;
+}
+
+// the GNSS object as gnss_init() leaves it, without the UART and receiver configuration
+static void init(void) {
+    memset(&gnss, 0, sizeof(gnss));
+    CHECK(ring_buff_init(&gnss.gnss_rx_buff, gnss.gnss_rx_mem, GNSS_RX_BUFF_SIZE));
+    CHECK(ring_buff_init_descriptors(&gnss.gnss_rx_buff, gnss.gnss_rx_desc, GNSS_RX_MAX_PACKETS));
+    CHECK(ring_buff_set_policy(&gnss.gnss_rx_buff, RING_BUFF_DROP_OLDEST));
+    gnss.last_fix.quality = no_fix;
+    gnss_est_init(&gnss.estimator);
+    gnss_pps_init(&gnss.pps);
+    gnss.is_valid = true;
+}
+
+// ddmm.mmmmm or dddmm.mmmmm and the hemisphere of a signed coordinate, minutes rounded to the 5th decimal
+static int format_coordinate(char *text, uint16_t size, int32_t value, uint8_t deg_digits, const char *dirs) {
+    uint32_t magnitude = (value < 0) ? -value : value;
+    uint32_t minutes = ((magnitude % GNSS_MSEC_ARC_PER_DEG) * 5 + 1) / 3;
+
+    return snprintf(text, size, "%0*lu%02lu.%05lu,%c", deg_digits, (unsigned long)(magnitude / GNSS_MSEC_ARC_PER_DEG),
+                    (unsigned long)(minutes / 100000), (unsigned long)(minutes % 100000), dirs[value < 0]);
+}
+
+// a GGA sentence of the fix decoded at tick, queued a byte at a time as the RX interrupt does
+static void feed_fix(int32_t msec, int32_t latitude, int32_t longitude, int32_t altitude_mm, TickType_t tick) {
+    char body[96];
+    char sentence[128];
+    uint8_t checksum = 0;
+    int len;
+    int i;
+
+    len = snprintf(body, sizeof(body), "GPGGA,%02ld%02ld%02ld.%02ld,", (long)(msec / 3600000), (long)((msec / 60000) % 60),
+                   (long)((msec / 1000) % 60), (long)((msec % 1000) / 10));
+    len += format_coordinate(&body[len], sizeof(body) - len, latitude, 2, "NS");
+    body[len++] = ',';
+    len += format_coordinate(&body[len], sizeof(body) - len, longitude, 3, "EW");
+    snprintf(&body[len], sizeof(body) - len, ",1,08,1.01,%ld.%ld,M,-34.0,M,,", (long)(altitude_mm / 1000),
+             (long)((altitude_mm % 1000) / 100));
+    for(i = 0; body[i] != '\0'; i++) {
+        checksum ^= (uint8_t)body[i];
+    }
+    len = snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, checksum);
+
+    host_tick = tick;
+    for(i = 0; i < len; i++) {
+        gnss_nmea_queue(&gnss, sentence[i]);
+    }
+    CHECK_EQ(ring_buff_packet_count(&gnss.gnss_rx_buff), 1);
+    CHECK_EQ(gnss_nmea_decode(&gnss), NMEA_NO_FAULT);
+}
+
+static int32_t abs32(int32_t x) {
+    return (x < 0) ? -x : x;
+}
+
+
+
+
+
+// ----------------------------------------------- //
+// -------------------- tests -------------------- //
+// ----------------------------------------------- //
+
+// fixes along a constant velocity track through the NMEA decoder, extrapolated 5 s past the last one
+static void test_track(void) {
+    gnss_estimator_t *est = &gnss.estimator;
+    gnss_fix_t fix;
+    TickType_t tick = 65000;
+    int32_t msec = 12 * 3600000L;
+    int32_t worst_lat = 0;
+    int32_t worst_alt = 0;
+    int32_t t;
+
+    init();
+    CHECK(!est->state.valid);
+
+    // 60 fixes at 1 Hz, the tick count wraps after the first
+    for(t = 0; t < 60; t++) {
+        feed_fix(msec + t * 1000, LAT_START + LAT_RATE * t + noise(POS_NOISE), LON_START + LON_RATE * t + noise(POS_NOISE),
+                 20000000 + ASCENT * t + noise(ALT_NOISE), tick + t * 1000);
+        CHECK(est->state.valid);
+        CHECK_EQ(est->state.tick, (TickType_t)(tick + t * 1000));
+
+        if(t >= 10) {
+            // the estimate stays close to the truth once the velocity has settled
+            worst_lat = (abs32(est->state.latitude - (LAT_START + LAT_RATE * t)) > worst_lat)
+                ? abs32(est->state.latitude - (LAT_START + LAT_RATE * t)) : worst_lat;
+            worst_alt = (abs32(est->state.altitude_mm - (20000000 + ASCENT * t)) > worst_alt)
+                ? abs32(est->state.altitude_mm - (20000000 + ASCENT * t)) : worst_alt;
+        }
+    }
+    CHECK(worst_lat <= 2 * POS_NOISE);
+    CHECK(worst_alt <= 2 * ALT_NOISE);
+    CHECK(abs32(est->state.lat_rate - LAT_RATE) <= 20);
+    CHECK(abs32(est->state.lon_rate - LON_RATE) <= 20);
+    CHECK(abs32(est->state.ascent_mmps - ASCENT) <= 1000);
+    printf("track: worst error %ld mas, %ld mm, rates %ld %ld mas/s %ld mm/s\n", (long)worst_lat, (long)worst_alt,
+           (long)est->state.lat_rate, (long)est->state.lon_rate, (long)est->state.ascent_mmps);
+
+    // extrapolated 5 s past the last fix (t = 59), across the tick wrap
+    CHECK(gnss_get_fix(&gnss, &fix));
+    gnss_est_extrapolate(&est->state, tick + 64000, &fix);
+    CHECK_EQ(fix.location.latitude.dir, 'N');
+    CHECK_EQ(fix.location.longitude.dir, 'W');
+    CHECK(abs32(gnss_coordinate_signed(&fix.location.latitude) - (LAT_START + LAT_RATE * 64)) <= 250);
+    CHECK(abs32(gnss_coordinate_signed(&fix.location.longitude) - (LON_START + LON_RATE * 64)) <= 250);
+    CHECK(abs32(fix.altitude_mm - (20000000 + ASCENT * 64)) <= 10000);
+    CHECK_EQ(gnss_time_to_msec(&fix.time), msec + 64000);
+
+    // a second sentence of the same epoch is skipped
+    feed_fix(msec + 59000, LAT_START, LON_START, 0, tick + 59500);
+    CHECK_EQ(est->state.tick, (TickType_t)(tick + 59000));
+}
+
+// fixes further from the prediction than GNSS_VELOCITY_MAX allows restart the estimate
+static void test_jump(void) {
+    gnss_estimator_t est;
+    gnss_fix_t fix;
+    int32_t t;
+
+    gnss_est_init(&est);
+    for(t = 0; t < 5; t++) {
+        fix = make_fix(t * 1000, LAT_START + LAT_RATE * t, LON_START + LON_RATE * t, 1000000);
+        gnss_est_update_fix(&est, &fix, t * 1000, 0);
+    }
+    CHECK(est.state.lat_rate > 0);
+
+    // 1.5 km north in 1 s
+    fix = make_fix(5000, LAT_START + LAT_RATE * 5 + 1500000000L / GNSS_UM_PER_MSEC_ARC, LON_START + LON_RATE * 5, 1000000);
+    gnss_est_update_fix(&est, &fix, 5000, 0);
+    CHECK_EQ(est.state.latitude, gnss_coordinate_signed(&fix.location.latitude));
+    CHECK_EQ(est.state.lat_rate, 0);
+    CHECK_EQ(est.state.lon_rate, 0);
+
+    // 1.5 km up in 1 s
+    fix = make_fix(6000, gnss_coordinate_signed(&fix.location.latitude), LON_START + LON_RATE * 6, 2500000);
+    gnss_est_update_fix(&est, &fix, 6000, 0);
+    CHECK_EQ(est.state.altitude_mm, 2500000);
+    CHECK_EQ(est.state.ascent_mmps, 0);
+}
+
+// the same eastward speed is a faster longitude rate near the poles
+static void test_longitude_limit(void) {
+    gnss_estimator_t est;
+    gnss_fix_t fix;
+    int32_t lon_step;
+
+    // 300 m/s east at 80 N is about 56000 mas/s of longitude, above GNSS_EST_MAX_RATE but plausible there
+    lon_step = 300000000L / GNSS_UM_PER_MSEC_ARC * 32768 / gnss_cos_q15(80 * GNSS_MSEC_ARC_PER_DEG);
+    CHECK(lon_step > GNSS_EST_MAX_RATE);
+    gnss_est_init(&est);
+    fix = make_fix(0, 80 * GNSS_MSEC_ARC_PER_DEG, 0, 10000000);
+    gnss_est_update_fix(&est, &fix, 0, 0);
+    fix = make_fix(1000, 80 * GNSS_MSEC_ARC_PER_DEG, lon_step, 10000000);
+    gnss_est_update_fix(&est, &fix, 1000, 0);
+    CHECK(est.state.lon_rate > 0);
+
+    // at the equator the same step is a jump
+    gnss_est_init(&est);
+    fix = make_fix(0, 0, 0, 10000000);
+    gnss_est_update_fix(&est, &fix, 0, 0);
+    fix = make_fix(1000, 0, lon_step, 10000000);
+    gnss_est_update_fix(&est, &fix, 1000, 0);
+    CHECK_EQ(est.state.lon_rate, 0);
+    CHECK_EQ(est.state.longitude, lon_step);
+
+    // crossing the antimeridian isn't a jump
+    gnss_est_init(&est);
+    fix = make_fix(0, 0, 180 * GNSS_MSEC_ARC_PER_DEG - 10000, 10000000);
+    gnss_est_update_fix(&est, &fix, 0, 0);
+    fix = make_fix(1000, 0, -(180 * GNSS_MSEC_ARC_PER_DEG - 10000), 10000000);
+    gnss_est_update_fix(&est, &fix, 1000, 0);
+    CHECK(est.state.lon_rate > 0);
+    CHECK(est.state.longitude >= -180 * GNSS_MSEC_ARC_PER_DEG && est.state.longitude <= 180 * GNSS_MSEC_ARC_PER_DEG);
+}
+
+// the estimate expires without fixes, and barometric altitude takes over once they stop
+static void test_expire_baro(void) {
+    gnss_estimator_t est;
+    gnss_fix_t fix;
+
+    // standard atmosphere, interpolated within the table and extrapolated past its end
+    CHECK_EQ(gnss_est_baro_altitude(1014), 0);
+    CHECK(gnss_est_baro_altitude(1013) > 0 && gnss_est_baro_altitude(1013) < 20000);
+    CHECK(abs32(gnss_est_baro_altitude(226) - 11009091) <= 1);
+    CHECK_EQ(gnss_est_baro_altitude(4), 37000000);
+
+    gnss_est_init(&est);
+    fix = make_fix(0, LAT_START, LON_START, 11000000);
+    gnss_est_update_fix(&est, &fix, 0, 226);
+    CHECK(est.baro_bias_valid);
+    CHECK(!gnss_est_baro_due(&est, 1000));
+    CHECK(gnss_est_baro_due(&est, 2 * GNSS_NAV_PERIOD));
+
+    // the pressure of 1 km lower moves the altitude down
+    CHECK(gnss_est_update_baro(&est, 2 * GNSS_NAV_PERIOD, 264));
+    CHECK(est.state.altitude_mm < 11000000);
+    CHECK(est.state.ascent_mmps < 0);
+    CHECK(!gnss_est_update_baro(&est, 2 * GNSS_NAV_PERIOD + 10, 264));
+
+    CHECK(!gnss_est_expire(&est, GNSS_EST_MAX_GAP - 1));
+    CHECK(gnss_est_expire(&est, GNSS_EST_MAX_GAP));
+    CHECK(!est.state.valid);
+    CHECK(!gnss_est_baro_due(&est, GNSS_EST_MAX_GAP + 2000));
+}
+
+// host cycles per fix update, a rough relative measure of the filter's cost
+static void test_timing(void) {
+    gnss_estimator_t est;
+    gnss_fix_t fixes[16];
+    uint64_t cycles;
+    int32_t t;
+
+    for(t = 0; t < 16; t++) {
+        fixes[t] = make_fix(0, LAT_START + noise(POS_NOISE), LON_START + noise(POS_NOISE), 20000000 + noise(ALT_NOISE));
+    }
+    gnss_est_init(&est);
+    cycles = test_cycles();
+    for(t = 0; t < TIMING_UPDATES; t++) {
+        fixes[t & 15].time.msec = t % 60000;
+        gnss_est_update_fix(&est, &fixes[t & 15], t, 0);
+    }
+    cycles = test_cycles() - cycles;
+    CHECK(est.state.valid);
+    printf("timing: %lu cycles per gnss_est_update_fix()\n", (unsigned long)(cycles / TIMING_UPDATES));
+}
+
+
+
+
+
+// ---------------------------------------------- //
+// -------------------- main -------------------- //
+// ---------------------------------------------- //
+
+int main(void) {
+    test_track();
+    test_jump();
+    test_longitude_limit();
+    test_expire_baro();
+    test_timing();
+    return TEST_RESULT();
+}
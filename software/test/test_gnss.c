@@ -0,0 +1,1013 @@
+/*-------------------------------------------------------------------------------- /
+/ GNSS decoder tests
+/ -------------------------------------------------------------------------------- /
+/
+/ NMEA sentences (GGA, RMC, GNS, VTG, GSA) and UBX NAV-PVT frames queued and decoded
+/ through the same path as received bytes: decoded values, checksum and field
+/ faults, coordinate limits, the publishing of fixes without a position and of
+/ sentences without a time of their own, the velocity averaged over the history of
+/ fixes and its restarts. Runs task_gnss() over a received burst to count its
+/ wake-ups per sentence, publishes fixes on one thread while others read them,
+/ benchmarks the parser against the baseline decoder, and ends with a seeded fuzz
+/ loop of mutated sentences for the sanitizers that reports the faults and the
+/ decode rate. With a file argument it replays a capture of the receiver instead.
+/
+/ --------------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <math.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include "test.h"
+#include "host.h"
+#include "gnss.h"
+
+#define FUZZ_ITERATIONS     20000
+#define FUZZ_SEED           1
+#define TASK_EPOCHS         60
+#define STRESS_PUBLISHES    2000000
+#define STRESS_READERS      3
+#define BENCH_EPOCHS        100
+#define BENCH_PASSES        20
+#define TRACK_LAT_RATE      100         // milliseconds of arc per second, about 3 m/s north
+#define TRACK_LON_RATE      -400        // about 8 m/s west at 47 N
+#define TRACK_ASCENT        5000        // mm/s
+
+// 47 17.11399' N and 8 33.91590' E in milliseconds of arc
+#define LAT_4717            170226839L
+#define LON_00833           30834954L
+
+static gnss_t gnss;
+
+// the object task_gnss() runs on
+extern gnss_t GNSS;
+
+// the decoder of the baseline firmware, see nmea_baseline.c
+bool baseline_nmea_queue(gnss_t *gnss_obj, uint8_t datum);
+int8_t baseline_nmea_decode(gnss_t *gnss_obj);
+
+// bytes received while task_gnss() is blocked, see rx_hook()
+static char rx_data[TASK_EPOCHS * 240];
+static uint16_t rx_len;
+static uint16_t rx_pos;
+static uint16_t rx_epoch_len;
+static jmp_buf task_exit;
+
+// readers of the fixes published by stress_writer()
+typedef struct {
+    pthread_t thread;
+    uint32_t reads;
+    uint32_t copies;
+    uint32_t torn;
+    uint32_t backwards;
+} stress_reader_t;
+
+static volatile bool stress_done;
+
+// a 1 Hz capture of GGA, GSA, RMC and VTG for the parser benchmark
+static char bench_data[BENCH_EPOCHS * 300];
+
+// a balloon above 30 km and 40 km, where the receiver must be in its airborne mode
+static const char high_altitude[] =
+    "$GPGGA,153012.00,4217.00000,N,08343.20000,W,1,09,0.90,30480.0,M,-34.0,M,,*61\r\n"
+    "$GPGGA,153013.00,4217.00500,N,08343.19000,W,1,07,1.40,41523.7,M,-34.0,M,,*64\r\n";
+
+// an epoch after losing the fix: GGA of quality 0, void RMC, GSA without a fix and an empty VTG
+static const char no_fix_sequence[] =
+    "$GPGGA,153014.00,,,,,0,00,99.99,,,,,,*64\r\n"
+    "$GPRMC,153014.00,V,,,,,,,170926,,,N*74\r\n"
+    "$GPGSA,A,1,,,,,,,,,,,,,99.99,99.99,99.99*30\r\n"
+    "$GPVTG,,,,,,,,,N*30\r\n";
+
+static const char * const fuzz_seeds[] = {
+    "$GPGGA,092725.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,*5B\r\n",
+    "$GPRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A*57\r\n",
+    "$GPVTG,77.52,T,,M,0.004,N,0.008,K,A*06\r\n",
+    "$GNGSA,A,3,23,29,07,08,09,18,26,28,,,,,1.94,1.18,1.54*13\r\n",
+    "$GNGNS,103600.01,5114.51176,N,00012.29380,W,ANNN,07,1.18,111.5,45.6,,,V*00\r\n",
+    "$GPGGA,120001.00,,,,,0,00,99.99,,,,,,*00\r\n",
+    "$PUBX,00,081350.00,4717.113210,N,00833.915187,E,546.589,G3,2.1,2.0,0.007,77.52,0.007,,0.92,1.19,0.77,9,0,0*00\r\n",
+    high_altitude,
+    no_fix_sequence,
+};
+
+static const char * const nmea_faults[NMEA_FAULTS] = {
+    "decoded", "unknown talker", "unknown sentence", "unknown proprietary",
+    "payload overflow", "empty buffer", "checksum mismatch", "bad field",
+};
+
+
+
+
+
+// ----------------------------------------------------------------- //
+// -------------------- private helper functions -------------------- //
+// ----------------------------------------------------------------- //
+
+// the GNSS object as gnss_init() leaves it, without the UART and receiver configuration
+static void init(void) {
+    memset(&gnss, 0, sizeof(gnss));
+    CHECK(ring_buff_init(&gnss.gnss_rx_buff, gnss.gnss_rx_mem, GNSS_RX_BUFF_SIZE));
+    CHECK(ring_buff_init_descriptors(&gnss.gnss_rx_buff, gnss.gnss_rx_desc, GNSS_RX_MAX_PACKETS));
+    CHECK(ring_buff_set_policy(&gnss.gnss_rx_buff, RING_BUFF_DROP_OLDEST));
+    gnss.last_fix.quality = no_fix;
+    gnss_est_init(&gnss.estimator);
+    gnss_pps_init(&gnss.pps);
+    gnss.is_valid = true;
+    host_tick = 0;
+}
+
+// replaces the checksum of a sentence with the one computed over it
+static void set_checksum(char *sentence, uint16_t len) {
+    char *start = memchr(sentence, '$', len);
+    char *star;
+    uint8_t checksum = 0;
+    char hex[3];
+
+    if(start == NULL) {
+        return;
+    }
+    star = memchr(start, '*', len - (start - sentence));
+    if( (star == NULL) || (star + 2 >= sentence + len) ) {
+        return;
+    }
+    while(++start < star) {
+        checksum ^= (uint8_t)*start;
+    }
+    snprintf(hex, sizeof(hex), "%02X", checksum);
+    star[1] = hex[0];
+    star[2] = hex[1];
+}
+
+// queues a sentence in spans of up to 7 bytes and decodes it, returning the result of the last decode
+static int8_t feed(const char *sentence) {
+    uint16_t len = strlen(sentence);
+    uint16_t i;
+    int8_t result = NMEA_EMPTY_BUFFER;
+
+    for(i = 0; i < len; i += 7) {
+        gnss_nmea_queue_span(&gnss, (const uint8_t *)sentence + i, (len - i < 7) ? len - i : 7);
+    }
+    while(ring_buff_packet_count(&gnss.gnss_rx_buff) > 0) {
+        result = gnss_nmea_decode(&gnss);
+    }
+    return result;
+}
+
+// queues sentences in spans of up to 7 bytes and decodes them, returning the number rejected
+static uint16_t feed_rejected(const char *sentences) {
+    uint16_t len = strlen(sentences);
+    uint16_t rejected = 0;
+    uint16_t i;
+
+    for(i = 0; i < len; i += 7) {
+        gnss_nmea_queue_span(&gnss, (const uint8_t *)sentences + i, (len - i < 7) ? len - i : 7);
+    }
+    while(ring_buff_packet_count(&gnss.gnss_rx_buff) > 0) {
+        rejected += (gnss_nmea_decode(&gnss) != NMEA_NO_FAULT);
+    }
+    return rejected;
+}
+
+// adds the checksum and terminator to the body of a sentence (without '$'), returning its length
+static uint16_t build_sentence(char *sentence, uint16_t size, const char *body) {
+    uint8_t checksum = 0;
+    const char *ptr;
+
+    for(ptr = body; *ptr != '\0'; ptr++) {
+        checksum ^= (uint8_t)*ptr;
+    }
+    return snprintf(sentence, size, "$%s*%02X\r\n", body, checksum);
+}
+
+// adds the checksum and terminator to the body of a sentence and decodes it
+static int8_t feed_body(const char *body) {
+    char sentence[128];
+
+    build_sentence(sentence, sizeof(sentence), body);
+    return feed(sentence);
+}
+
+// stands in for the receiver while task_gnss() is blocked: bytes arrive at GNSS_BAUD_RATE through the RX interrupt
+// until a notification wakes the task, and each epoch starts GNSS_NAV_PERIOD after the last. Leaves the task when done
+static void rx_hook(TickType_t ticks) {
+    uint16_t bytes = 0;
+
+    // still configuring the receiver, which doesn't answer
+    if(!GNSS.is_valid) {
+        return;
+    }
+    while(host_notify == 0) {
+        if(rx_pos == rx_len) {
+            longjmp(task_exit, 1);
+        }
+        if(rx_pos % rx_epoch_len == 0) {
+            host_tick = (rx_pos / rx_epoch_len + 1) * GNSS_NAV_PERIOD;
+        }
+        uartReplayRx(&USCI_A0_cnf, (const unsigned char *)&rx_data[rx_pos++], 1);
+        bytes++;
+    }
+    host_tick += (uint32_t)bytes * 10000 / GNSS_BAUD_RATE;
+}
+
+// a fix of a track at t s going north, west and up at constant rates, decoded at msec (time of day)
+static void publish_track(int32_t msec, int32_t t, int32_t altitude_offset) {
+    gnss_fix_t fix = {0};
+
+    fix.time.hour = msec / 3600000;
+    fix.time.min = (msec / 60000) % 60;
+    fix.time.msec = msec % 60000;
+    fix.location.latitude.decMilliSec = LAT_4717 + TRACK_LAT_RATE * t;
+    fix.location.latitude.dir = 'N';
+    fix.location.longitude.decMilliSec = LON_00833 + TRACK_LON_RATE * t;
+    fix.location.longitude.dir = 'E';
+    fix.altitude_mm = 20000000 + TRACK_ASCENT * t + altitude_offset;
+    fix.quality = auto_fix;
+    fix.timestamp.msec = -1;
+    gnss_publish_fix(&gnss, &fix);
+}
+
+// the published velocity is the track's at t s, averaged over window_ms
+static void check_track_velocity(int32_t t, int32_t window_ms) {
+    gnss_velocity_t velocity;
+    int32_t ascent;
+    double cos_lat = cos((LAT_4717 + TRACK_LAT_RATE * t) * M_PI / (180.0 * GNSS_MSEC_ARC_PER_DEG));
+    double east = TRACK_LON_RATE * GNSS_UM_PER_MSEC_ARC / 1000.0 * cos_lat;
+
+    CHECK(gnss_get_velocity(&gnss, &velocity));
+    CHECK_EQ(velocity.window_ms, window_ms);
+    CHECK_EQ(velocity.north_mmps, TRACK_LAT_RATE * GNSS_UM_PER_MSEC_ARC / 1000);
+    // gnss_cos_q15() interpolates every 10 degrees, within 0.4%
+    CHECK(fabs(velocity.east_mmps - east) <= fabs(east) * 0.004);
+    CHECK(fabs(velocity.ground_mmps - hypot(velocity.north_mmps, velocity.east_mmps)) <= 1);
+    CHECK_EQ(velocity.ascent_mmps, TRACK_ASCENT);
+    CHECK(gnss_get_ascent_rate(&gnss, &ascent));
+    CHECK_EQ(ascent, TRACK_ASCENT);
+}
+
+// the n-th fix of the stress test, every field is derived from n and 8 fixes share each epoch
+static void stress_fix(gnss_fix_t *fix, uint32_t n) {
+    uint32_t sec = (n / 8) % 86400;
+
+    fix->time.hour = sec / 3600;
+    fix->time.min = (sec / 60) % 60;
+    fix->time.msec = (sec % 60) * 1000;
+    fix->location.latitude.decMilliSec = LAT_4717 + n;
+    fix->location.latitude.dir = 'N';
+    fix->location.longitude.decMilliSec = LON_00833 + 2 * n;
+    fix->location.longitude.dir = 'E';
+    fix->quality = auto_fix;
+    fix->num_satellites = 4 + n % 8;
+    fix->altitude_mm = n;
+    fix->speed_mmps = 3 * n;
+    fix->course_mdeg = n % 360000;
+    fix->pdop = n;
+    fix->hdop = n + 1;
+    fix->vdop = n + 2;
+    fix->fix_mode = 3;
+    fix->timestamp.msec = -1;
+    fix->timestamp.usec = 0;
+}
+
+// the GNSS task: publishes fix after fix, mostly replacing the fields of an epoch, and drops the fix every 16th
+static void * stress_writer(void *arg) {
+    gnss_fix_t fix;
+    uint32_t n;
+
+    (void)arg;
+    for(n = 1; n <= STRESS_PUBLISHES; n++) {
+        stress_fix(&fix, n);
+        fix.quality = (n % 16 == 0) ? no_fix : auto_fix;
+        host_tick += GNSS_NAV_PERIOD / 8;
+        gnss_publish_fix(&gnss, &fix);
+    }
+    stress_done = true;
+    return NULL;
+}
+
+// another task: every copy of the fix must be one fix that was published, and never older than the last one
+static void * stress_reader(void *arg) {
+    stress_reader_t *reader = arg;
+    gnss_fix_t fix;
+    gnss_fix_t expected;
+    uint32_t last = 0;
+
+    while(!stress_done) {
+        reader->reads++;
+        if(!gnss_get_fix(&gnss, &fix)) {
+            continue;
+        }
+        reader->copies++;
+        stress_fix(&expected, fix.altitude_mm);
+        if( (gnss_time_to_msec(&fix.time) != gnss_time_to_msec(&expected.time)) ||
+            (fix.location.latitude.decMilliSec != expected.location.latitude.decMilliSec) ||
+            (fix.location.longitude.decMilliSec != expected.location.longitude.decMilliSec) ||
+            (fix.num_satellites != expected.num_satellites) || (fix.speed_mmps != expected.speed_mmps) ||
+            (fix.course_mdeg != expected.course_mdeg) || (fix.pdop != expected.pdop) ||
+            (fix.hdop != expected.hdop) || (fix.vdop != expected.vdop) ) {
+            reader->torn++;
+        }
+        if((uint32_t)fix.altitude_mm < last) {
+            reader->backwards++;
+        }
+        last = fix.altitude_mm;
+    }
+    return NULL;
+}
+
+// every published fix is in range
+static void check_published(void) {
+    gnss_fix_t fix;
+
+    if(gnss_get_fix(&gnss, &fix)) {
+        CHECK(fix.location.latitude.decMilliSec <= 90 * GNSS_MSEC_ARC_PER_DEG);
+        CHECK(fix.location.longitude.decMilliSec <= 180 * GNSS_MSEC_ARC_PER_DEG);
+        CHECK(fix.location.latitude.dir == 'N' || fix.location.latitude.dir == 'S');
+        CHECK(fix.location.longitude.dir == 'E' || fix.location.longitude.dir == 'W');
+        CHECK(fix.time.hour < 24 && fix.time.min < 60 && fix.time.msec <= 60999);
+    }
+}
+
+// prints the sentences decoded and rejected for each reason, and the host time spent queueing and decoding them
+static void report(const char *name, const uint32_t *results, uint64_t cycles, double seconds) {
+    uint32_t sentences = 0;
+    uint8_t i;
+
+    for(i = 0; i < NMEA_FAULTS; i++) {
+        sentences += results[i];
+    }
+    printf("%s: %lu sentences:", name, (unsigned long)sentences);
+    for(i = 0; i < NMEA_FAULTS; i++) {
+        printf("%s %lu %s", (i == 0) ? "" : ",", (unsigned long)results[i], nmea_faults[i]);
+    }
+    printf("\n%s: %.0f sentences/s, %lu cycles per sentence (sanitized build)\n", name,
+           (seconds > 0) ? sentences / seconds : 0, (unsigned long)(sentences ? cycles / sentences : 0));
+}
+
+// builds a NAV-PVT frame with a checksum
+static uint16_t nav_pvt_frame(uint8_t *frame, uint8_t fix_type, uint8_t flags, uint8_t hour, int32_t nano, int32_t lat, int32_t lon) {
+    uint8_t *payload = &frame[6];
+    uint8_t ck_a = 0;
+    uint8_t ck_b = 0;
+    uint16_t i;
+
+    memset(frame, 0, 8 + UBX_NAV_PVT_LEN);
+    frame[0] = UBX_SYNC_1;
+    frame[1] = UBX_SYNC_2;
+    frame[2] = 0x01;
+    frame[3] = 0x07;
+    frame[4] = UBX_NAV_PVT_LEN;
+    frame[5] = 0;
+    payload[UBX_NAV_PVT_HOUR] = hour;
+    payload[UBX_NAV_PVT_MIN] = 30;
+    payload[UBX_NAV_PVT_SEC] = 15;
+    payload[UBX_NAV_PVT_VALID] = UBX_NAV_PVT_VALID_TIME;
+    memcpy(&payload[UBX_NAV_PVT_NANO], &nano, 4);
+    payload[UBX_NAV_PVT_FIX_TYPE] = fix_type;
+    payload[UBX_NAV_PVT_FLAGS] = flags;
+    payload[UBX_NAV_PVT_NUM_SV] = 11;
+    memcpy(&payload[UBX_NAV_PVT_LON], &lon, 4);
+    memcpy(&payload[UBX_NAV_PVT_LAT], &lat, 4);
+    payload[UBX_NAV_PVT_HMSL] = 0x40;       // 0x00030D40 mm = 200 m
+    payload[UBX_NAV_PVT_HMSL + 1] = 0x0D;
+    payload[UBX_NAV_PVT_HMSL + 2] = 0x03;
+    payload[UBX_NAV_PVT_GSPEED] = 250;
+    payload[UBX_NAV_PVT_PDOP] = 150;
+
+    for(i = 2; i < 6 + UBX_NAV_PVT_LEN; i++) {
+        ck_a += frame[i];
+        ck_b += ck_a;
+    }
+    frame[6 + UBX_NAV_PVT_LEN] = ck_a;
+    frame[7 + UBX_NAV_PVT_LEN] = ck_b;
+    return 8 + UBX_NAV_PVT_LEN;
+}
+
+
+
+
+
+// ----------------------------------------------- //
+// -------------------- tests -------------------- //
+// ----------------------------------------------- //
+
+// the values of every field decoded from a GGA
+static void test_gga(void) {
+    gnss_fix_t fix;
+
+    init();
+    CHECK(!gnss_get_fix(&gnss, &fix));
+    CHECK(!gnss_get_last_fix(&gnss, &fix));
+    CHECK_EQ(feed("$GPGGA,092725.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,*5B\r\n"), NMEA_NO_FAULT);
+    CHECK(gnss_get_fix(&gnss, &fix));
+    CHECK_EQ(fix.time.hour, 9);
+    CHECK_EQ(fix.time.min, 27);
+    CHECK_EQ(fix.time.msec, 25000);
+    CHECK_EQ(fix.location.latitude.decMilliSec, LAT_4717);
+    CHECK_EQ(fix.location.latitude.dir, 'N');
+    CHECK_EQ(fix.location.longitude.decMilliSec, LON_00833);
+    CHECK_EQ(fix.location.longitude.dir, 'E');
+    CHECK_EQ(fix.quality, auto_fix);
+    CHECK_EQ(fix.num_satellites, 8);
+    CHECK_EQ(fix.hdop, 101);
+    CHECK_EQ(fix.altitude_mm, 499600);
+    CHECK(gnss.estimate.valid);
+
+    // the altitude of a balloon
+    CHECK_EQ(feed_rejected(high_altitude), 0);
+    CHECK(gnss_get_fix(&gnss, &fix));
+    CHECK_EQ(fix.time.msec, 13000);
+    CHECK_EQ(fix.location.longitude.dir, 'W');
+    CHECK_EQ(fix.altitude_mm, 41523700);
+}
+
+// RMC, GNS, GSA and VTG, and the merging of the sentences of one epoch
+static void test_rmc_gns_gsa_vtg(void) {
+    gnss_fix_t fix;
+
+    init();
+    CHECK_EQ(feed("$GPRMC,083559.00,A,4717.11437,N,00833.91522,E,0.004,77.52,091202,,,A*57\r\n"), NMEA_NO_FAULT);
+    CHECK(gnss_get_fix(&gnss, &fix));
+    CHECK_EQ(gnss_time_to_msec(&fix.time), (8 * 3600 + 35 * 60 + 59) * 1000L);
+    CHECK_EQ(fix.location.latitude.decMilliSec, 170226862L);
+    CHECK_EQ(fix.location.longitude.decMilliSec, 30834913L);
+    CHECK_EQ(fix.speed_mmps, 2);
+    CHECK_EQ(fix.course_mdeg, 77520);
+    CHECK_EQ(fix.quality, auto_fix);
+
+    // sentences without a time of their own update the fix of the epoch
+    host_tick += 100;
+    CHECK_EQ(feed("$GNGSA,A,3,23,29,07,08,09,18,26,28,,,,,1.94,1.18,1.54*13\r\n"), NMEA_NO_FAULT);
+    CHECK(gnss_get_fix(&gnss, &fix));
+    CHECK_EQ(fix.fix_mode, 3);
+    CHECK_EQ(fix.pdop, 194);
+    CHECK_EQ(fix.hdop, 118);
+    CHECK_EQ(fix.vdop, 154);
+    CHECK_EQ(feed_body("GPVTG,180.5,T,,M,10.0,N,18.5,K,A"), NMEA_NO_FAULT);
+    CHECK(gnss_get_fix(&gnss, &fix));
+    CHECK_EQ(fix.course_mdeg, 180500);
+    CHECK_EQ(fix.speed_mmps, 5144);
+    CHECK_EQ(fix.location.latitude.decMilliSec, 170226862L);
+
+    // but not once the epoch is over
+    host_tick += GNSS_EPOCH_WINDOW;
+    CHECK_EQ(feed_body("GPVTG,90.0,T,,M,1.0,N,1.85,K,A"), NMEA_NO_FAULT);
+    CHECK(gnss_get_fix(&gnss, &fix));
+    CHECK_EQ(fix.course_mdeg, 180500);
+
+    // GNS with the mode of the combined solution first
+    CHECK_EQ(feed_body("GNGNS,103600.01,5114.51176,N,00012.29380,W,DNNN,07,1.18,111.5,45.6,,,V"), NMEA_NO_FAULT);
+    CHECK(gnss_get_fix(&gnss, &fix));
+    CHECK_EQ(gnss_time_to_msec(&fix.time), (10 * 3600 + 36 * 60) * 1000L + 10);
+    CHECK_EQ(fix.location.latitude.decMilliSec, 51 * 3600000L + 14 * 60000L + 30706);
+    CHECK_EQ(fix.location.longitude.dir, 'W');
+    CHECK_EQ(gnss_coordinate_signed(&fix.location.longitude), -(12 * 60000L + 17628));
+    CHECK_EQ(fix.quality, diff_fix);
+    CHECK_EQ(fix.num_satellites, 7);
+    CHECK_EQ(fix.altitude_mm, 111500);
+}
+
+// faulty sentences are rejected and leave the published fix alone
+static void test_faults(void) {
+    gnss_fix_t before;
+    gnss_fix_t after;
+
+    init();
+    CHECK_EQ(feed_body("GPGGA,092725.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,"), NMEA_NO_FAULT);
+    CHECK(gnss_get_fix(&gnss, &before));
+
+    CHECK_EQ(feed("$GPGGA,092726.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,*5C\r\n"), NMEA_CHECKSUM_MISMATCH);
+    CHECK_EQ(feed("$GPGGA,092726.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,\r\n"), NMEA_CHECKSUM_MISMATCH);
+    CHECK_EQ(feed("$GPGGA,092726.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,*5B junk\r\n"), NMEA_CHECKSUM_MISMATCH);
+    CHECK_EQ(feed_body("XXGGA,092726.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,"), NMEA_UNKNOWN_TALKER);
+    CHECK_EQ(feed_body("GPXYZ,1,2,3"), NMEA_UNKNOWN_SENTENCE);
+    CHECK_EQ(feed_body("GPGGAX,1"), NMEA_UNKNOWN_SENTENCE);
+    CHECK_EQ(feed_body("PUBX,99,1"), NMEA_UNKNOWN_SENTENCE);
+    CHECK_EQ(feed_body("PXXXX,1"), NMEA_UNKNOWN_TALKER);
+
+    // malformed fields
+    CHECK_EQ(feed_body("GPGGA,250000.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,"), NMEA_BAD_FIELD);
+    CHECK_EQ(feed_body("GPGGA,096000.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,"), NMEA_BAD_FIELD);
+    CHECK_EQ(feed_body("GPGGA,092726.00,4760.00000,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,"), NMEA_BAD_FIELD);
+    CHECK_EQ(feed_body("GPGGA,092726.00,471.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,"), NMEA_BAD_FIELD);
+    CHECK_EQ(feed_body("GPGGA,092726.00,4717,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,"), NMEA_BAD_FIELD);
+    CHECK_EQ(feed_body("GPGGA,092726.00,-4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,"), NMEA_BAD_FIELD);
+    CHECK_EQ(feed_body("GPGGA,092726.00,4717.11399,X,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,"), NMEA_BAD_FIELD);
+    CHECK_EQ(feed_body("GPGGA,092726.00,4717.11399,E,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,"), NMEA_BAD_FIELD);
+    CHECK_EQ(feed_body("GPGGA,092726.00,4717.11399,N,00833.91590,S,1,08,1.01,499.6,M,48.0,M,,"), NMEA_BAD_FIELD);
+    CHECK_EQ(feed_body("GPGGA,092726.00,4717.11399,N,00833.91590,E,1,300,1.01,499.6,M,48.0,M,,"), NMEA_BAD_FIELD);
+    CHECK_EQ(feed_body("GPGGA,092726.00,4717.11399,N,00833.91590,E,1,08,1.0x,499.6,M,48.0,M,,"), NMEA_BAD_FIELD);
+    CHECK_EQ(feed_body("GPGGA,092726.00,4717.11399,N,00833.91590,E,1,08,1.01,99999999999.6,M,48.0,M,,"), NMEA_BAD_FIELD);
+
+    CHECK(gnss_get_fix(&gnss, &after));
+    CHECK_MEM(&after, &before, sizeof(gnss_fix_t));
+
+    // a sentence cut short by the next one is dropped, the next one is decoded
+    gnss_nmea_queue_span(&gnss, (const uint8_t *)"$GPGGA,092726.00,4717.1", 23);
+    CHECK_EQ(feed_body("GPGGA,092727.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,"), NMEA_NO_FAULT);
+    CHECK(gnss_get_fix(&gnss, &after));
+    CHECK_EQ(after.time.msec, 27000);
+}
+
+// coordinates up to the poles and the antimeridian are accepted, not beyond
+static void test_coordinate_limits(void) {
+    gnss_fix_t fix;
+
+    init();
+    CHECK_EQ(feed_body("GPGGA,000000.00,9000.00000,S,18000.00000,W,1,08,1.01,0.0,M,,,,"), NMEA_NO_FAULT);
+    CHECK(gnss_get_fix(&gnss, &fix));
+    CHECK_EQ(gnss_coordinate_signed(&fix.location.latitude), -90 * GNSS_MSEC_ARC_PER_DEG);
+    CHECK_EQ(gnss_coordinate_signed(&fix.location.longitude), -180 * GNSS_MSEC_ARC_PER_DEG);
+    CHECK_EQ(feed_body("GPGGA,000001.00,9000.00001,N,00000.00000,E,1,08,1.01,0.0,M,,,,"), NMEA_BAD_FIELD);
+    CHECK_EQ(feed_body("GPGGA,000001.00,0000.00000,N,18000.00001,E,1,08,1.01,0.0,M,,,,"), NMEA_BAD_FIELD);
+    CHECK_EQ(feed_body("GPGGA,000001.00,8959.99999,N,17959.99999,E,1,08,1.01,0.0,M,,,,"), NMEA_NO_FAULT);
+    CHECK(gnss_get_fix(&gnss, &fix));
+    CHECK_EQ(fix.location.latitude.decMilliSec, 90 * GNSS_MSEC_ARC_PER_DEG - 1);
+    CHECK_EQ(fix.location.longitude.decMilliSec, 180 * GNSS_MSEC_ARC_PER_DEG - 1);
+
+    // a leap second
+    CHECK_EQ(feed_body("GPGGA,235960.00,0000.00000,N,00000.00000,E,1,08,1.01,0.0,M,,,,"), NMEA_NO_FAULT);
+    CHECK(gnss_get_fix(&gnss, &fix));
+    CHECK_EQ(fix.time.msec, 60000);
+}
+
+// position sentences without a fix are published as no_fix and keep the last known position
+static void test_no_fix(void) {
+    gnss_fix_t fix;
+
+    init();
+    CHECK_EQ(feed("$GPGGA,092725.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,*5B\r\n"), NMEA_NO_FAULT);
+    CHECK(gnss_get_fix(&gnss, &fix));
+
+    // quality 0
+    CHECK_EQ(feed_body("GPGGA,092726.00,,,,,0,00,99.99,,,,,,"), NMEA_NO_FAULT);
+    CHECK(!gnss_get_fix(&gnss, &fix));
+    CHECK(gnss_get_last_fix(&gnss, &fix));
+    CHECK_EQ(fix.quality, no_fix);
+    CHECK_EQ(fix.location.latitude.decMilliSec, LAT_4717);
+    CHECK(gnss_predict(&gnss, host_tick, &fix));
+
+    // a GSA or VTG doesn't bring the fix back
+    CHECK_EQ(feed("$GNGSA,A,3,23,29,07,08,09,18,26,28,,,,,1.94,1.18,1.54*13\r\n"), NMEA_NO_FAULT);
+    CHECK(!gnss_get_fix(&gnss, &fix));
+
+    // a valid quality without a time of its own is stale data, not a fix
+    CHECK_EQ(feed_body("GPGGA,,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,"), NMEA_NO_FAULT);
+    CHECK(!gnss_get_fix(&gnss, &fix));
+    CHECK_EQ(feed_body("GPRMC,092727.00,V,4717.11399,N,00833.91590,E,,,091202,,,N"), NMEA_NO_FAULT);
+    CHECK(!gnss_get_fix(&gnss, &fix));
+
+    // a coordinate without its hemisphere isn't a position
+    CHECK_EQ(feed_body("GPGGA,092727.50,4717.11399,,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,"), NMEA_NO_FAULT);
+    CHECK(!gnss_get_fix(&gnss, &fix));
+
+    // the next complete fix is published again
+    CHECK_EQ(feed_body("GPGGA,092728.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,"), NMEA_NO_FAULT);
+    CHECK(gnss_get_fix(&gnss, &fix));
+    CHECK_EQ(fix.time.msec, 28000);
+
+    // a whole epoch without a fix, every sentence of it decodes
+    CHECK_EQ(feed_rejected(no_fix_sequence), 0);
+    CHECK(!gnss_get_fix(&gnss, &fix));
+    CHECK(gnss_get_last_fix(&gnss, &fix));
+    CHECK_EQ(fix.time.msec, 28000);
+}
+
+// NAV-PVT frames through the UBX framer and decoder
+static void test_ubx_nav_pvt(void) {
+    uint8_t frame[8 + UBX_NAV_PVT_LEN];
+    gnss_fix_t fix;
+    uint16_t len;
+
+    init();
+    gnss.ubx_framer.state = UBX_STATE_SYNC_1;
+
+    // 3D fix, the negative nanoseconds borrow from the second
+    len = nav_pvt_frame(frame, 3, UBX_NAV_PVT_GNSS_FIX_OK | UBX_NAV_PVT_DIFF_SOLN, 12, -250000000L, 422800000L, -837200000L);
+    CHECK_EQ(gnss_ubx_queue_span(&gnss, frame, len), 1);
+    CHECK_EQ(gnss_ubx_decode(&gnss), UBX_NO_FAULT);
+    CHECK(gnss_get_fix(&gnss, &fix));
+    CHECK_EQ(fix.quality, diff_fix);
+    CHECK_EQ(fix.time.hour, 12);
+    CHECK_EQ(fix.time.min, 30);
+    CHECK_EQ(fix.time.msec, 14750);
+    CHECK_EQ(gnss_coordinate_signed(&fix.location.latitude), 42.28 * GNSS_MSEC_ARC_PER_DEG);
+    CHECK_EQ(gnss_coordinate_signed(&fix.location.longitude), -83.72 * GNSS_MSEC_ARC_PER_DEG);
+    CHECK_EQ(fix.num_satellites, 11);
+    CHECK_EQ(fix.altitude_mm, 200000);
+    CHECK_EQ(fix.speed_mmps, 250);
+    CHECK_EQ(fix.pdop, 150);
+    CHECK_EQ(fix.fix_mode, 3);
+    CHECK_EQ(gnss_ubx_decode(&gnss), UBX_EMPTY_BUFFER);
+
+    // a corrupted frame is dropped by the framer
+    len = nav_pvt_frame(frame, 3, UBX_NAV_PVT_GNSS_FIX_OK, 12, 0, 0, 0);
+    frame[20] ^= 1;
+    CHECK_EQ(gnss_ubx_queue_span(&gnss, frame, len), 0);
+
+    // out of range location
+    len = nav_pvt_frame(frame, 3, UBX_NAV_PVT_GNSS_FIX_OK, 12, 0, 900000001L, 0);
+    CHECK_EQ(gnss_ubx_queue_span(&gnss, frame, len), 1);
+    CHECK_EQ(gnss_ubx_decode(&gnss), UBX_BAD_FIELD);
+    len = nav_pvt_frame(frame, 3, UBX_NAV_PVT_GNSS_FIX_OK, 24, 0, 0, 0);
+    CHECK_EQ(gnss_ubx_queue_span(&gnss, frame, len), 1);
+    CHECK_EQ(gnss_ubx_decode(&gnss), UBX_BAD_FIELD);
+    CHECK(gnss_get_fix(&gnss, &fix));
+    CHECK_EQ(fix.time.msec, 14750);
+
+    // no fix is published too, keeping the last position
+    len = nav_pvt_frame(frame, UBX_NAV_PVT_FIX_TIME_ONLY, UBX_NAV_PVT_GNSS_FIX_OK, 12, 0, 0, 0);
+    CHECK_EQ(gnss_ubx_queue_span(&gnss, frame, len), 1);
+    CHECK_EQ(gnss_ubx_decode(&gnss), UBX_NO_FAULT);
+    CHECK(!gnss_get_fix(&gnss, &fix));
+    CHECK(gnss_get_last_fix(&gnss, &fix));
+    CHECK_EQ(gnss_coordinate_signed(&fix.location.latitude), 42.28 * GNSS_MSEC_ARC_PER_DEG);
+
+    // frames of the wrong length or an unknown message
+    frame[0] = UBX_SYNC_1;
+    frame[1] = UBX_SYNC_2;
+    frame[2] = 0x01;
+    frame[3] = 0x07;
+    frame[4] = 2;
+    frame[5] = 0;
+    frame[6] = 0;
+    frame[7] = 0;
+    frame[8] = 0x0A;
+    frame[9] = 0x31;
+    CHECK_EQ(gnss_ubx_queue_span(&gnss, frame, 10), 1);
+    CHECK_EQ(gnss_ubx_decode(&gnss), UBX_BAD_LENGTH);
+    frame[3] = 0x08;
+    frame[8] = 0x0B;
+    frame[9] = 0x36;
+    CHECK_EQ(gnss_ubx_queue_span(&gnss, frame, 10), 1);
+    CHECK_EQ(gnss_ubx_decode(&gnss), UBX_UNKNOWN_MESSAGE);
+}
+
+// the velocity and ascent averaged over the fix history of a constant velocity track, and the restart of the
+// history after a gap or a time going backwards
+static void test_history(void) {
+    const int32_t noon = 12 * 3600000L;
+    gnss_velocity_t velocity;
+    int32_t ascent;
+    int32_t t;
+
+    // one fix isn't a velocity
+    init();
+    publish_track(noon, 0, 0);
+    CHECK(!gnss_get_velocity(&gnss, &velocity));
+    CHECK(!gnss_get_ascent_rate(&gnss, &ascent));
+
+    // the window grows to the GNSS_HISTORY_LEN fixes and then slides
+    for(t = 1; t <= 10; t++) {
+        publish_track(noon + t * 1000, t, 0);
+        check_track_velocity(t, ((t < GNSS_HISTORY_LEN) ? t : GNSS_HISTORY_LEN - 1) * 1000);
+    }
+
+    // a gap of GNSS_HISTORY_MAX_GAP keeps the history
+    t = 10 + GNSS_HISTORY_MAX_GAP / 1000;
+    publish_track(noon + t * 1000, t, 0);
+    check_track_velocity(t, (t - 4) * 1000);
+
+    // a longer one restarts it, so a jump of the track during the gap doesn't show
+    t += GNSS_HISTORY_MAX_GAP / 1000 + 1;
+    publish_track(noon + t * 1000, t, 1000000);
+    CHECK(!gnss_get_velocity(&gnss, &velocity));
+    publish_track(noon + (t + 1) * 1000, t + 1, 1000000);
+    check_track_velocity(t + 1, 1000);
+
+    // so does a time going backwards
+    publish_track(noon + (t - 3) * 1000, t - 3, 0);
+    CHECK(!gnss_get_velocity(&gnss, &velocity));
+    CHECK(!gnss_get_ascent_rate(&gnss, &ascent));
+    publish_track(noon + (t - 2) * 1000, t - 2, 0);
+    check_track_velocity(t - 2, 1000);
+
+    // but not midnight
+    publish_track(GNSS_MSEC_PER_DAY - 2000, 100, 0);
+    CHECK(!gnss_get_velocity(&gnss, &velocity));
+    publish_track(GNSS_MSEC_PER_DAY - 1000, 101, 0);
+    publish_track(0, 102, 0);
+    publish_track(1000, 103, 0);
+    check_track_velocity(103, 3000);
+}
+
+// task_gnss() on a 1 Hz burst of GGA, GSA and RMC is woken up and decodes once per sentence
+static void test_task_wakeups(void) {
+    char body[100];
+    uint32_t sentences = 0;
+    uint32_t spans = 0;
+    uint16_t len;
+    uint16_t epoch;
+    uint8_t i;
+
+    rx_len = 0;
+    for(epoch = 0; epoch < TASK_EPOCHS; epoch++) {
+        for(i = 0; i < 3; i++) {
+            if(i == 0) {
+                snprintf(body, sizeof(body), "GPGGA,1200%02u.00,4717.11399,N,00833.91590,E,1,08,1.01,499.6,M,48.0,M,,", epoch);
+            }
+            else if(i == 1) {
+                snprintf(body, sizeof(body), "GNGSA,A,3,23,29,07,08,09,18,26,28,,,,,1.94,1.18,1.54");
+            }
+            else {
+                snprintf(body, sizeof(body), "GPRMC,1200%02u.00,A,4717.11399,N,00833.91590,E,0.004,77.52,091202,,,A", epoch);
+            }
+            len = build_sentence(&rx_data[rx_len], sizeof(rx_data) - rx_len, body);
+            rx_len += len;
+            sentences++;
+            // the span callback runs for every terminator and every full staging buffer
+            spans += (len + UART_RX_STAGE_SIZE - 1) / UART_RX_STAGE_SIZE;
+        }
+        if(epoch == 0) {
+            rx_epoch_len = rx_len;
+        }
+    }
+
+    rx_pos = 0;
+    host_tick = 0;
+    host_notify = 0;
+    host_notify_gives = 0;
+    host_wakeups = 0;
+    host_blocked_hook = &rx_hook;
+    if(setjmp(task_exit) == 0) {
+        task_gnss();
+    }
+    host_blocked_hook = NULL;
+
+    CHECK_EQ(rx_pos, rx_len);
+    CHECK_EQ(host_notify_gives, sentences);
+    CHECK_EQ(host_wakeups, sentences);
+    CHECK_EQ(GNSS.stats.decode_count, sentences);
+    CHECK_EQ(GNSS.stats.decoded, sentences);
+    printf("task: %lu wake-ups and %lu decode calls for %lu sentences of %u bytes "
+           "(a wake-up per byte would be %u, per RX span %lu)\n", (unsigned long)host_wakeups,
+           (unsigned long)GNSS.stats.decode_count, (unsigned long)sentences, rx_len, rx_len, (unsigned long)spans);
+}
+
+// readers on other threads never get a fix mixing the fields of two published fixes
+static void test_publish_stress(void) {
+    stress_reader_t readers[STRESS_READERS];
+    pthread_t writer;
+    uint32_t reads = 0;
+    uint32_t copies = 0;
+    uint8_t i;
+
+    init();
+    memset(readers, 0, sizeof(readers));
+    stress_done = false;
+    for(i = 0; i < STRESS_READERS; i++) {
+        CHECK_EQ(pthread_create(&readers[i].thread, NULL, &stress_reader, &readers[i]), 0);
+    }
+    CHECK_EQ(pthread_create(&writer, NULL, &stress_writer, NULL), 0);
+    pthread_join(writer, NULL);
+    for(i = 0; i < STRESS_READERS; i++) {
+        pthread_join(readers[i].thread, NULL);
+        CHECK_EQ(readers[i].torn, 0);
+        CHECK_EQ(readers[i].backwards, 0);
+        reads += readers[i].reads;
+        copies += readers[i].copies;
+    }
+    CHECK(copies > 0);
+    printf("stress: %u publishes, %u reads on %u threads, %u copies of a fix\n", STRESS_PUBLISHES,
+           (unsigned)reads, STRESS_READERS, (unsigned)copies);
+}
+
+// mutated sentences split into random spans never publish an impossible fix (or trip the sanitizers)
+static void test_fuzz(void) {
+    char sentence[400];
+    uint32_t results[NMEA_FAULTS] = {0};
+    uint64_t cycles = 0;
+    uint64_t start;
+    double seconds = 0;
+    double started;
+    int8_t result;
+    uint16_t len;
+    uint16_t pos;
+    uint16_t i;
+    uint16_t span;
+    uint8_t mutations;
+    uint8_t op;
+    long iteration;
+
+    init();
+    srand(FUZZ_SEED);
+    for(iteration = 0; iteration < FUZZ_ITERATIONS; iteration++) {
+        strcpy(sentence, fuzz_seeds[rand() % (sizeof(fuzz_seeds) / sizeof(fuzz_seeds[0]))]);
+        len = strlen(sentence);
+
+        // overwrite, insert, delete or repeat bytes
+        for(mutations = rand() % 6; mutations > 0; mutations--) {
+            op = rand() % 4;
+            pos = rand() % len;
+            if(op == 0) {
+                sentence[pos] = rand() % 256;
+            }
+            else if( (op == 1) && (len < 390) ) {
+                memmove(&sentence[pos + 1], &sentence[pos], len - pos);
+                sentence[pos] = "0123456789,.*$\r\nNSEW-"[rand() % 21];
+                len++;
+            }
+            else if( (op == 2) && (len > 1) ) {
+                memmove(&sentence[pos], &sentence[pos + 1], len - pos - 1);
+                len--;
+            }
+            else if(len < 300) {
+                span = rand() % 40;
+                span = (pos + span > len) ? len - pos : span;
+                memcpy(&sentence[len], &sentence[pos], span);
+                len += span;
+            }
+        }
+        // most mutations keep a valid checksum so they reach the field decoders
+        if(rand() % 4) {
+            set_checksum(sentence, len);
+        }
+
+        started = test_seconds();
+        start = test_cycles();
+        for(i = 0; i < len; i += span) {
+            span = 1 + rand() % 16;
+            span = (i + span > len) ? len - i : span;
+            gnss_nmea_queue_span(&gnss, (const uint8_t *)&sentence[i], span);
+        }
+        while(ring_buff_packet_count(&gnss.gnss_rx_buff) > 0) {
+            result = gnss_nmea_decode(&gnss);
+            CHECK(result <= 0 && result > -NMEA_FAULTS);
+            if(result <= 0 && result > -NMEA_FAULTS) {
+                results[-result]++;
+            }
+        }
+        cycles += test_cycles() - start;
+        seconds += test_seconds() - started;
+        host_tick += rand() % 1000;
+        check_published();
+    }
+
+    // the mutations reach every fault the decoder returns for a queued sentence (the parser doesn't use
+    // NMEA_PAYLOAD_OVERFLOW, the ring buffer drops a sentence that doesn't fit)
+    for(i = 0; i < NMEA_FAULTS; i++) {
+        CHECK( (results[i] > 0) || (-i == NMEA_PAYLOAD_OVERFLOW) || (-i == NMEA_EMPTY_BUFFER) );
+    }
+    report("fuzz", results, cycles, seconds);
+}
+
+// queues a capture byte by byte and decodes each sentence as it ends, BENCH_PASSES times, returning the sentences decoded
+static uint32_t bench_decoder(const char *name, uint16_t len, bool (*queue)(gnss_t *, uint8_t), int8_t (*decode)(gnss_t *)) {
+    uint32_t decoded = 0;
+    uint32_t sentences = 0;
+    uint64_t start;
+    double started;
+    uint16_t i;
+    uint8_t pass;
+
+    init();
+    started = test_seconds();
+    start = test_cycles();
+    for(pass = 0; pass < BENCH_PASSES; pass++) {
+        for(i = 0; i < len; i++) {
+            if(queue(&gnss, bench_data[i])) {
+                decoded += (decode(&gnss) == NMEA_NO_FAULT);
+                sentences++;
+            }
+        }
+    }
+    start = test_cycles() - start;
+    started = test_seconds() - started;
+    printf("parser: %-9s %.0f sentences/s, %lu cycles per sentence\n", name, sentences / started,
+           (unsigned long)(start / sentences));
+    return decoded;
+}
+
+// sentences/s and cycles per sentence of the baseline decoder and of the streaming parser over the same capture, both
+// queued a byte at a time, and of the streaming parser on its own
+static void test_parser_benchmark(void) {
+    char body[100];
+    gnss_nmea_parser_t parser;
+    gnss_fix_t fix;
+    uint32_t sentences;
+    uint32_t decoded;
+    uint64_t start;
+    double started;
+    uint16_t len = 0;
+    uint16_t epoch;
+    uint16_t i;
+    uint32_t lat;
+    uint8_t pass;
+
+    for(epoch = 0; epoch < BENCH_EPOCHS; epoch++) {
+        snprintf(body, sizeof(body), "GPGGA,15%02u%02u.00,4217.%05u,N,08343.20000,W,1,09,0.90,%u.%u,M,-34.0,M,,",
+                 30 + epoch / 60, epoch % 60, epoch * 3, 20000 + epoch * 5, epoch % 10);
+        len += build_sentence(&bench_data[len], sizeof(bench_data) - len, body);
+        len += build_sentence(&bench_data[len], sizeof(bench_data) - len, "GPGSA,A,3,23,29,07,08,09,18,26,28,,,,,1.94,1.18,1.54");
+        snprintf(body, sizeof(body), "GPRMC,15%02u%02u.00,A,4217.%05u,N,08343.20000,W,5.1,77.52,170926,,,A",
+                 30 + epoch / 60, epoch % 60, epoch * 3);
+        len += build_sentence(&bench_data[len], sizeof(bench_data) - len, body);
+        len += build_sentence(&bench_data[len], sizeof(bench_data) - len, "GPVTG,77.52,T,,M,5.1,N,9.4,K,A");
+    }
+    sentences = (uint32_t)BENCH_EPOCHS * 4 * BENCH_PASSES;
+
+    // the baseline only decodes GGA and never checks the checksum, the streaming parser publishes every sentence
+    CHECK_EQ(bench_decoder("baseline", len, &baseline_nmea_queue, &baseline_nmea_decode), sentences);
+    lat = 42 * 3600000L + 17 * 60000L;
+
+    // the baseline took the decimals of the minutes as ms
+    CHECK_EQ(gnss.last_fix.location.latitude.decMilliSec, lat + (BENCH_EPOCHS - 1) * 3);
+    CHECK_EQ(bench_decoder("streaming", len, &gnss_nmea_queue, &gnss_nmea_decode), sentences);
+    CHECK(gnss_get_fix(&gnss, &fix));
+    // 0.00001' is 0.6 ms of arc
+    CHECK_EQ(fix.location.latitude.decMilliSec, lat + (BENCH_EPOCHS - 1) * 3 * 60000L / 100000);
+
+    // the streaming parser alone, without the queue and publishing
+    decoded = 0;
+    gnss_nmea_parse_init(&parser);
+    started = test_seconds();
+    start = test_cycles();
+    for(pass = 0; pass < BENCH_PASSES; pass++) {
+        for(i = 0; i < len; i++) {
+            decoded += (gnss_nmea_parse(&parser, bench_data[i]) == NMEA_NO_FAULT);
+        }
+    }
+    start = test_cycles() - start;
+    started = test_seconds() - started;
+    CHECK_EQ(decoded, sentences);
+    printf("parser: %-9s %.0f sentences/s, %lu cycles per sentence\n", "parse", sentences / started,
+           (unsigned long)(start / sentences));
+}
+
+// decodes a capture of the receiver's output byte by byte, as received, and reports the results
+static int replay(const char *path) {
+    FILE *file = fopen(path, "rb");
+    uint32_t results[NMEA_FAULTS] = {0};
+    uint32_t bytes = 0;
+    uint64_t cycles = 0;
+    uint64_t start;
+    double seconds = 0;
+    double started;
+    bool timing = false;
+    int8_t result;
+    int datum;
+
+    if(file == NULL) {
+        printf("replay: can't open %s\n", path);
+        return 1;
+    }
+    init();
+    while((datum = fgetc(file)) != EOF) {
+        bytes++;
+
+        // timed from the first byte of each sentence to the end of its decode
+        if(!timing) {
+            started = test_seconds();
+            start = test_cycles();
+            timing = true;
+        }
+        if(!gnss_nmea_queue(&gnss, datum)) {
+            continue;
+        }
+        while(ring_buff_packet_count(&gnss.gnss_rx_buff) > 0) {
+            result = gnss_nmea_decode(&gnss);
+            CHECK(result <= 0 && result > -NMEA_FAULTS);
+            if(result <= 0 && result > -NMEA_FAULTS) {
+                results[-result]++;
+            }
+        }
+        cycles += test_cycles() - start;
+        seconds += test_seconds() - started;
+        timing = false;
+
+        // the time a byte takes at GNSS_BAUD_RATE
+        host_tick = (uint64_t)bytes * 10000 / GNSS_BAUD_RATE;
+        check_published();
+    }
+    fclose(file);
+    printf("replay: %lu bytes from %s\n", (unsigned long)bytes, path);
+    report("replay", results, cycles, seconds);
+    return TEST_RESULT();
+}
+
+
+
+
+
+// ---------------------------------------------- //
+// -------------------- main -------------------- //
+// ---------------------------------------------- //
+
+int main(int argc, char *argv[]) {
+    // test_gnss <capture> replays a capture of the receiver's output instead of running the tests
+    if(argc > 1) {
+        return replay(argv[1]);
+    }
+    test_gga();
+    test_rmc_gns_gsa_vtg();
+    test_faults();
+    test_coordinate_limits();
+    test_no_fix();
+    test_ubx_nav_pvt();
+    test_history();
+    test_task_wakeups();
+    test_publish_stress();
+    test_parser_benchmark();
+    test_fuzz();
+    return TEST_RESULT();
+}
@@ -0,0 +1,223 @@
+/*-------------------------------------------------------------------------------- /
+/ NMEA field decoder tests
+/ -------------------------------------------------------------------------------- /
+/
+/ The digit-run decoders of nmea.c on fields converted a character at a time, as
+/ the parser does: coordinates, times and fixed point values at the edges of their
+/ formats and ranges. Prints the host cycles per field of the conversion of the
+/ characters and of each decoder. nmea.c is included so its static decoders can be
+/ called, and this test is linked without nmea.o.
+/
+/ --------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include "../rtos/src/gnss/nmea.c"
+#include "test.h"
+
+#define BENCH_ITERATIONS    200000
+
+static volatile int32_t bench_sink;
+
+
+
+
+
+// ----------------------------------------------------------------- //
+// -------------------- private helper functions -------------------- //
+// ----------------------------------------------------------------- //
+
+// converts the characters of a field as the parser does
+static gnss_nmea_field_t * field_of(const char *text) {
+    static gnss_nmea_field_t field;
+
+    gnss_nmea_field_clear(&field);
+    while(*text != '\0') {
+        gnss_nmea_field_add(&field, *text++);
+    }
+    return &field;
+}
+
+static bool coordinate(const char *text, uint8_t deg_digits, uint32_t *decMilliSec) {
+    gnss_coordinate_t coord = {0, 0};
+    bool valid = gnss_nmea_field_coordinate(field_of(text), deg_digits, &coord);
+
+    *decMilliSec = coord.decMilliSec;
+    return valid;
+}
+
+static bool fixed(const char *text, uint8_t decimals, int32_t *output) {
+    return gnss_nmea_field_fixed(field_of(text), decimals, output);
+}
+
+// prints the cycles per field of the conversion of the characters
+static void bench_fields(const char *name, const char * const *texts, uint8_t count) {
+    gnss_nmea_field_t field;
+    const char *text;
+    uint64_t start;
+    uint32_t i;
+
+    start = test_cycles();
+    for(i = 0; i < BENCH_ITERATIONS; i++) {
+        gnss_nmea_field_clear(&field);
+        for(text = texts[i % count]; *text != '\0'; text++) {
+            gnss_nmea_field_add(&field, *text);
+        }
+        bench_sink = field.integer + field.fraction;
+    }
+    start = test_cycles() - start;
+    printf("nmea: %-10s %3lu cycles per field to convert the characters\n", name, (unsigned long)(start / BENCH_ITERATIONS));
+}
+
+
+
+
+
+// ----------------------------------------------- //
+// -------------------- tests -------------------- //
+// ----------------------------------------------- //
+
+// ddmm.mmmmm and dddmm.mmmmm, rounded to ms of arc and limited to 90 and 180 degrees
+static void test_coordinate(void) {
+    uint32_t value;
+
+    CHECK(coordinate("4717.11399", 2, &value));
+    CHECK_EQ(value, 170226839);
+    CHECK(coordinate("00833.91590", 3, &value));
+    CHECK_EQ(value, 30834954);
+    CHECK(coordinate("4717.1", 2, &value));
+    CHECK_EQ(value, 170226000);
+    CHECK(coordinate("0000.00001", 2, &value));
+    CHECK_EQ(value, 1);
+    CHECK(coordinate("9000.00000", 2, &value));
+    CHECK_EQ(value, 90 * GNSS_MSEC_ARC_PER_DEG);
+    CHECK(coordinate("18000.0", 3, &value));
+    CHECK_EQ(value, 180 * GNSS_MSEC_ARC_PER_DEG);
+
+    // past the pole or the antimeridian, minutes past 59, the wrong number of degree digits, no fraction, a sign
+    CHECK(!coordinate("9000.00001", 2, &value));
+    CHECK(!coordinate("8960.00000", 2, &value));
+    CHECK(!coordinate("18000.00001", 3, &value));
+    CHECK(!coordinate("04717.11399", 2, &value));
+    CHECK(!coordinate("0833.91590", 3, &value));
+    CHECK(!coordinate("4717", 2, &value));
+    CHECK(!coordinate("-4717.11399", 2, &value));
+    CHECK(!coordinate("47a7.11399", 2, &value));
+}
+
+// hhmmss.ss up to a leap second
+static void test_time(void) {
+    gnss_time_t time;
+
+    CHECK(gnss_nmea_field_time(field_of("092725.00"), &time));
+    CHECK_EQ(time.hour, 9);
+    CHECK_EQ(time.min, 27);
+    CHECK_EQ(time.msec, 25000);
+    CHECK(gnss_nmea_field_time(field_of("235960.999"), &time));
+    CHECK_EQ(time.msec, 60999);
+    CHECK(gnss_nmea_field_time(field_of("000000"), &time));
+    CHECK_EQ(time.msec, 0);
+    CHECK(gnss_nmea_field_time(field_of("120000.5"), &time));
+    CHECK_EQ(time.msec, 500);
+
+    CHECK(!gnss_nmea_field_time(field_of("240000.00"), &time));
+    CHECK(!gnss_nmea_field_time(field_of("236000.00"), &time));
+    CHECK(!gnss_nmea_field_time(field_of("235961.00"), &time));
+    CHECK(!gnss_nmea_field_time(field_of("92725.00"), &time));
+    CHECK(!gnss_nmea_field_time(field_of(""), &time));
+}
+
+// fixed point with a number of decimals, truncating further digits, within int32_t
+static void test_fixed(void) {
+    int32_t value;
+
+    CHECK(fixed("499.6", 3, &value));
+    CHECK_EQ(value, 499600);
+    CHECK(fixed("-34.0", 3, &value));
+    CHECK_EQ(value, -34000);
+    CHECK(fixed("1.019", 2, &value));
+    CHECK_EQ(value, 101);
+    CHECK(fixed("41523.7", 3, &value));
+    CHECK_EQ(value, 41523700);
+    CHECK(fixed("7", 2, &value));
+    CHECK_EQ(value, 700);
+    CHECK(fixed("2147483.647", 3, &value));
+    CHECK_EQ(value, INT32_MAX);
+
+    CHECK(!fixed("2147483.648", 3, &value));
+    CHECK(!fixed("2147484", 3, &value));
+    CHECK(!fixed("-2147483.648", 3, &value));
+    CHECK(!fixed("", 3, &value));
+    CHECK(!fixed("1.0.1", 3, &value));
+    CHECK(!fixed("M", 3, &value));
+}
+
+// host cycles per field of the conversion and of each decoder, over fields of the receiver's sentences
+static void test_benchmark(void) {
+    static const char * const latitudes[] = {"4717.11399", "4217.00297", "0000.00000", "8959.99999"};
+    static const char * const longitudes[] = {"00833.91590", "08343.20000", "17959.99999", "00000.00001"};
+    static const char * const times[] = {"092725.00", "153012.00", "235960.99", "000000.50"};
+    static const char * const values[] = {"499.6", "-34.0", "1.01", "41523.7"};
+    gnss_nmea_field_t fields[4][4];
+    gnss_coordinate_t coord;
+    gnss_time_t time;
+    int32_t value;
+    uint64_t cycles[4] = {0};
+    uint64_t start;
+    uint32_t i;
+    uint32_t valid = 0;
+    uint8_t j;
+
+    for(j = 0; j < 4; j++) {
+        fields[0][j] = *field_of(latitudes[j]);
+        fields[1][j] = *field_of(longitudes[j]);
+        fields[2][j] = *field_of(times[j]);
+        fields[3][j] = *field_of(values[j]);
+    }
+
+    // the counter is read around each call, cycles[3] is the cost of the reads alone
+    for(i = 0; i < BENCH_ITERATIONS; i++) {
+        j = i % 4;
+        start = test_cycles();
+        valid += gnss_nmea_field_coordinate(&fields[0][j], 2, &coord);
+        valid += gnss_nmea_field_coordinate(&fields[1][j], 3, &coord);
+        cycles[0] += test_cycles() - start;
+        bench_sink = coord.decMilliSec;
+
+        start = test_cycles();
+        valid += gnss_nmea_field_time(&fields[2][j], &time);
+        cycles[1] += test_cycles() - start;
+        bench_sink = time.msec;
+
+        start = test_cycles();
+        valid += gnss_nmea_field_fixed(&fields[3][j], 3, &value);
+        cycles[2] += test_cycles() - start;
+        bench_sink = value;
+
+        start = test_cycles();
+        cycles[3] += test_cycles() - start;
+    }
+    CHECK_EQ(valid, 4L * BENCH_ITERATIONS);
+    bench_fields("coordinate", latitudes, 4);
+    bench_fields("time", times, 4);
+    bench_fields("fixed", values, 4);
+    printf("nmea: %lu cycles per coordinate (in pairs), %lu per time, %lu per fixed point value to decode the field\n",
+           (unsigned long)((cycles[0] - cycles[3]) / BENCH_ITERATIONS / 2),
+           (unsigned long)((cycles[1] - cycles[3]) / BENCH_ITERATIONS),
+           (unsigned long)((cycles[2] - cycles[3]) / BENCH_ITERATIONS));
+}
+
+
+
+
+
+// ---------------------------------------------- //
+// -------------------- main -------------------- //
+// ---------------------------------------------- //
+
+int main(void) {
+    test_coordinate();
+    test_time();
+    test_fixed();
+    test_benchmark();
+    return TEST_RESULT();
+}
@@ -0,0 +1,282 @@
+/*-------------------------------------------------------------------------------- /
+/ PPS clock tests
+/ -------------------------------------------------------------------------------- /
+/
+/ Timer A0 is simulated counting at a drifting ACLK rate, with jittered PPS edges
+/ captured through the CCR3 ISR and a fix of each second: the measured rate must
+/ converge to the simulated one and time_now_utc() must follow the true time across
+/ midnight. Checks the edges captured across a timer wrap and with the tick
+/ interrupt pending, and the fixes that must not move the clock: stale or early
+/ times, a missing or old edge.
+/
+/ --------------------------------------------------------------------------------*/
+
+#include <stdlib.h>
+#include <math.h>
+#include "test.h"
+#include "host.h"
+#include <msp430.h>
+#include "gnss.h"
+
+#define PERIOD              33          // timer counts per tick, as set by vApplicationSetupTimerInterrupt()
+#define RATE_START          33751.0     // ACLK 3% fast
+#define RATE_SLOPE          -1.0        // counts per second, per second
+#define JITTER_US           20
+#define START_SEC           86340       // 23:59:00
+#define RUN_SEC             120
+#define SETTLE_SEC          20
+#define RATE_TOLERANCE      8           // counts per second, about 240 ppm
+#define TIME_TOLERANCE_US   300
+#define RANDOM_SEED         1
+
+void TIMER0_A1_ISR(void);
+
+// the object the capture ISR and time_now_utc() use
+extern gnss_t GNSS;
+
+
+
+
+
+// ----------------------------------------------------------------- //
+// -------------------- private helper functions -------------------- //
+// ----------------------------------------------------------------- //
+
+// timer counts since startup at t seconds
+static uint64_t counts_at(double t) {
+    return (uint64_t)floor(RATE_START * t + RATE_SLOPE * t * t / 2);
+}
+
+// timer counts per second at t
+static double rate_at(double t) {
+    return RATE_START + RATE_SLOPE * t;
+}
+
+// sets TA0R to the count and runs the tick interrupts up to it, the last one may be left pending
+static void timer_run(uint64_t counts, bool tick_pending) {
+    uint32_t ticks = counts / PERIOD;
+
+    TA0CCTL0 &= ~CCIFG;
+    if(tick_pending && (counts % PERIOD < PERIOD / 2) && (ticks > GNSS.pps.ticks)) {
+        TA0CCTL0 |= CCIFG;
+        ticks--;
+    }
+    while(GNSS.pps.ticks < ticks) {
+        gnss_pps_tick(&GNSS.pps);
+    }
+    TA0R = counts % PERIOD;
+}
+
+// a PPS edge at t, captured by the ISR latency counts later
+static void pps_edge(double t, uint16_t latency, bool tick_pending) {
+    uint64_t edge = counts_at(t);
+
+    TA0CCR3 = edge % PERIOD;
+    timer_run(edge + latency, tick_pending);
+    TA0IV = TA0IV_TACCR3;
+    TIMER0_A1_ISR();
+    CHECK_EQ(GNSS.pps.capture, (uint32_t)edge);
+    CHECK(GNSS.pps.captured);
+}
+
+// a fix of the second sec (since midnight), decoded at t
+static bool pps_fix(double t, int32_t sec) {
+    gnss_time_t time;
+
+    sec %= 86400;
+    time.hour = sec / 3600;
+    time.min = (sec / 60) % 60;
+    time.msec = (sec % 60) * 1000;
+    timer_run(counts_at(t), false);
+    return gnss_pps_fix(&GNSS.pps, &time);
+}
+
+// error of time_now_utc() at t in us
+static int32_t utc_error(double t) {
+    gnss_utc_t utc;
+    int64_t expected = (int64_t)llround(fmod(START_SEC + t, 86400) * 1e6);
+    int64_t error;
+
+    timer_run(counts_at(t), false);
+    CHECK(time_now_utc(&utc));
+    error = (int64_t)utc.msec * 1000 + utc.usec - expected;
+    if(error > 43200000000LL) {
+        error -= 86400000000LL;
+    }
+    else if(error < -43200000000LL) {
+        error += 86400000000LL;
+    }
+    return (int32_t)error;
+}
+
+static double jitter(void) {
+    return (rand() % (2 * JITTER_US + 1) - JITTER_US) * 1e-6;
+}
+
+// a clean start of the timer and the clock
+static void init(void) {
+    memset(&GNSS.pps, 0, sizeof(GNSS.pps));
+    gnss_pps_init(&GNSS.pps);
+    TA0CCR0 = PERIOD - 1;
+    TA0CCTL0 = 0;
+    TA0R = 0;
+}
+
+
+
+
+
+// ----------------------------------------------- //
+// -------------------- tests -------------------- //
+// ----------------------------------------------- //
+
+// the rate converges to the drifting ACLK and the clock follows UTC across midnight, with edges captured at any
+// phase of the tick
+static void test_discipline(void) {
+    gnss_utc_t utc;
+    int32_t error;
+    int32_t max_error = 0;
+    double rate_error = 0;
+    uint16_t latency;
+    uint32_t sec;
+
+    init();
+    srand(RANDOM_SEED);
+    timer_run(counts_at(0.5), false);
+    CHECK(!time_now_utc(&utc));
+    CHECK_EQ(utc.msec, -1);
+
+    for(sec = 1; sec <= RUN_SEC; sec++) {
+        // the ISR runs right away, after a timer wrap, or after a wrap with the tick interrupt still pending
+        switch(sec % 4) {
+        case 0:
+            latency = 1;
+            break;
+        case 1:
+        case 2:
+            latency = (PERIOD - counts_at(sec) % PERIOD) % PERIOD + 1;
+            break;
+        default:
+            latency = rand() % PERIOD;
+            break;
+        }
+        pps_edge(sec + jitter(), latency, sec % 4 == 2);
+        CHECK(pps_fix(sec + 0.1, START_SEC + sec));
+
+        if(sec >= SETTLE_SEC) {
+            rate_error = GNSS.pps.clock.counts_per_sec / 256.0 - rate_at(sec - 0.5);
+            CHECK(fabs(rate_error) < RATE_TOLERANCE);
+            error = utc_error(sec + 0.2);
+            max_error = (abs(error) > max_error) ? abs(error) : max_error;
+            error = utc_error(sec + 0.99);
+            max_error = (abs(error) > max_error) ? abs(error) : max_error;
+        }
+    }
+    CHECK(GNSS.pps.rate_valid);
+    CHECK(max_error < TIME_TOLERANCE_US);
+    CHECK(labs((long)(GNSS.pps.clock.counts_per_sec >> 8) - GNSS_PPS_TIMER_HZ) <= GNSS_PPS_MAX_DRIFT);
+    printf("pps: rate error %.2f counts/s (%.0f ppm), max time error %ld us\n",
+           rate_error, 1e6 * rate_error / rate_at(RUN_SEC), (long)max_error);
+}
+
+// the tick count is corrected for a pending tick interrupt only right after the wrap
+static void test_pending_tick(void) {
+    gnss_utc_t utc;
+    gnss_utc_t pending;
+    uint32_t wrap;
+
+    init();
+    pps_edge(1, 1, false);
+    CHECK(pps_fix(1.1, START_SEC + 1));
+    wrap = (counts_at(1.2) / PERIOD) * PERIOD;
+
+    // the timer wrapped, the tick interrupt hasn't run
+    timer_run(wrap + 2, true);
+    CHECK(TA0CCTL0 & CCIFG);
+    CHECK(time_now_utc(&pending));
+    timer_run(wrap + 2, false);
+    CHECK(time_now_utc(&utc));
+    CHECK_EQ(pending.msec, utc.msec);
+    CHECK_EQ(pending.usec, utc.usec);
+
+    // the flag was set after TA0R was read at the end of the period, the tick is already counted
+    timer_run(wrap + PERIOD - 1, false);
+    CHECK(time_now_utc(&utc));
+    TA0CCTL0 |= CCIFG;
+    CHECK(time_now_utc(&pending));
+    CHECK_EQ(pending.msec, utc.msec);
+    CHECK_EQ(pending.usec, utc.usec);
+
+    // an edge captured before the wrap with the tick interrupt pending
+    TA0CCR3 = PERIOD - 3;
+    timer_run(wrap + 100 * PERIOD + 1, true);
+    TA0IV = TA0IV_TACCR3;
+    TIMER0_A1_ISR();
+    CHECK_EQ(GNSS.pps.capture, wrap + 100 * PERIOD - 3);
+
+    // other timer A0 interrupts don't capture
+    GNSS.pps.captured = false;
+    TA0IV = TA0IV_TACCR1;
+    TIMER0_A1_ISR();
+    CHECK(!GNSS.pps.captured);
+}
+
+// fixes that must not move the clock: a stale or early time, a missing or old edge, a time of a fraction of a second
+static void test_rejected_fixes(void) {
+    gnss_clock_t clock;
+    gnss_time_t time = {0, 0, 500};
+    int32_t sec;
+
+    init();
+    for(sec = 1; sec <= 10; sec++) {
+        pps_edge(sec, 1, false);
+        CHECK(pps_fix(sec + 0.1, START_SEC + sec));
+    }
+    clock = GNSS.pps.clock;
+
+    // a stale fix republished with an earlier time, and a time a second ahead
+    pps_edge(11, 1, false);
+    CHECK(!pps_fix(11.1, START_SEC + 5));
+    CHECK(!GNSS.pps.captured);
+    pps_edge(12, 1, false);
+    CHECK(!pps_fix(12.1, START_SEC + 13));
+    CHECK_EQ(GNSS.pps.clock.ref_msec, clock.ref_msec);
+    CHECK_EQ(GNSS.pps.clock.ref_counts, clock.ref_counts);
+
+    // still running from the edge of second 10, within a ms after the unfiltered start of the rate
+    CHECK(abs(utc_error(12.5)) < 1000);
+
+    // no edge since the last fix, an edge more than a second before the fix
+    CHECK(!pps_fix(12.2, START_SEC + 12));
+    pps_edge(13, 1, false);
+    CHECK(!pps_fix(14.1, START_SEC + 14));
+
+    // not a whole second
+    pps_edge(15, 1, false);
+    CHECK(!gnss_pps_fix(&GNSS.pps, &time));
+    CHECK(GNSS.pps.captured);
+    CHECK(pps_fix(15.1, START_SEC + 15));
+
+    // a reference older than GNSS_PPS_MAX_INTERVAL is replaced without the check
+    clock = GNSS.pps.clock;
+    sec = 15 + GNSS_PPS_MAX_INTERVAL + 5;
+    pps_edge(sec, 1, false);
+    CHECK(pps_fix(sec + 0.1, START_SEC + sec + 3));
+    CHECK(GNSS.pps.clock.ref_msec != clock.ref_msec);
+    CHECK_EQ(GNSS.pps.clock.counts_per_sec, clock.counts_per_sec);
+}
+
+
+
+
+
+// ---------------------------------------------- //
+// -------------------- main -------------------- //
+// ---------------------------------------------- //
+
+int main(void) {
+    test_discipline();
+    test_pending_tick();
+    test_rejected_fixes();
+    return TEST_RESULT();
+}
@@ -0,0 +1,429 @@
+/*-------------------------------------------------------------------------------- /
+/ Ring buffer tests
+/ -------------------------------------------------------------------------------- /
+/
+/ Wrapping of the block and span API, zero-copy packet peeks across the end of the
+/ memory array, the packet descriptor queue, the drop-oldest policy and the
+/ read_hold handshake that keeps a packet in use from being evicted. Prints the
+/ throughput of packets moved a byte per call against a block per call.
+/
+/ --------------------------------------------------------------------------------*/
+
+#include "test.h"
+#include "ring_buff.h"
+
+#define BUFF_SIZE   16
+#define DESC_COUNT  4
+#define BENCH_SIZE  512
+#define BENCH_CHUNK 48          // bytes per packet, wraps at a different place each pass
+#define BENCH_BYTES (1UL << 23)
+
+static uint8_t memory[BUFF_SIZE];
+static uint16_t desc[DESC_COUNT];
+static uint8_t bench_memory[BENCH_SIZE];
+
+
+
+
+
+// ----------------------------------------------------------------- //
+// -------------------- private helper functions -------------------- //
+// ----------------------------------------------------------------- //
+
+static void init(ring_buff_t *buff, bool descriptors) {
+    memset(memory, 0xAA, sizeof(memory));
+    CHECK(ring_buff_init(buff, memory, BUFF_SIZE));
+    if(descriptors) {
+        CHECK(ring_buff_init_descriptors(buff, desc, DESC_COUNT));
+    }
+}
+
+// writes a finished packet of len bytes counting up from first
+static uint16_t write_packet(ring_buff_t *buff, uint8_t first, uint16_t len) {
+    uint16_t i;
+
+    for(i = 0; i < len; i++) {
+        ring_buff_write(buff, first + i);
+    }
+    return ring_buff_write_finish_packet(buff);
+}
+
+// peeks the oldest packet and checks that it counts up from first
+static void check_peek(ring_buff_t *buff, uint8_t first, uint16_t len) {
+    ring_buff_span_t span[2];
+    uint8_t data[BUFF_SIZE];
+    uint16_t i;
+
+    CHECK_EQ(ring_buff_peek_packet(buff, span), len);
+    CHECK_EQ(span[0].len + span[1].len, len);
+    memcpy(data, span[0].data, span[0].len);
+    memcpy(data + span[0].len, span[1].data, span[1].len);
+    for(i = 0; i < len; i++) {
+        CHECK_EQ(data[i], (uint8_t)(first + i));
+    }
+}
+
+
+
+
+
+// ------------------------------------------------------ //
+// -------------------- test cases -------------------- //
+// ------------------------------------------------------ //
+
+static void test_init(void) {
+    ring_buff_t buff;
+
+    CHECK(!ring_buff_init(&buff, memory, 12));
+    CHECK(!ring_buff_init(&buff, memory, 0));
+    CHECK(ring_buff_init(&buff, memory, BUFF_SIZE));
+    CHECK(!ring_buff_init_descriptors(&buff, desc, 3));
+    CHECK(!ring_buff_set_policy(&buff, RING_BUFF_DROP_OLDEST));
+    CHECK(ring_buff_init_descriptors(&buff, desc, DESC_COUNT));
+    CHECK(ring_buff_set_policy(&buff, RING_BUFF_DROP_OLDEST));
+}
+
+static void test_block_wrap(void) {
+    ring_buff_t buff;
+    uint8_t in[BUFF_SIZE];
+    uint8_t out[BUFF_SIZE];
+    uint8_t *span;
+    uint16_t i;
+
+    for(i = 0; i < BUFF_SIZE; i++) {
+        in[i] = 100 + i;
+    }
+    init(&buff, false);
+
+    // move the indices near the end of the memory array
+    CHECK(ring_buff_write_block(&buff, in, 10));
+    ring_buff_write_finish_packet(&buff);
+    CHECK_EQ(ring_buff_read_block(&buff, NULL, 10), 10);
+    ring_buff_read_finish_packet(&buff);
+
+    // one byte is always kept free
+    CHECK(!ring_buff_write_block(&buff, in, BUFF_SIZE));
+    ring_buff_write_clear_packet(&buff);
+    CHECK(ring_buff_write_block(&buff, in, BUFF_SIZE - 1));
+    CHECK(!ring_buff_write(&buff, 0));
+    ring_buff_write_clear_packet(&buff);
+    CHECK(ring_buff_write_block(&buff, in, 12));
+    CHECK_EQ(ring_buff_write_finish_packet(&buff), 12);
+    CHECK_EQ(ring_buff_available(&buff), 12);
+
+    // the span stops at the end of the memory array
+    CHECK_EQ(ring_buff_read_span(&buff, &span), 6);
+    CHECK_MEM(span, in, 6);
+    ring_buff_read_commit(&buff, 6);
+    CHECK_EQ(ring_buff_read_span(&buff, &span), 6);
+    CHECK_MEM(span, in + 6, 6);
+    ring_buff_read_clear_packet(&buff);
+
+    // a block read copies across the wrap
+    CHECK_EQ(ring_buff_read_block(&buff, out, BUFF_SIZE), 12);
+    CHECK_MEM(out, in, 12);
+    CHECK_EQ(ring_buff_read_finish_packet(&buff), 12);
+    CHECK_EQ(ring_buff_available(&buff), 0);
+}
+
+static void test_write_span(void) {
+    ring_buff_t buff;
+    uint8_t *span;
+    uint8_t out[BUFF_SIZE];
+
+    init(&buff, false);
+    CHECK_EQ(write_packet(&buff, 0, 12), 12);
+    CHECK_EQ(ring_buff_read_block(&buff, NULL, 12), 12);
+    ring_buff_read_finish_packet(&buff);
+
+    // the free region is split by the end of the memory array
+    CHECK_EQ(ring_buff_write_span(&buff, &span), 4);
+    memcpy(span, "abcd", 4);
+    ring_buff_write_commit(&buff, 4);
+    CHECK_EQ(ring_buff_write_span(&buff, &span), 11);
+    memcpy(span, "ef", 2);
+    ring_buff_write_commit(&buff, 2);
+    CHECK_EQ(ring_buff_write_finish_packet(&buff), 6);
+    CHECK_EQ(ring_buff_read_block(&buff, out, BUFF_SIZE), 6);
+    CHECK_MEM(out, "abcdef", 6);
+}
+
+static void test_unfinished_packet(void) {
+    ring_buff_t buff;
+    uint8_t datum;
+
+    init(&buff, false);
+
+    // bytes of a packet are only readable once it is finished
+    ring_buff_write(&buff, 1);
+    ring_buff_write(&buff, 2);
+    CHECK(!ring_buff_read(&buff, &datum));
+    CHECK_EQ(ring_buff_packet_count(&buff), 0);
+    ring_buff_write_finish_packet(&buff);
+    CHECK_EQ(ring_buff_packet_count(&buff), 1);
+
+    // a cleared packet never becomes readable
+    ring_buff_write(&buff, 3);
+    ring_buff_write_clear_packet(&buff);
+    CHECK(ring_buff_read(&buff, &datum));
+    CHECK_EQ(datum, 1);
+    ring_buff_read_clear_packet(&buff);
+    CHECK_EQ(ring_buff_read_block(&buff, NULL, BUFF_SIZE), 2);
+    CHECK_EQ(ring_buff_read_finish_packet(&buff), 2);
+    CHECK(!ring_buff_read(&buff, &datum));
+}
+
+static void test_peek(void) {
+    ring_buff_t buff;
+    ring_buff_span_t span[2];
+
+    // without descriptors every finished packet is returned back to back
+    init(&buff, false);
+    write_packet(&buff, 0, 3);
+    write_packet(&buff, 3, 4);
+    check_peek(&buff, 0, 7);
+    ring_buff_consume_packet(&buff, 7);
+    CHECK_EQ(ring_buff_peek_packet(&buff, span), 0);
+
+    // with descriptors only the oldest packet, including one that wraps
+    init(&buff, true);
+    CHECK_EQ(write_packet(&buff, 0, 10), 10);
+    ring_buff_consume_packet(&buff, ring_buff_peek_packet(&buff, span));
+    CHECK_EQ(write_packet(&buff, 20, 9), 9);
+    CHECK_EQ(write_packet(&buff, 40, 3), 3);
+    CHECK_EQ(ring_buff_packet_count(&buff), 2);
+    check_peek(&buff, 20, 9);
+    ring_buff_peek_packet(&buff, span);
+    CHECK_EQ(span[0].len, 6);
+    CHECK_EQ(span[1].len, 3);
+
+    // a partial consume keeps the rest of the packet
+    ring_buff_consume_packet(&buff, 4);
+    check_peek(&buff, 24, 5);
+    ring_buff_consume_packet(&buff, 5);
+    CHECK_EQ(ring_buff_packet_count(&buff), 1);
+    check_peek(&buff, 40, 3);
+    CHECK_EQ(ring_buff_skip_packet(&buff), 3);
+    CHECK_EQ(ring_buff_packet_count(&buff), 0);
+    CHECK_EQ(ring_buff_peek_packet(&buff, span), 0);
+    CHECK(!buff.read_hold);
+}
+
+static void test_descriptor_queue_full(void) {
+    ring_buff_t buff;
+    ring_buff_stats_t stats;
+
+    // DESC_COUNT - 1 packets can be pending
+    init(&buff, true);
+    CHECK_EQ(write_packet(&buff, 0, 1), 1);
+    CHECK_EQ(write_packet(&buff, 1, 1), 1);
+    CHECK_EQ(write_packet(&buff, 2, 1), 1);
+    CHECK_EQ(write_packet(&buff, 3, 2), 0);
+    ring_buff_get_stats(&buff, &stats);
+    CHECK_EQ(stats.dropped_frames, 1);
+    CHECK_EQ(stats.dropped_bytes, 2);
+    CHECK_EQ(ring_buff_packet_count(&buff), 3);
+    CHECK_EQ(ring_buff_available(&buff), 3);
+}
+
+static void test_reject_new(void) {
+    ring_buff_t buff;
+    ring_buff_stats_t stats;
+
+    init(&buff, true);
+    CHECK_EQ(write_packet(&buff, 0, 10), 10);
+
+    // the packet that doesn't fit is dropped whole, the older one is kept
+    CHECK_EQ(write_packet(&buff, 50, 8), 0);
+    ring_buff_get_stats(&buff, &stats);
+    CHECK_EQ(stats.dropped_frames, 1);
+    CHECK_EQ(stats.dropped_bytes, 8);
+    CHECK_EQ(stats.high_water, 15);
+    CHECK_EQ(ring_buff_packet_count(&buff), 1);
+    check_peek(&buff, 0, 10);
+    ring_buff_consume_packet(&buff, 10);
+
+    // the next packet is accepted again
+    CHECK_EQ(write_packet(&buff, 60, 4), 4);
+    check_peek(&buff, 60, 4);
+    ring_buff_reset_stats(&buff);
+    ring_buff_get_stats(&buff, &stats);
+    CHECK_EQ(stats.dropped_frames, 0);
+}
+
+static void test_drop_oldest(void) {
+    ring_buff_t buff;
+    ring_buff_stats_t stats;
+    uint8_t block[BUFF_SIZE] = {0};
+
+    init(&buff, true);
+    CHECK(ring_buff_set_policy(&buff, RING_BUFF_DROP_OLDEST));
+    CHECK_EQ(write_packet(&buff, 0, 5), 5);
+    CHECK_EQ(write_packet(&buff, 10, 5), 5);
+    CHECK_EQ(write_packet(&buff, 20, 5), 5);
+
+    // a full buffer evicts the oldest whole packets to make room
+    CHECK_EQ(write_packet(&buff, 30, 7), 7);
+    ring_buff_get_stats(&buff, &stats);
+    CHECK_EQ(stats.dropped_frames, 2);
+    CHECK_EQ(stats.dropped_bytes, 10);
+    CHECK_EQ(ring_buff_packet_count(&buff), 2);
+    check_peek(&buff, 20, 5);
+    ring_buff_consume_packet(&buff, 5);
+    check_peek(&buff, 30, 7);
+    ring_buff_consume_packet(&buff, 7);
+
+    // a full descriptor queue evicts too
+    ring_buff_reset_stats(&buff);
+    write_packet(&buff, 0, 1);
+    write_packet(&buff, 1, 1);
+    write_packet(&buff, 2, 1);
+    CHECK_EQ(write_packet(&buff, 3, 1), 1);
+    ring_buff_get_stats(&buff, &stats);
+    CHECK_EQ(stats.dropped_frames, 1);
+    check_peek(&buff, 1, 1);
+
+    // a packet larger than the buffer is still rejected
+    ring_buff_consume_packet(&buff, 1);
+    ring_buff_reset_stats(&buff);
+    CHECK_EQ(write_packet(&buff, 0, BUFF_SIZE), 0);
+    ring_buff_get_stats(&buff, &stats);
+    CHECK_EQ(stats.dropped_frames, 3);
+    CHECK_EQ(ring_buff_packet_count(&buff), 0);
+
+    // a block larger than the buffer is rejected before anything is evicted for it
+    write_packet(&buff, 40, 4);
+    write_packet(&buff, 50, 4);
+    ring_buff_reset_stats(&buff);
+    CHECK(!ring_buff_write_block(&buff, block, BUFF_SIZE));
+    ring_buff_get_stats(&buff, &stats);
+    CHECK_EQ(stats.dropped_frames, 0);
+    CHECK_EQ(stats.dropped_bytes, BUFF_SIZE);
+    CHECK_EQ(ring_buff_write_finish_packet(&buff), 0);
+    CHECK_EQ(ring_buff_packet_count(&buff), 2);
+    check_peek(&buff, 40, 4);
+
+    // and so is one that only fits with the bytes of the unfinished packet evicted too
+    CHECK(ring_buff_write_block(&buff, block, 4));
+    CHECK(!ring_buff_write_block(&buff, block, BUFF_SIZE - 4));
+    CHECK_EQ(ring_buff_write_finish_packet(&buff), 0);
+    CHECK_EQ(ring_buff_packet_count(&buff), 2);
+}
+
+static void test_read_hold(void) {
+    ring_buff_t buff;
+    ring_buff_span_t span[2];
+    ring_buff_stats_t stats;
+    uint8_t datum;
+
+    init(&buff, true);
+    CHECK(ring_buff_set_policy(&buff, RING_BUFF_DROP_OLDEST));
+    write_packet(&buff, 0, 6);
+    write_packet(&buff, 10, 6);
+
+    // a peeked packet can't be evicted, so the new packet is dropped instead
+    CHECK_EQ(ring_buff_peek_packet(&buff, span), 6);
+    CHECK(buff.read_hold);
+    CHECK_EQ(write_packet(&buff, 20, 6), 0);
+    ring_buff_get_stats(&buff, &stats);
+    CHECK_EQ(stats.dropped_frames, 1);
+    CHECK_EQ(stats.dropped_bytes, 6);
+    check_peek(&buff, 0, 6);
+
+    // consuming releases the hold, so eviction works again
+    ring_buff_consume_packet(&buff, 6);
+    CHECK(!buff.read_hold);
+    write_packet(&buff, 20, 6);
+    CHECK_EQ(write_packet(&buff, 30, 6), 6);
+    check_peek(&buff, 20, 6);
+    ring_buff_consume_packet(&buff, 6);
+
+    // a byte read in progress keeps the hold until the packet is finished
+    CHECK(ring_buff_read(&buff, &datum));
+    CHECK_EQ(datum, 30);
+    CHECK(buff.read_hold);
+    CHECK_EQ(ring_buff_read_block(&buff, NULL, BUFF_SIZE), 5);
+    CHECK_EQ(ring_buff_read_finish_packet(&buff), 6);
+
+    // a read of an empty buffer doesn't keep the hold
+    CHECK(!ring_buff_read(&buff, &datum));
+    CHECK(!buff.read_hold);
+    CHECK_EQ(ring_buff_peek_packet(&buff, span), 0);
+    CHECK(!buff.read_hold);
+}
+
+// bytes/s and host cycles per byte through the buffer in packets, moved a byte per call or a block per call
+static void test_benchmark(void) {
+    ring_buff_t buff;
+    uint8_t chunk[BENCH_CHUNK];
+    uint8_t datum = 0;
+    uint64_t cycles[2];
+    double seconds[2];
+    uint32_t moved[2] = {0, 0};
+    uint32_t done = 0;
+    uint16_t i;
+    uint8_t pass;
+
+    for(pass = 0; pass < 2; pass++) {
+        CHECK(ring_buff_init(&buff, bench_memory, BENCH_SIZE));
+        seconds[pass] = test_seconds();
+        cycles[pass] = test_cycles();
+        for(done = 0; done < BENCH_BYTES; done += BENCH_CHUNK) {
+            if(pass == 0) {
+                for(i = 0; i < BENCH_CHUNK; i++) {
+                    ring_buff_write(&buff, (uint8_t)i);
+                }
+                ring_buff_write_finish_packet(&buff);
+                for(i = 0; i < BENCH_CHUNK; i++) {
+                    moved[0] += ring_buff_read(&buff, &datum);
+                }
+            }
+            else {
+                ring_buff_write_block(&buff, chunk, BENCH_CHUNK);
+                ring_buff_write_finish_packet(&buff);
+                moved[1] += ring_buff_read_block(&buff, chunk, BENCH_CHUNK);
+            }
+            ring_buff_read_finish_packet(&buff);
+        }
+        cycles[pass] = test_cycles() - cycles[pass];
+        seconds[pass] = test_seconds() - seconds[pass];
+        CHECK_EQ(ring_buff_available(&buff), 0);
+
+        // the block pass moves the bytes the byte pass wrote
+        if(pass == 0) {
+            CHECK_EQ(datum, BENCH_CHUNK - 1);
+            for(i = 0; i < BENCH_CHUNK; i++) {
+                chunk[i] = (uint8_t)i;
+            }
+        }
+    }
+    CHECK_EQ(moved[0], done);
+    CHECK_EQ(moved[1], done);
+    for(i = 0; i < BENCH_CHUNK; i++) {
+        CHECK_EQ(chunk[i], (uint8_t)i);
+    }
+    printf("ring_buff: %u byte packets, byte at a time %.1f MB/s %.1f cycles/byte, blocks %.1f MB/s %.1f cycles/byte\n",
+           BENCH_CHUNK, done / seconds[0] / 1e6, (double)cycles[0] / done, done / seconds[1] / 1e6, (double)cycles[1] / done);
+}
+
+
+
+
+
+// ---------------------------------------------- //
+// -------------------- main -------------------- //
+// ---------------------------------------------- //
+
+int main(void) {
+    test_init();
+    test_block_wrap();
+    test_write_span();
+    test_unfinished_packet();
+    test_peek();
+    test_descriptor_queue_full();
+    test_reject_new();
+    test_drop_oldest();
+    test_read_hold();
+    test_benchmark();
+    return TEST_RESULT();
+}
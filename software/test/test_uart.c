@@ -0,0 +1,448 @@
+/*-------------------------------------------------------------------------------- /
+/ UART driver tests
+/ -------------------------------------------------------------------------------- /
+/
+/ Recorded bytes replayed through each RX path of the driver (RX ring buffer, RX
+/ callback, span callback staging and DMA runs), the generated USCI ISR with the
+/ receive error flags, the DMA poll wrapping around the end of its buffer, and
+/ the setup of the TX DMA channel and its transfers for USCI_A0 and USCI_A1.
+/ The baud rate generator is checked against the tables of the MSP430x5xx and
+/ MSP430x1xx family user's guides.
+/
+/ --------------------------------------------------------------------------------*/
+
+#include "test.h"
+#include "host.h"
+#include <msp430.h>
+#include <driverlib.h>
+#include "uart.h"
+
+#define RX_SIZE     64
+#define DMA_SIZE    16
+#define MAX_SPANS   8
+#define DESC_COUNT  32
+#define TX_SIZE     16
+
+void USCI_A2_ISR(void);
+void DMA_ISR(void);
+
+// spans handed to the span callback, in order
+typedef struct {
+    uint8_t data[RX_SIZE];
+    uint16_t len[MAX_SPANS];
+    uint16_t total;
+    uint8_t count;
+} spans_t;
+
+static uint8_t rx_memory[RX_SIZE];
+static uint16_t rx_desc[DESC_COUNT];
+static uint8_t dma_memory[DMA_SIZE];
+static ring_buff_t rx_buff;
+static spans_t spans;
+static uint8_t bytes[RX_SIZE];
+static uint16_t byte_count;
+static uint8_t tx_memory[TX_SIZE];
+static ring_buff_t tx_buff;
+static uint8_t tx_done;
+
+
+
+
+
+// ----------------------------------------------------------------- //
+// -------------------- private helper functions -------------------- //
+// ----------------------------------------------------------------- //
+
+static void rx_callback(void *params, uint8_t datum) {
+    CHECK(params == &byte_count);
+    if(byte_count < RX_SIZE) {
+        bytes[byte_count++] = datum;
+    }
+}
+
+static void span_callback(void *params, const uint8_t *data, uint16_t len) {
+    spans_t *s = params;
+
+    CHECK(s->count < MAX_SPANS && s->total + len <= RX_SIZE);
+    if(s->count < MAX_SPANS && s->total + len <= RX_SIZE) {
+        memcpy(&s->data[s->total], data, len);
+        s->len[s->count++] = len;
+        s->total += len;
+    }
+}
+
+// configures a port at 9600 baud from a 16 MHz SMCLK with an RX ring buffer of packets and no callbacks
+static UARTConfig * init_port(UART_MODULE_NAMES module, ring_buff_t *tx) {
+    UARTConfig cfg = {0};
+    UARTConfig *port = (module == USCI_A0) ? &USCI_A0_cnf : (module == USCI_A1) ? &USCI_A1_cnf : &USCI_A2_cnf;
+
+    cfg.moduleName = module;
+    cfg.portNum = (module == USCI_A0) ? PORT_3 : (module == USCI_A1) ? PORT_5 : PORT_9;
+    cfg.TxPinNum = (module == USCI_A1) ? PIN6 : PIN4;
+    cfg.RxPinNum = (module == USCI_A1) ? PIN7 : PIN5;
+    cfg.clkRate = 16000000;
+    cfg.baudRate = 9600;
+    cfg.clkSrc = UART_CLK_SRC_SMCLK;
+    cfg.databits = 8;
+    cfg.stopbits = 1;
+    cfg.parity = UART_PARITY_NONE;
+
+    CHECK(ring_buff_init(&rx_buff, rx_memory, RX_SIZE));
+    CHECK(ring_buff_init_descriptors(&rx_buff, rx_desc, DESC_COUNT));
+    memset(&spans, 0, sizeof(spans));
+    byte_count = 0;
+    CHECK_EQ(initUSCIUart(&cfg, tx, &rx_buff), UART_SUCCESS);
+    return port;
+}
+
+// computes the baud rate generator settings of a USCI or USART module with 8N1 frames
+static int calc_baud(UART_MODULE_NAMES module, unsigned long clk, unsigned long baud, UARTBaudRegs *regs) {
+    UARTConfig cfg = {0};
+
+    cfg.moduleName = module;
+    cfg.clkRate = clk;
+    cfg.baudRate = baud;
+    cfg.databits = 8;
+    cfg.stopbits = 1;
+    cfg.parity = UART_PARITY_NONE;
+    return uartCalcBaudRate(&cfg, regs);
+}
+
+static void tx_done_callback(void *params) {
+    CHECK(params == &tx_done);
+    tx_done++;
+}
+
+// receives a byte through the USCI_A2 ISR with the given status flags
+static void receive_a2(uint8_t datum, uint8_t stat) {
+    UCA2IV = 2;
+    UCA2STAT = stat;
+    UCA2RXBUF = datum;
+    USCI_A2_ISR();
+}
+
+// lets the DMA write len bytes to the circular buffer, continuing from where it stopped
+static void dma_receive(const char *data, uint16_t len) {
+    uint16_t write_idx = DMA_SIZE - host_dma_size[0];
+    uint16_t i;
+
+    for(i = 0; i < len; i++) {
+        dma_memory[write_idx] = data[i];
+        write_idx = (write_idx + 1) % DMA_SIZE;
+    }
+    host_dma_size[0] = DMA_SIZE - write_idx;
+}
+
+
+
+
+
+// ----------------------------------------------- //
+// -------------------- tests -------------------- //
+// ----------------------------------------------- //
+
+// without callbacks every byte is a finished packet of the RX ring buffer
+static void test_replay_ring_buff(void) {
+    UARTConfig *port = init_port(USCI_A2, NULL);
+    UARTStats stats;
+    uint8_t data[RX_SIZE];
+
+    CHECK(UCA2IE & UCRXIE);
+    CHECK_EQ(uartReplayRx(port, (const unsigned char *)"$GP", 3), 3);
+    CHECK_EQ(uartReplayRx(port, (const unsigned char *)"x", 0), 0);
+    CHECK_EQ(ring_buff_packet_count(&rx_buff), 3);
+    CHECK_EQ(ring_buff_read_block(&rx_buff, data, RX_SIZE), 3);
+    CHECK_MEM(data, "$GP", 3);
+
+    uartGetStats(port, &stats);
+    CHECK_EQ(stats.rxBytes, 3);
+    CHECK_EQ(stats.overrunErrors + stats.framingErrors + stats.parityErrors, 0);
+}
+
+// the RX callback takes priority over the ring buffer
+static void test_replay_callback(void) {
+    UARTConfig *port = init_port(USCI_A2, NULL);
+
+    initUartRxCallback(port, rx_callback, &byte_count);
+    CHECK_EQ(uartReplayRx(port, (const unsigned char *)"\xB5\x62\x01\x07", 4), 4);
+    CHECK_EQ(byte_count, 4);
+    CHECK_MEM(bytes, "\xB5\x62\x01\x07", 4);
+    CHECK_EQ(ring_buff_packet_count(&rx_buff), 0);
+}
+
+// the span callback gets a span per terminator or per maxLen bytes, and takes priority over the RX callback
+static void test_replay_span(void) {
+    UARTConfig *port = init_port(USCI_A2, NULL);
+    const char *sentence = "$GPGGA,1*5A\r\n";
+
+    initUartRxCallback(port, rx_callback, &byte_count);
+    initUartRxSpanCallback(port, span_callback, &spans, "\n", 8);
+    CHECK_EQ(uartReplayRx(port, (const unsigned char *)sentence, strlen(sentence)), strlen(sentence));
+    CHECK_EQ(spans.count, 2);
+    CHECK_EQ(spans.len[0], 8);
+    CHECK_EQ(spans.len[1], 5);
+    CHECK_MEM(spans.data, sentence, strlen(sentence));
+    CHECK_EQ(byte_count, 0);
+
+    // bytes after the last terminator stay staged until the next one
+    CHECK_EQ(uartReplayRx(port, (const unsigned char *)"$G", 2), 2);
+    CHECK_EQ(spans.count, 2);
+    CHECK_EQ(port->rxStageLen, 2);
+    CHECK_EQ(uartReplayRx(port, (const unsigned char *)"\n", 1), 1);
+    CHECK_EQ(spans.count, 3);
+    CHECK_EQ(spans.len[2], 3);
+    CHECK_MEM(&spans.data[13], "$G\n", 3);
+
+    // a maxLen above the staging buffer is limited to it
+    initUartRxSpanCallback(port, span_callback, &spans, NULL, 0xFF);
+    CHECK_EQ(port->rxStageMax, UART_RX_STAGE_SIZE);
+}
+
+// the TX DMA channel of USCI_A0 and USCI_A1: its trigger and destination, and the source and size of each transfer
+static void test_tx_dma(void) {
+    static const struct {
+        UART_MODULE_NAMES module;
+        uint8_t channel;
+        uint8_t trigger;
+        volatile unsigned char *txbuf;
+    } ports[] = {
+        {USCI_A0, DMA_CHANNEL_2, DMA_TRIGGERSOURCE_17, &UCA0TXBUF},
+        {USCI_A1, DMA_CHANNEL_0, DMA_TRIGGERSOURCE_21, &UCA1TXBUF},
+    };
+    const unsigned char *message = (const unsigned char *)"$PUBX,40,GSV";
+    host_dma_channel_t *dma;
+    UARTConfig *port;
+    UARTStats stats;
+    uint8_t i;
+
+    for(i = 0; i < sizeof(ports) / sizeof(ports[0]); i++) {
+        CHECK(ring_buff_init(&tx_buff, tx_memory, TX_SIZE));
+        port = init_port(ports[i].module, &tx_buff);
+        dma = &host_dma[ports[i].channel >> 4];
+        memset(dma, 0, sizeof(*dma));
+        CHECK_EQ(initUartTxDma(port, ports[i].channel), UART_SUCCESS);
+        CHECK_EQ(dma->trigger, ports[i].trigger);
+        CHECK_EQ(dma->mode, DMA_TRANSFER_SINGLE);
+        CHECK_EQ(dma->unit, DMA_SIZE_SRCBYTE_DSTBYTE);
+        CHECK_EQ(dma->trigger_type, DMA_TRIGGER_RISINGEDGE);
+        CHECK_EQ(dma->dst, (uint32_t)(uintptr_t)ports[i].txbuf);
+        CHECK_EQ(dma->dst_dir, DMA_DIRECTION_UNCHANGED);
+        CHECK(dma->interrupt);
+        CHECK(!dma->enabled);
+
+        // a caller buffer is sent in place, one transfer at a time
+        tx_done = 0;
+        CHECK_EQ(uartSendDataDma(port, message, 12, tx_done_callback, &tx_done), UART_SUCCESS);
+        CHECK_EQ(dma->src, (uint32_t)(uintptr_t)message);
+        CHECK_EQ(dma->src_dir, DMA_DIRECTION_INCREMENT);
+        CHECK_EQ(host_dma_size[ports[i].channel >> 4], 12);
+        CHECK(dma->enabled);
+        CHECK_EQ(uartSendDataDma(port, message, 12, tx_done_callback, &tx_done), UART_TX_BUSY);
+        DMAIV = 2 * ((ports[i].channel >> 4) + 1);
+        DMA_ISR();
+        CHECK_EQ(tx_done, 1);
+        CHECK(!port->txDmaBusy);
+
+        // the ring buffer is sent a contiguous span at a time, so a wrapped packet takes two transfers
+        CHECK_EQ(uartSendDataInt(port, (unsigned char *)message, 12), UART_SUCCESS);
+        CHECK_EQ(dma->src, (uint32_t)(uintptr_t)tx_memory);
+        CHECK_EQ(host_dma_size[ports[i].channel >> 4], 12);
+        DMA_ISR();
+        CHECK_EQ(uartSendDataInt(port, (unsigned char *)message, 8), UART_SUCCESS);
+        CHECK_EQ(dma->src, (uint32_t)(uintptr_t)&tx_memory[12]);
+        CHECK_EQ(host_dma_size[ports[i].channel >> 4], 4);
+        DMA_ISR();
+        CHECK_EQ(dma->src, (uint32_t)(uintptr_t)tx_memory);
+        CHECK_EQ(host_dma_size[ports[i].channel >> 4], 4);
+        DMA_ISR();
+        CHECK(!port->txDmaBusy);
+        CHECK_EQ(ring_buff_available(&tx_buff), 0);
+        uartGetStats(port, &stats);
+        CHECK_EQ(stats.txBytes, 12 + 12 + 8);
+    }
+
+    // only USCI_A0 and USCI_A1 trigger DMA transfers, on one of three channels
+    CHECK_EQ(initUartTxDma(init_port(USCI_A2, NULL), DMA_CHANNEL_1), UART_DMA_UNSUPPORTED);
+    CHECK_EQ(initUartTxDma(init_port(USCI_A0, NULL), 0x30), UART_DMA_UNSUPPORTED);
+}
+
+// the ISR counts receive errors, keeps the byte of an overrun and discards framing and parity errors
+static void test_isr_errors(void) {
+    UARTConfig *port = init_port(USCI_A2, NULL);
+    UARTStats stats;
+
+    initUartRxCallback(port, rx_callback, &byte_count);
+    receive_a2('a', 0);
+    receive_a2('b', UCOE);
+    receive_a2('c', UCFE);
+    receive_a2('d', UCPE);
+    receive_a2('e', UCOE | UCFE);
+    receive_a2('f', 0);
+
+    // no interrupt and TX vectors don't receive anything
+    UCA2IV = 0;
+    USCI_A2_ISR();
+
+    CHECK_EQ(byte_count, 3);
+    CHECK_MEM(bytes, "abf", 3);
+    uartGetStats(port, &stats);
+    CHECK_EQ(stats.rxBytes, 3);
+    CHECK_EQ(stats.overrunErrors, 2);
+    CHECK_EQ(stats.framingErrors, 2);
+    CHECK_EQ(stats.parityErrors, 1);
+
+    uartResetStats(port);
+    uartGetStats(port, &stats);
+    CHECK_EQ(stats.rxBytes + stats.overrunErrors + stats.framingErrors + stats.parityErrors, 0);
+}
+
+// DMA ports hand the span callback runs of the circular buffer, at most two per poll
+static void test_dma_poll(void) {
+    UARTConfig *port = init_port(USCI_A0, NULL);
+    UARTStats stats;
+
+    initUartRxSpanCallback(port, span_callback, &spans, "\n", 0);
+    CHECK_EQ(initUartDmaRx(port, DMA_CHANNEL_0, dma_memory, DMA_SIZE), UART_SUCCESS);
+    CHECK_EQ(host_dma_size[0], DMA_SIZE);
+    CHECK(!(UCA0IE & UCRXIE));
+    CHECK_EQ(uartDmaRxPoll(port), 0);
+
+    // a contiguous run, terminators don't split it
+    dma_receive("$GP\n$GN", 7);
+    CHECK_EQ(uartDmaRxPoll(port), 7);
+    CHECK_EQ(spans.count, 1);
+    CHECK_EQ(spans.len[0], 7);
+
+    // a run wrapping around the end of the buffer is handed out in two parts
+    dma_receive("GGA,12345678", 12);
+    CHECK_EQ(uartDmaRxPoll(port), 12);
+    CHECK_EQ(spans.count, 3);
+    CHECK_EQ(spans.len[1], DMA_SIZE - 7);
+    CHECK_EQ(spans.len[2], 12 - (DMA_SIZE - 7));
+    CHECK_MEM(spans.data, "$GP\n$GNGGA,12345678", 19);
+
+    // ending exactly at the end of the buffer, the DMA reloads the full size
+    dma_receive("ABCDEFGHIJKLM", DMA_SIZE - 3);
+    CHECK_EQ(host_dma_size[0], DMA_SIZE);
+    CHECK_EQ(uartDmaRxPoll(port), DMA_SIZE - 3);
+    CHECK_EQ(spans.count, 4);
+    CHECK_EQ(port->rxDmaReadIdx, 0);
+
+    uartGetStats(port, &stats);
+    CHECK_EQ(stats.rxBytes, 7 + 12 + DMA_SIZE - 3);
+
+    // a replay on a DMA port is a single run
+    CHECK_EQ(uartReplayRx(port, (const unsigned char *)"$GPRMC,\r\n", 9), 9);
+    CHECK_EQ(spans.count, 5);
+    CHECK_EQ(spans.len[4], 9);
+}
+
+// DMA ports without a span callback dispatch the bytes one at a time
+static void test_dma_poll_bytes(void) {
+    UARTConfig *port = init_port(USCI_A0, NULL);
+    uint8_t data[RX_SIZE];
+
+    CHECK_EQ(initUartDmaRx(port, DMA_CHANNEL_0, dma_memory, DMA_SIZE), UART_SUCCESS);
+    dma_receive("0123456789", 10);
+    CHECK_EQ(uartDmaRxPoll(port), 10);
+    dma_receive("abcdefghij", 10);
+    CHECK_EQ(uartDmaRxPoll(port), 10);
+    CHECK_EQ(ring_buff_read_block(&rx_buff, data, RX_SIZE), 20);
+    CHECK_MEM(data, "0123456789abcdefghij", 20);
+
+    // only USCI_A0 and USCI_A1 can trigger DMA transfers
+    CHECK_EQ(initUartDmaRx(init_port(USCI_A2, NULL), DMA_CHANNEL_1, dma_memory, DMA_SIZE), UART_DMA_UNSUPPORTED);
+}
+
+// USCI settings match the user's guide tables, in both oversampling and low frequency mode
+static void test_baud_rate(void) {
+    // clock, baud rate, UCOS16, UCBRx, UCBRSx, UCBRFx
+    static const struct {
+        unsigned long clk;
+        unsigned long baud;
+        bool oversampling;
+        uint16_t brx;
+        uint8_t brs;
+        uint8_t brf;
+    } table[] = {
+        {16000000,   9600, true,  104, 0,  3},
+        {16000000,  57600, true,   17, 0,  6},
+        {16000000, 115200, true,    8, 0, 11},
+        { 1000000,   9600, true,    6, 0,  8},
+        { 1048576,   9600, true,    6, 0, 13},
+        { 1000000, 115200, false,   8, 6,  0},
+        {   32768,   2400, false,  13, 6,  0},
+        {   32768,   4800, false,   6, 7,  0},
+        {   32768,   9600, false,   3, 3,  0},
+    };
+    UARTBaudRegs regs;
+    uint8_t i;
+
+    for(i = 0; i < sizeof(table) / sizeof(table[0]); i++) {
+        CHECK_EQ(calc_baud(USCI_A0, table[i].clk, table[i].baud, &regs), UART_SUCCESS);
+        CHECK_EQ(regs.oversampling, table[i].oversampling);
+        CHECK_EQ(regs.brx, table[i].brx);
+        CHECK_EQ(regs.brs, table[i].brs);
+        CHECK_EQ(regs.brf, table[i].brf);
+    }
+
+    // the frame error is small for an exact divider and large for 3.4 clocks per bit
+    CHECK_EQ(calc_baud(USCI_A0, 16000000, 1000000, &regs), UART_SUCCESS);
+    CHECK_EQ(regs.errorPermille, 0);
+    CHECK_EQ(calc_baud(USCI_A0, 16000000, 9600, &regs), UART_SUCCESS);
+    CHECK(regs.errorPermille <= 5);
+    CHECK_EQ(calc_baud(USCI_A0, 32768, 9600, &regs), UART_SUCCESS);
+    CHECK(regs.errorPermille > 100);
+
+    // USART modulation pattern of the MSP430x1xx user's guide
+    CHECK_EQ(calc_baud(USART_0, 32768, 9600, &regs), UART_SUCCESS);
+    CHECK_EQ(regs.brx, 3);
+    CHECK_EQ(regs.umctl, 0x4A);
+
+    // fewer than 3 clocks per bit or a prescaler that doesn't fit in 16 bits
+    CHECK_EQ(calc_baud(USCI_A0, 32768, 19200, &regs), UART_BAD_BAUD_RATE);
+    CHECK_EQ(calc_baud(USCI_A0, 16000000, 200, &regs), UART_BAD_BAUD_RATE);
+    CHECK_EQ(calc_baud(USCI_A0, 16000000, 0, &regs), UART_BAD_BAUD_RATE);
+    CHECK_EQ(calc_baud(USART_1, 32768, 19200, &regs), UART_BAD_BAUD_RATE);
+}
+
+// the settings are written to the module registers, and a bad baud rate fails the init
+static void test_baud_registers(void) {
+    UARTConfig cfg = {0};
+    UARTConfig *port = init_port(USCI_A2, NULL);
+
+    CHECK_EQ(UCA2BR0, 104);
+    CHECK_EQ(UCA2BR1, 0);
+    CHECK_EQ(UCA2MCTL, (3 << 4) | (0 << 1) | UCOS16);
+    CHECK(!(UCA2CTL1 & UCSWRST));
+    CHECK(port->baudError <= 5);
+
+    cfg = *port;
+    cfg.baudRate = 19200;
+    cfg.clkRate = 32768;
+    cfg.clkSrc = UART_CLK_SRC_ACLK;
+    CHECK_EQ(initUSCIUart(&cfg, NULL, &rx_buff), UART_UNKNOWN);
+    CHECK(UCA2CTL1 & UCSWRST);
+}
+
+
+
+
+
+// ---------------------------------------------- //
+// -------------------- main -------------------- //
+// ---------------------------------------------- //
+
+int main(void) {
+    initUartDriver();
+    test_replay_ring_buff();
+    test_replay_callback();
+    test_replay_span();
+    test_isr_errors();
+    test_dma_poll();
+    test_tx_dma();
+    test_dma_poll_bytes();
+    test_baud_rate();
+    test_baud_registers();
+    return TEST_RESULT();
+}
@@ -0,0 +1,279 @@
+/*-------------------------------------------------------------------------------- /
+/ UART stream tests
+/ -------------------------------------------------------------------------------- /
+/
+/ The blocking stream on top of the UART driver with bytes arriving while the task
+/ is blocked: a read wakes up at the trigger level, or as soon as its own bytes are
+/ there if it asks for fewer, and times out without them. Prints the task wake-ups
+/ per KB received for each trigger level. uartSendDataTask() through the TX ISR:
+/ completion, timeout and abort, a port held by another sender, and a notification
+/ left over from an earlier send.
+/
+/ --------------------------------------------------------------------------------*/
+
+#include "test.h"
+#include "host.h"
+#include <msp430.h>
+#include <driverlib.h>
+#include "uart.h"
+#include "uart_stream.h"
+
+#define STREAM_SIZE     256
+#define KB              1024
+#define TX_LEN          20
+
+void USCI_A2_ISR(void);
+
+static uint8_t stream_memory[STREAM_SIZE];
+static UARTStream stream;
+
+// bytes received while the task is blocked, see rx_hook()
+static uint8_t rx_data[KB];
+static uint16_t rx_len;
+static uint16_t rx_pos;
+
+// bytes sent by the TX ISR while the task is blocked, see tx_hook()
+static uint8_t tx_data[TX_LEN * 2];
+static uint16_t tx_count;
+
+
+
+
+
+// ----------------------------------------------------------------- //
+// -------------------- private helper functions -------------------- //
+// ----------------------------------------------------------------- //
+
+// configures USCI_A2 at 9600 baud from a 16 MHz SMCLK without buffers
+static UARTConfig * init_port(void) {
+    UARTConfig cfg = {0};
+
+    cfg.moduleName = USCI_A2;
+    cfg.portNum = PORT_9;
+    cfg.TxPinNum = PIN4;
+    cfg.RxPinNum = PIN5;
+    cfg.clkRate = 16000000;
+    cfg.baudRate = 9600;
+    cfg.clkSrc = UART_CLK_SRC_SMCLK;
+    cfg.databits = 8;
+    cfg.stopbits = 1;
+    cfg.parity = UART_PARITY_NONE;
+    CHECK_EQ(initUSCIUart(&cfg, NULL, NULL), UART_SUCCESS);
+    return &USCI_A2_cnf;
+}
+
+// stands in for the line while the task is blocked: a byte per tick (about 9600 baud) until a notification wakes
+// the task, the bytes run out or the task times out
+static void rx_hook(TickType_t ticks) {
+    TickType_t elapsed = 0;
+
+    while( (host_notify == 0) && (rx_pos < rx_len) && (elapsed < ticks) ) {
+        uartReplayRx(&USCI_A2_cnf, &rx_data[rx_pos++], 1);
+        elapsed++;
+    }
+    if(host_notify > 0) {
+        host_tick += elapsed;
+    }
+}
+
+// stands in for the line while the task is blocked: the TX ISR runs a byte per tick until the notification of the
+// finished send wakes the task, the module is idle or the task times out
+static void tx_hook(TickType_t ticks) {
+    TickType_t elapsed = 0;
+    uint32_t sent;
+
+    while( (host_notify == 0) && (UCA2IE & UCTXIE) && (elapsed < ticks) ) {
+        sent = USCI_A2_cnf.stats.txBytes;
+        UCA2IV = 4;
+        USCI_A2_ISR();
+        if( (USCI_A2_cnf.stats.txBytes != sent) && (tx_count < sizeof(tx_data)) ) {
+            tx_data[tx_count++] = UCA2TXBUF;
+            elapsed++;
+        }
+    }
+    host_tick += (host_notify > 0) ? elapsed : 0;
+}
+
+// resets the line and the task's notifications for a send
+static void tx_start(void (*hook)(TickType_t ticks)) {
+    tx_count = 0;
+    host_tick = 0;
+    host_notify = 0;
+    host_wakeups = 0;
+    host_blocked_hook = hook;
+}
+
+// queues len bytes counting up from first to arrive while the task is blocked
+static void rx_queue(uint8_t first, uint16_t len) {
+    uint16_t i;
+
+    for(i = 0; i < len; i++) {
+        rx_data[i] = first + i;
+    }
+    rx_len = len;
+    rx_pos = 0;
+    host_tick = 0;
+    host_notify = 0;
+    host_wakeups = 0;
+    host_blocked_hook = &rx_hook;
+}
+
+
+
+
+
+// ----------------------------------------------- //
+// -------------------- tests -------------------- //
+// ----------------------------------------------- //
+
+// a read wakes up once at the trigger level, and a shorter read as soon as its own bytes are there
+static void test_receive_trigger(void) {
+    UARTConfig *port = init_port();
+    uint8_t buf[64];
+
+    CHECK_EQ(uartStreamInit(&stream, port, stream_memory, STREAM_SIZE, 16), UART_SUCCESS);
+
+    rx_queue(0, 36);
+    CHECK_EQ(uartStreamReceive(&stream, buf, sizeof(buf), 1000), 16);
+    CHECK_EQ(host_wakeups, 1);
+    CHECK_EQ(host_tick, 16);
+    CHECK_EQ(buf[0], 0);
+    CHECK_EQ(buf[15], 15);
+    CHECK(stream.rxTask == NULL);
+
+    // 4 bytes wanted below the trigger level of 16
+    CHECK_EQ(uartStreamReceive(&stream, buf, 4, 1000), 4);
+    CHECK_EQ(host_wakeups, 2);
+    CHECK_EQ(host_tick, 20);
+    CHECK_EQ(buf[0], 16);
+
+    // bytes that are already there are read without blocking
+    rx_hook(4);
+    CHECK_EQ(uartStreamReceive(&stream, buf, 4, 1000), 4);
+    CHECK_EQ(host_wakeups, 2);
+    CHECK_EQ(buf[0], 20);
+
+    // fewer bytes than wanted arrive before the timeout
+    CHECK_EQ(uartStreamReceive(&stream, buf, sizeof(buf), 100), 12);
+    CHECK_EQ(host_wakeups, 2);
+    CHECK_EQ(host_tick, 120);
+    CHECK_EQ(buf[0], 24);
+    CHECK_EQ(uartStreamReceive(&stream, buf, sizeof(buf), 100), 0);
+    host_blocked_hook = NULL;
+}
+
+// task wake-ups per KB received at each trigger level, reading up to 64 bytes at a time
+static void test_wakeups_per_kb(void) {
+    UARTConfig *port = init_port();
+    const uint16_t triggers[] = {1, 8, 32, 64};
+    uint8_t buf[64];
+    uint16_t received;
+    uint8_t i;
+
+    for(i = 0; i < sizeof(triggers) / sizeof(triggers[0]); i++) {
+        CHECK_EQ(uartStreamInit(&stream, port, stream_memory, STREAM_SIZE, triggers[i]), UART_SUCCESS);
+        rx_queue(0, KB);
+        received = 0;
+        while(received < KB) {
+            received += uartStreamReceive(&stream, buf, sizeof(buf), 1000);
+        }
+        CHECK_EQ(received, KB);
+        CHECK_EQ(host_wakeups, KB / triggers[i]);
+        CHECK_EQ(host_tick, KB);
+        printf("stream: trigger %2u, %4lu wake-ups per KB\n", triggers[i], (unsigned long)host_wakeups);
+    }
+    host_blocked_hook = NULL;
+}
+// a send sleeps until the TX ISR reports the end of the buffer
+static void test_send_complete(void) {
+    const char *message = "$PUBX,40,GSV,0,0,0*59";
+    UARTConfig *port = init_port();
+
+    tx_start(&tx_hook);
+    CHECK_EQ(uartSendDataTask(port, (const unsigned char *)message, TX_LEN, 100), UART_SUCCESS);
+    CHECK_EQ(tx_count, TX_LEN);
+    CHECK_MEM(tx_data, message, TX_LEN);
+    CHECK_EQ(host_wakeups, 1);
+    CHECK_EQ(host_tick, TX_LEN);
+    CHECK(port->txIntBuf == NULL);
+    CHECK_EQ(uartSendDataTask(port, (const unsigned char *)message, 0, 100), UART_SUCCESS);
+    host_blocked_hook = NULL;
+}
+
+// a send that doesn't finish in time is stopped, so the buffer can go out of scope
+static void test_send_timeout(void) {
+    const char *message = "$PUBX,40,GSV,0,0,0*59";
+    UARTConfig *port = init_port();
+
+    // the TX interrupt never runs
+    tx_start(NULL);
+    CHECK_EQ(uartSendDataTask(port, (const unsigned char *)message, TX_LEN, 50), UART_TX_BUSY);
+    CHECK_EQ(host_tick, 50);
+    CHECK(port->txIntBuf == NULL);
+    CHECK(port->txDoneCallback == NULL);
+
+    // the ISR doesn't read the aborted buffer afterwards
+    tx_hook(TX_LEN);
+    CHECK_EQ(tx_count, 0);
+    CHECK(!(UCA2IE & UCTXIE));
+
+    // the port is free for the next send
+    tx_start(&tx_hook);
+    CHECK_EQ(uartSendDataTask(port, (const unsigned char *)message, TX_LEN, 50), UART_SUCCESS);
+    CHECK_EQ(tx_count, TX_LEN);
+    host_blocked_hook = NULL;
+}
+
+// a port busy with another caller buffer is waited for a tick at a time, without stopping the other send
+static void test_send_busy(void) {
+    const char *other = "0123456789";
+    const char *message = "$PUBX,40,GSV,0,0,0*59";
+    UARTConfig *port = init_port();
+
+    tx_start(NULL);
+    CHECK_EQ(uartSendDataAsync(port, (const unsigned char *)other, 10, NULL, NULL), UART_SUCCESS);
+    CHECK_EQ(uartSendDataTask(port, (const unsigned char *)message, TX_LEN, 30), UART_TX_BUSY);
+    CHECK_EQ(host_tick, 30);
+    CHECK(port->txIntBuf == (const unsigned char *)other);
+
+    // the other buffer is sent while waiting for the port, then this one
+    tx_start(&tx_hook);
+    CHECK_EQ(uartSendDataTask(port, (const unsigned char *)message, TX_LEN, 100), UART_SUCCESS);
+    CHECK_EQ(tx_count, 10 + TX_LEN);
+    CHECK_MEM(tx_data, other, 10);
+    CHECK_MEM(&tx_data[10], message, TX_LEN);
+    host_blocked_hook = NULL;
+}
+
+// a notification left over from an earlier send doesn't end the next one before it is sent
+static void test_send_stale_notification(void) {
+    const char *message = "$PUBX,40,GSV,0,0,0*59";
+    UARTConfig *port = init_port();
+
+    tx_start(&tx_hook);
+    host_notify = 1;
+    CHECK_EQ(uartSendDataTask(port, (const unsigned char *)message, TX_LEN, 100), UART_SUCCESS);
+    CHECK_EQ(tx_count, TX_LEN);
+    CHECK_EQ(host_notify, 0);
+    CHECK(port->txIntBuf == NULL);
+    host_blocked_hook = NULL;
+}
+
+
+
+
+
+// ---------------------------------------------- //
+// -------------------- main -------------------- //
+// ---------------------------------------------- //
+
+int main(void) {
+    initUartDriver();
+    test_receive_trigger();
+    test_wakeups_per_kb();
+    test_send_complete();
+    test_send_timeout();
+    test_send_busy();
+    test_send_stale_notification();
+    return TEST_RESULT();
+}